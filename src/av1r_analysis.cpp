@@ -0,0 +1,243 @@
+// Pre-encode frame analysis: SAD against the previous frame.
+// SSE2 (x86/x86-64) или NEON (aarch64), иначе скалярный fallback.
+// Не зависит от Vulkan — компилируется всегда.
+
+#include "av1r_analysis.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define AV1R_SAD_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define AV1R_SAD_NEON 1
+#endif
+
+// Размер блока между проверками limit: early exit на сильно отличающихся кадрах
+static const size_t SAD_CHUNK = 16384;
+
+static uint64_t sad_scalar(const uint8_t* a, const uint8_t* b, size_t n) {
+    uint64_t s = 0;
+    for (size_t i = 0; i < n; i++)
+        s += static_cast<uint64_t>(std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i])));
+    return s;
+}
+
+#if defined(AV1R_SAD_SSE2)
+static uint64_t sad_block(const uint8_t* a, const uint8_t* b, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m128i s0 = _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+        __m128i s1 = _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + 16)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + 16)));
+        __m128i s2 = _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + 32)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + 32)));
+        __m128i s3 = _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + 48)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + 48)));
+        acc = _mm_add_epi64(acc, _mm_add_epi64(_mm_add_epi64(s0, s1), _mm_add_epi64(s2, s3)));
+    }
+    for (; i + 16 <= n; i += 16) {
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+    }
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return lanes[0] + lanes[1] + sad_scalar(a + i, b + i, n - i);
+}
+#elif defined(AV1R_SAD_NEON)
+static uint64_t sad_block(const uint8_t* a, const uint8_t* b, size_t n) {
+    uint64_t total = 0;
+    size_t i = 0;
+    const size_t vecEnd = n & ~static_cast<size_t>(15);
+    while (i < vecEnd) {
+        // u16 lanes: 64 векторов * 2 * 255 < 65535, без переполнения
+        const size_t end = std::min(vecEnd, i + 16 * 64);
+        uint16x8_t acc = vdupq_n_u16(0);
+        for (; i < end; i += 16)
+            acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+        total += vaddlvq_u16(acc);
+    }
+    return total + sad_scalar(a + i, b + i, n - i);
+}
+#else
+static uint64_t sad_block(const uint8_t* a, const uint8_t* b, size_t n) {
+    return sad_scalar(a, b, n);
+}
+#endif
+
+uint64_t av1r_sad_u8(const uint8_t* a, const uint8_t* b, size_t n, uint64_t limit) {
+    uint64_t s = 0;
+    for (size_t off = 0; off < n; off += SAD_CHUNK) {
+        s += sad_block(a + off, b + off, std::min(SAD_CHUNK, n - off));
+        if (s > limit) break;
+    }
+    return s;
+}
+
+// ============================================================================
+// Luma thumbnail (scene-change lookahead)
+// ============================================================================
+static const int THUMB_BLOCK    = 16;
+static const int THUMB_ROW_STEP = 4;   // 4 из 16 строк блока — в 4 раза меньше чтения
+
+// Сумма 16 байт строки блока
+static inline uint32_t row16_sum(const uint8_t* p) {
+#if defined(AV1R_SAD_SSE2)
+    __m128i s = _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                             _mm_setzero_si128());
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(s) +
+                                 _mm_cvtsi128_si32(_mm_srli_si128(s, 8)));
+#elif defined(AV1R_SAD_NEON)
+    return vaddlvq_u8(vld1q_u8(p));
+#else
+    uint32_t s = 0;
+    for (int i = 0; i < 16; i++) s += p[i];
+    return s;
+#endif
+}
+
+void av1r_luma_thumbnail(const uint8_t* luma, int width, int height, int stride,
+                         std::vector<uint8_t>& out) {
+    const int tw = width / THUMB_BLOCK, th = height / THUMB_BLOCK;
+    const uint32_t samples = THUMB_BLOCK * (THUMB_BLOCK / THUMB_ROW_STEP);
+    out.resize(static_cast<size_t>(tw) * static_cast<size_t>(th));
+    for (int by = 0; by < th; by++) {
+        for (int bx = 0; bx < tw; bx++) {
+            uint32_t s = 0;
+            const uint8_t* p = luma + static_cast<size_t>(by * THUMB_BLOCK) * stride
+                                    + bx * THUMB_BLOCK;
+            for (int r = 0; r < THUMB_BLOCK; r += THUMB_ROW_STEP)
+                s += row16_sum(p + static_cast<size_t>(r) * stride);
+            out[static_cast<size_t>(by) * tw + bx] = static_cast<uint8_t>((s + samples / 2) / samples);
+        }
+    }
+}
+
+void Av1rSceneDetector::reset(int width, int height) {
+    width_ = width;
+    height_ = height;
+    cur_.clear();
+    prev_.clear();
+    avg_ = 0.0;
+    lastScore_ = 0.0;
+    lastAvg_ = 0.0;
+    havePrev_ = false;
+}
+
+double Av1rSceneDetector::push(const uint8_t* luma) {
+    av1r_luma_thumbnail(luma, width_, height_, width_, cur_);
+    double score = 0.0;
+    lastAvg_ = avg_;
+    if (havePrev_ && !cur_.empty()) {
+        score = static_cast<double>(av1r_sad_u8(cur_.data(), prev_.data(), cur_.size())) /
+                (255.0 * static_cast<double>(cur_.size()));
+        avg_ = 0.9 * avg_ + 0.1 * score;
+    }
+    cur_.swap(prev_);
+    havePrev_ = true;
+    lastScore_ = score;
+    return score;
+}
+
+bool Av1rSceneDetector::is_cut(double threshold) const {
+    return threshold > 0 && lastScore_ >= threshold && lastScore_ >= 2.5 * lastAvg_;
+}
+
+bool av1r_frame_is_static(const uint8_t* cur, const uint8_t* prev, size_t n,
+                          double max_mean_abs_diff) {
+    if (n == 0 || max_mean_abs_diff < 0) return false;
+    const uint64_t limit = static_cast<uint64_t>(std::floor(max_mean_abs_diff * static_cast<double>(n)));
+    return av1r_sad_u8(cur, prev, n, limit) <= limit;
+}
+
+// ============================================================================
+// Content statistics (CRF predictor)
+// ============================================================================
+
+template <typename T>
+static Av1rContentStats content_stats(const T* y, int width, int height, int stride, int maxval) {
+    Av1rContentStats st;
+    if (width < 8 || height < 8) return st;
+    const double scale = 255.0 / maxval;
+
+    // 8x8 block variance
+    double varSum = 0.0;
+    int64_t blocks = 0;
+    for (int by = 0; by + 8 <= height; by += 8) {
+        for (int bx = 0; bx + 8 <= width; bx += 8) {
+            double s = 0.0, ss = 0.0;
+            for (int r = 0; r < 8; r++) {
+                const T* p = y + static_cast<size_t>(by + r) * stride + bx;
+                for (int c = 0; c < 8; c++) {
+                    const double v = p[c];
+                    s  += v;
+                    ss += v * v;
+                }
+            }
+            varSum += (ss - s * s / 64.0) / 64.0;
+            blocks++;
+        }
+    }
+    st.variance = varSum / blocks * scale * scale;
+
+    // Immerkaer (1996): sigma = sqrt(pi/2) / (6 (W-2)(H-2)) * sum |I * N|,
+    // N = [1 -2 1; -2 4 -2; 1 -2 1]
+    double lap = 0.0;
+    for (int r = 1; r + 1 < height; r++) {
+        const T* p0 = y + static_cast<size_t>(r - 1) * stride;
+        const T* p1 = p0 + stride;
+        const T* p2 = p1 + stride;
+        int64_t row = 0;
+        for (int c = 1; c + 1 < width; c++) {
+            const int64_t v = static_cast<int64_t>(p0[c - 1]) - 2 * p0[c] + p0[c + 1]
+                            - 2 * p1[c - 1] + 4 * p1[c] - 2 * p1[c + 1]
+                            + p2[c - 1] - 2 * p2[c] + p2[c + 1];
+            row += v < 0 ? -v : v;
+        }
+        lap += static_cast<double>(row);
+    }
+    st.noise = 1.2533141373155 / (6.0 * (width - 2) * (height - 2)) * lap * scale;   // sqrt(pi/2)
+
+    // Percentiles from the histogram
+    std::vector<uint32_t> hist(static_cast<size_t>(maxval) + 1, 0);
+    for (int r = 0; r < height; r++) {
+        const T* p = y + static_cast<size_t>(r) * stride;
+        for (int c = 0; c < width; c++) hist[p[c]]++;
+    }
+    const uint64_t n = static_cast<uint64_t>(width) * height;
+    const uint64_t cutLo = n / 1000, cutHi = n - n / 1000;
+    uint64_t acc = 0;
+    int lo = -1, hi = maxval;
+    for (int v = 0; v <= maxval; v++) {
+        acc += hist[static_cast<size_t>(v)];
+        if (lo < 0 && acc > cutLo) lo = v;
+        if (acc >= cutHi) { hi = v; break; }
+    }
+    st.lo = static_cast<double>(std::max(lo, 0)) / maxval;
+    st.hi = static_cast<double>(hi) / maxval;
+    return st;
+}
+
+Av1rContentStats av1r_content_stats_u8(const uint8_t* y, int width, int height, int stride) {
+    return content_stats(y, width, height, stride, 255);
+}
+
+Av1rContentStats av1r_content_stats_u16(const uint16_t* y, int width, int height, int stride) {
+    return content_stats(y, width, height, stride, 65535);
+}
+
+double av1r_temporal_diff_u8(const uint8_t* a, const uint8_t* b, size_t n) {
+    return n ? static_cast<double>(av1r_sad_u8(a, b, n)) / static_cast<double>(n) : 0.0;
+}
+
+double av1r_temporal_diff_u16(const uint16_t* a, const uint16_t* b, size_t n) {
+    uint64_t s = 0;
+    for (size_t i = 0; i < n; i++) s += static_cast<uint64_t>(a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]);
+    return n ? static_cast<double>(s) / static_cast<double>(n) * 255.0 / 65535.0 : 0.0;
+}
@@ -0,0 +1,64 @@
+// Pre-encode frame analysis for AV1R (CPU, SIMD where available).
+// Used by the Vulkan encoder to detect static/duplicate frames before
+// spending an upload + vkCmdEncodeVideoKHR on them, and for the content
+// statistics behind the no-probe CRF predictor (R/crf_model.R).
+
+#ifndef AV1R_ANALYSIS_H
+#define AV1R_ANALYSIS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sum of absolute differences of two byte buffers.
+// Stops early and returns a value > limit once the running sum exceeds limit.
+uint64_t av1r_sad_u8(const uint8_t* a, const uint8_t* b, size_t n,
+                     uint64_t limit = UINT64_MAX);
+
+// true if the mean absolute difference per sample is <= max_mean_abs_diff
+// (0 = bit-identical frames only)
+bool av1r_frame_is_static(const uint8_t* cur, const uint8_t* prev, size_t n,
+                          double max_mean_abs_diff);
+
+// Downscaled luma thumbnail: mean of each 16x16 block (every 4th row sampled).
+// Partial blocks at the right/bottom edge are dropped.
+void av1r_luma_thumbnail(const uint8_t* luma, int width, int height, int stride,
+                         std::vector<uint8_t>& out);
+
+// Scene-change metric for keyframe placement: difference of consecutive
+// luma thumbnails, normalized to 0..1 (mean |diff| / 255).
+class Av1rSceneDetector {
+public:
+    void reset(int width, int height);
+    // Score of this frame against the previous one (0 for the first frame)
+    double push(const uint8_t* luma);
+    // Last pushed frame is a cut: score >= threshold and well above the
+    // recent average (so steady noise or slow drift does not trigger)
+    bool is_cut(double threshold) const;
+private:
+    int width_ = 0, height_ = 0;
+    std::vector<uint8_t> cur_, prev_;
+    double avg_ = 0.0;        // EMA of scores before the last frame
+    double lastScore_ = 0.0;
+    double lastAvg_ = 0.0;
+    bool   havePrev_ = false;
+};
+
+// Content statistics of one luma plane for the CRF predictor. 8-bit
+// (maxval 255) or 16-bit (maxval 65535) samples; variance and noise on the
+// 8-bit scale the encoder sees, the percentiles as fractions of maxval.
+struct Av1rContentStats {
+    double variance = 0.0;   // mean variance of the 8x8 blocks
+    double noise    = 0.0;   // sigma, Immerkaer's Laplacian estimator
+    double lo       = 0.0;   // 0.1% percentile (0..1)
+    double hi       = 0.0;   // 99.9% percentile (0..1)
+};
+
+Av1rContentStats av1r_content_stats_u8(const uint8_t* y, int width, int height, int stride);
+Av1rContentStats av1r_content_stats_u16(const uint16_t* y, int width, int height, int stride);
+
+// Mean absolute luma difference of two frames on the 8-bit scale
+double av1r_temporal_diff_u8(const uint8_t* a, const uint8_t* b, size_t n);
+double av1r_temporal_diff_u16(const uint16_t* a, const uint16_t* b, size_t n);
+
+#endif
@@ -0,0 +1,189 @@
+// Synthetic microscopy frames + OBU walker for the per-stage benchmark.
+// Сцена: фон ~ несколько фотонов, гауссовы пятна (клетки/пунктаты) с общим
+// дрейфом столика и собственным движением, фотообесцвечивание, шум Пуассона.
+// Кадр i зависит только от (seed, i) — порядок рендера не важен.
+
+#include "av1r_bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// xorshift64*: fast, good enough for noise
+struct Rng {
+    uint64_t s;
+    explicit Rng(uint64_t seed) : s(splitmix64(seed) | 1) {}
+    double uniform() {               // (0, 1]
+        s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+        return (static_cast<double>((s * 0x2545F4914F6CDD1Dull) >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+    }
+    double normal() {
+        const double u1 = uniform(), u2 = uniform();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    }
+    // Knuth below 30 photons, normal approximation above
+    uint32_t poisson(double lambda) {
+        if (lambda <= 0.0) return 0;
+        if (lambda < 30.0) {
+            const double l = std::exp(-lambda);
+            uint32_t k = 0;
+            double p = uniform();
+            while (p > l) { k++; p *= uniform(); }
+            return k;
+        }
+        const double v = std::floor(lambda + std::sqrt(lambda) * normal() + 0.5);
+        return v > 0.0 ? static_cast<uint32_t>(v) : 0u;
+    }
+    // Inverse CDF for a fixed lambda (background pixels): one draw per sample
+    uint32_t from_cdf(const std::vector<double>& cdf) {
+        const size_t k = std::lower_bound(cdf.begin(), cdf.end() - 1, uniform()) - cdf.begin();
+        return static_cast<uint32_t>(k);
+    }
+};
+
+// Photon → sample value: offset (camera bias) + gain * photons
+struct SensorModel { double background, peakMin, peakMax, offset, gain, maxValue; };
+const SensorModel kSensor8  = {  6.0,  40.0,  200.0,  10.0,  1.0,   255.0 };
+const SensorModel kSensor16 = { 30.0, 200.0, 3000.0, 100.0, 16.0, 65535.0 };
+
+} // namespace
+
+void Av1rSynthScene::reset(int width, int height, int bits, uint64_t seed,
+                           const Av1rSynthParams& params) {
+    if (width <= 0 || height <= 0 || (width | height) & 1)
+        throw std::runtime_error("synthetic frames: positive even width and height expected");
+    if (bits != 8 && bits != 16)
+        throw std::runtime_error("synthetic frames: bits must be 8 or 16");
+    if (!(params.density > 0 && params.size > 0 && params.photons > 0 && params.gain > 0 &&
+          params.drift >= 0))
+        throw std::runtime_error("synthetic frames: scene scale factors must be positive (drift >= 0)");
+    width_ = width; height_ = height; bits_ = bits; seed_ = seed; params_ = params;
+    lambda_.assign(static_cast<size_t>(width) * height, 0.0f);
+
+    const SensorModel& sm = bits == 8 ? kSensor8 : kSensor16;
+    // Фон одинаков почти во всех пикселях: CDF Пуассона считается один раз
+    // (photons масштабирует и фон, и пики: при той же яркости меньше шума)
+    const double background = sm.background * params.photons;
+    bgCdf_.clear();
+    double pk = std::exp(-background), acc = 0.0;
+    for (uint32_t k = 0; acc < 1.0 - 1e-12 && k < 5000; k++) {
+        acc += pk;
+        bgCdf_.push_back(acc);
+        pk *= background / (k + 1);
+    }
+    bgCdf_.back() = 1.0;
+
+    const size_t n = std::max<size_t>(
+        4, static_cast<size_t>(params.density * (static_cast<double>(width) * height / 16384)));
+    Rng rng(seed);
+    blobs_.resize(n);
+    for (Blob& b : blobs_) {
+        b.x  = rng.uniform() * width;
+        b.y  = rng.uniform() * height;
+        b.vx = (rng.uniform() - 0.5) * 0.6 * params.drift;   // собственное движение, px/кадр
+        b.vy = (rng.uniform() - 0.5) * 0.6 * params.drift;
+        b.sigma   = (1.5 + rng.uniform() * 4.5) * params.size;   // пунктаты .. клетки
+        b.photons = (sm.peakMin + rng.uniform() * (sm.peakMax - sm.peakMin)) * params.photons;
+    }
+}
+
+size_t Av1rSynthScene::frame_bytes() const {
+    const size_t px = static_cast<size_t>(width_) * height_;
+    return bits_ == 8 ? px * 3 / 2 : px * 2;
+}
+
+void Av1rSynthScene::render(int index, uint8_t* out) {
+    const SensorModel& sm = bits_ == 8 ? kSensor8 : kSensor16;
+    const double background = sm.background * params_.photons;
+    std::fill(lambda_.begin(), lambda_.end(), static_cast<float>(background));
+
+    const double t = static_cast<double>(index);
+    const double bleach = std::exp(-t / 2000.0);
+    const double driftX = 0.15 * params_.drift * t, driftY = 0.08 * params_.drift * t;   // дрейф столика
+    for (const Blob& b : blobs_) {
+        double cx = std::fmod(b.x + driftX + b.vx * t, static_cast<double>(width_));
+        double cy = std::fmod(b.y + driftY + b.vy * t, static_cast<double>(height_));
+        if (cx < 0) cx += width_;
+        if (cy < 0) cy += height_;
+        const int r = static_cast<int>(std::ceil(3.0 * b.sigma));
+        const double inv2s2 = 1.0 / (2.0 * b.sigma * b.sigma);
+        const double peak = b.photons * bleach;
+        const int x0 = static_cast<int>(cx), y0 = static_cast<int>(cy);
+        for (int dy = -r; dy <= r; dy++) {
+            const int y = ((y0 + dy) % height_ + height_) % height_;   // тор: пятна не уходят
+            const double ddy = y0 + dy - cy;
+            float* row = &lambda_[static_cast<size_t>(y) * width_];
+            for (int dx = -r; dx <= r; dx++) {
+                const double ddx = x0 + dx - cx;
+                const int x = ((x0 + dx) % width_ + width_) % width_;
+                row[x] += static_cast<float>(peak * std::exp(-(ddx * ddx + ddy * ddy) * inv2s2));
+            }
+        }
+    }
+
+    Rng rng(seed_ ^ splitmix64(static_cast<uint64_t>(index) + 1));
+    const float bg = static_cast<float>(background);
+    const double gain = sm.gain * params_.gain / params_.photons;
+    auto photons = [&](float lambda) {
+        return lambda == bg ? rng.from_cdf(bgCdf_) : rng.poisson(lambda);
+    };
+    const size_t px = lambda_.size();
+    if (bits_ == 8) {
+        for (size_t i = 0; i < px; i++) {
+            const double v = sm.offset + gain * photons(lambda_[i]);
+            out[i] = static_cast<uint8_t>(std::min(v, sm.maxValue));
+        }
+        std::memset(out + px, 128, px / 2);
+    } else {
+        for (size_t i = 0; i < px; i++) {
+            const uint32_t v = static_cast<uint32_t>(
+                std::min(sm.offset + gain * photons(lambda_[i]), sm.maxValue));
+            out[2 * i]     = static_cast<uint8_t>(v & 0xFF);
+            out[2 * i + 1] = static_cast<uint8_t>(v >> 8);
+        }
+    }
+}
+
+// ============================================================================
+// OBU walker: obu_header (+ extension) + leb128 obu_size
+// ============================================================================
+void av1r_obu_walk(const uint8_t* data, size_t size, Av1rObuCounts& counts) {
+    size_t pos = 0;
+    while (pos < size) {
+        const uint8_t h = data[pos++];
+        if (h & 0x80) throw std::runtime_error("OBU forbidden bit set at byte " + std::to_string(pos - 1));
+        const uint8_t type = (h >> 3) & 0x0F;
+        if (h & 0x04) pos++;                       // obu_extension_header
+        uint64_t len = 0;
+        if (h & 0x02) {
+            int i = 0;
+            for (;; i++) {
+                if (pos >= size || i == 8) throw std::runtime_error("truncated OBU size");
+                const uint8_t b = data[pos++];
+                len |= static_cast<uint64_t>(b & 0x7F) << (7 * i);
+                if (!(b & 0x80)) break;
+            }
+        } else {
+            len = pos <= size ? size - pos : 0;
+        }
+        if (pos > size || len > size - pos) throw std::runtime_error("truncated OBU payload");
+        pos += static_cast<size_t>(len);
+
+        counts.obus++;
+        counts.payloadBytes += len;
+        if (type == 1) counts.seqHeaders++;
+        else if (type == 3 || type == 6) counts.frames++;
+        else if (type == 5) counts.metadata++;
+    }
+}
@@ -0,0 +1,55 @@
+// Per-stage benchmark helpers (R_av1r_benchmark, av1r_benchmark() in R).
+// Synthetic fluorescence-like frames: Gaussian blobs (cells, puncta) that
+// drift with the stage and on their own, slow photobleaching and Poisson
+// shot noise on a dim background. Deterministic for a given seed, so runs
+// on different machines and releases encode the same input.
+
+#ifndef AV1R_BENCH_H
+#define AV1R_BENCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Scene knobs for calibration corpora (inst/bench/crf_corpus.R). The
+// defaults render the benchmark scene; all are scale factors.
+struct Av1rSynthParams {
+    double density = 1.0;   // blobs per area (texture)
+    double size    = 1.0;   // blob sigma
+    double photons = 1.0;   // photons per sample step: shot noise ~ 1/sqrt
+    double gain    = 1.0;   // sample value per step (used part of the range)
+    double drift   = 1.0;   // stage drift and blob motion
+};
+
+class Av1rSynthScene {
+public:
+    // bits 8 → NV12 frames (Y = signal, UV = 128); bits 16 → gray16le
+    void reset(int width, int height, int bits, uint64_t seed,
+               const Av1rSynthParams& params = Av1rSynthParams());
+    size_t frame_bytes() const;
+    // Render frame `index` (any order; frames do not depend on each other)
+    void render(int index, uint8_t* out);
+private:
+    struct Blob { double x, y, vx, vy, sigma, photons; };
+    int width_ = 0, height_ = 0, bits_ = 8;
+    uint64_t seed_ = 0;
+    Av1rSynthParams params_;
+    std::vector<Blob>  blobs_;
+    std::vector<float> lambda_;   // expected photons per pixel, this frame
+    std::vector<double> bgCdf_;   // Poisson CDF of the background level
+};
+
+// OBU statistics of one temporal unit (low-overhead bitstream format)
+struct Av1rObuCounts {
+    uint32_t obus        = 0;
+    uint32_t seqHeaders  = 0;
+    uint32_t frames      = 0;   // OBU_FRAME + OBU_FRAME_HEADER
+    uint32_t metadata    = 0;
+    uint64_t payloadBytes = 0;  // sum of obu_size
+};
+
+// Walks the OBU headers and leb128 sizes; throws std::runtime_error on a
+// truncated or malformed packet
+void av1r_obu_walk(const uint8_t* data, size_t size, Av1rObuCounts& counts);
+
+#endif
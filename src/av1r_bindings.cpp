@@ -1,11 +1,20 @@
 // R ↔ C++ bindings for AV1R
-// CPU encoding: ffmpeg вызывается через system() в R-коде (нет линковки с libavcodec)
+// CPU encoding: ffmpeg вызывается через system() в R-коде, либо SVT-AV1 в
+// процессе (libSvtAv1Enc, если собран с AV1R_HAVE_SVTAV1)
 // GPU encoding: Vulkan через этот файл
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
 #include <cstring>
 #include <cstdio>
+#include <functional>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 // R headers must come after C++ STL to avoid macro conflicts.
@@ -18,6 +27,21 @@
 #endif
 
 #include "../inst/include/av1r.h"
+#include "av1r_analysis.h"
+#include "av1r_tiles.h"
+#include "av1r_denoise.h"
+#include "av1r_convert.h"
+#include "av1r_bench.h"
+#include "av1r_trace.h"
+#include "av1r_progress.h"
+#include "av1r_memstats.h"
+#include "av1r_jobs.h"
+#include "av1r_probe.h"
+#include "av1r_decode.h"
+#include "av1r_encode_svt.h"
+#include "av1r_metrics.h"
+#include "av1r_hash.h"
+#include "av1r_prefetch.h"
 
 #ifdef AV1R_USE_VULKAN
 #include "av1r_vulkan_ctx.h"
@@ -46,6 +70,24 @@ extern "C" SEXP R_av1r_vulkan_available(void) {
 #endif
 }
 
+// ============================================================================
+// R_av1r_libav_version  →  libavcodec version of the in-process decoder,
+// or NULL when built without libav (Vulkan path decodes via the ffmpeg pipe)
+// ============================================================================
+extern "C" SEXP R_av1r_libav_version(void) {
+    const std::string v = av1r_libav_version();
+    return v.empty() ? R_NilValue : Rf_mkString(v.c_str());
+}
+
+// ============================================================================
+// R_av1r_svt_version  →  libSvtAv1Enc version of the in-process CPU encoder,
+// or NULL when built without SVT-AV1 (CPU encodes run the ffmpeg binary)
+// ============================================================================
+extern "C" SEXP R_av1r_svt_version(void) {
+    const std::string v = av1r_svt_version();
+    return v.empty() ? R_NilValue : Rf_mkString(v.c_str());
+}
+
 // ============================================================================
 // R_av1r_vulkan_devices  →  character vector
 // ============================================================================
@@ -101,15 +143,558 @@ extern "C" SEXP R_av1r_detect_backend(SEXP prefer) {
 }
 
 // ============================================================================
-// R_av1r_vulkan_encode(input, output, width, height, fps, crf)
-// ffmpeg декодирует input в NV12 через pipe → C++ encode → IVF файл
+// R_av1r_frame_sad(a, b)  →  numeric(1): SAD двух raw векторов
+// (тот же SIMD kernel, что и static frame detection в Vulkan encoder)
+// ============================================================================
+extern "C" SEXP R_av1r_frame_sad(SEXP r_a, SEXP r_b) {
+    if (TYPEOF(r_a) != RAWSXP || TYPEOF(r_b) != RAWSXP)
+        Rf_error("frame_sad: raw vectors expected");
+    if (Rf_xlength(r_a) != Rf_xlength(r_b))
+        Rf_error("frame_sad: length mismatch (%lld vs %lld)",
+                 (long long)Rf_xlength(r_a), (long long)Rf_xlength(r_b));
+    uint64_t sad = av1r_sad_u8(RAW(r_a), RAW(r_b), static_cast<size_t>(Rf_xlength(r_a)));
+    return Rf_ScalarReal(static_cast<double>(sad));
+}
+
+// ============================================================================
+// R_av1r_scene_scores(frames, width, height, threshold)  →  list(score, cut):
+// Av1rSceneDetector над последовательностью 8-bit luma плоскостей
+// (raw вектор, кадры подряд), как его видит keyframe placement
+// ============================================================================
+extern "C" SEXP R_av1r_scene_scores(SEXP r_frames, SEXP r_width, SEXP r_height,
+                                    SEXP r_threshold) {
+    if (TYPEOF(r_frames) != RAWSXP) Rf_error("scene_scores: raw vector expected");
+    const int w = Rf_asInteger(r_width), h = Rf_asInteger(r_height);
+    if (w == NA_INTEGER || h == NA_INTEGER || w < 1 || h < 1)
+        Rf_error("scene_scores: invalid frame size");
+    const size_t plane = static_cast<size_t>(w) * static_cast<size_t>(h);
+    const size_t n = static_cast<size_t>(Rf_xlength(r_frames));
+    if (n % plane != 0) Rf_error("scene_scores: length is not a multiple of width * height");
+    const double threshold = Rf_asReal(r_threshold);
+
+    SEXP score = PROTECT(Rf_allocVector(REALSXP, static_cast<R_xlen_t>(n / plane)));
+    SEXP cut   = PROTECT(Rf_allocVector(LGLSXP, static_cast<R_xlen_t>(n / plane)));
+    {
+        Av1rSceneDetector scene;
+        scene.reset(w, h);
+        for (size_t i = 0; i < n / plane; i++) {
+            REAL(score)[i]  = scene.push(RAW(r_frames) + i * plane);
+            LOGICAL(cut)[i] = scene.is_cut(threshold);
+        }
+    }
+    SEXP res = PROTECT(Rf_allocVector(VECSXP, 2));
+    SEXP nms = PROTECT(Rf_allocVector(STRSXP, 2));
+    SET_VECTOR_ELT(res, 0, score);
+    SET_VECTOR_ELT(res, 1, cut);
+    SET_STRING_ELT(nms, 0, Rf_mkChar("score"));
+    SET_STRING_ELT(nms, 1, Rf_mkChar("cut"));
+    Rf_setAttrib(res, R_NamesSymbol, nms);
+    UNPROTECT(4);
+    return res;
+}
+
+// Named list of scalars/vectors returned to R (per-encode stats, benchmarks)
+class Av1rStatsList {
+public:
+    void add(const char* name, double value, SEXPTYPE type = INTSXP) {
+        items_.push_back({name, std::vector<double>(1, value), type,
+                          std::vector<std::string>()});
+    }
+    void add_string(const char* name, const char* value) {
+        items_.push_back({name, std::vector<double>(), STRSXP,
+                          std::vector<std::string>(1, value)});
+    }
+    void add_strings(const char* name, const std::vector<std::string>& values) {
+        items_.push_back({name, std::vector<double>(), STRSXP, values});
+    }
+    void add_logical(const char* name, bool value) {
+        add(name, value ? 1.0 : 0.0, LGLSXP);
+    }
+    template <typename T>
+    void add_vector(const char* name, const std::vector<T>& values, SEXPTYPE type = INTSXP) {
+        items_.push_back({name, std::vector<double>(values.begin(), values.end()), type,
+                          std::vector<std::string>()});
+    }
+    SEXP to_sexp() const {
+        const R_xlen_t n = static_cast<R_xlen_t>(items_.size());
+        SEXP res = PROTECT(Rf_allocVector(VECSXP, n));
+        SEXP nms = PROTECT(Rf_allocVector(STRSXP, n));
+        for (R_xlen_t i = 0; i < n; i++) {
+            const Item& it = items_[static_cast<size_t>(i)];
+            SET_STRING_ELT(nms, i, Rf_mkChar(it.name.c_str()));
+            const R_xlen_t len = static_cast<R_xlen_t>(
+                it.type == STRSXP ? it.strs.size() : it.values.size());
+            SEXP v = Rf_allocVector(it.type, len);
+            SET_VECTOR_ELT(res, i, v);
+            if (it.type == STRSXP) {
+                for (R_xlen_t j = 0; j < len; j++)
+                    SET_STRING_ELT(v, j, Rf_mkChar(it.strs[static_cast<size_t>(j)].c_str()));
+                continue;
+            }
+            for (R_xlen_t j = 0; j < len; j++) {
+                const double x = it.values[static_cast<size_t>(j)];
+                if (it.type == REALSXP)     REAL(v)[j]    = x;
+                else if (it.type == LGLSXP) LOGICAL(v)[j] = x != 0 ? TRUE : FALSE;
+                else                        INTEGER(v)[j] = static_cast<int>(x);
+            }
+        }
+        Rf_setAttrib(res, R_NamesSymbol, nms);
+        UNPROTECT(2);
+        return res;
+    }
+private:
+    struct Item {
+        std::string name; std::vector<double> values; SEXPTYPE type;
+        std::vector<std::string> strs;
+    };
+    std::vector<Item> items_;
+};
+
+// Memory accounting columns (av1r_memstats.h): memory_category/_domain/
+// _current/_peak per category (bytes), plus per-domain totals
+static void add_memory_stats(Av1rStatsList& stats, const Av1rMemAccount& acct) {
+    std::vector<std::string> cat, dom;
+    std::vector<double> cur, peak;
+    for (const Av1rMemUsage& u : acct.usage()) {
+        cat.push_back(u.category);
+        dom.push_back(u.domain == AV1R_MEM_DEVICE ? "device" : "host");
+        cur.push_back(static_cast<double>(u.current));
+        peak.push_back(static_cast<double>(u.peak));
+    }
+    stats.add_strings("memory_category", cat);
+    stats.add_strings("memory_domain",   dom);
+    stats.add_vector("memory_current", cur,  REALSXP);
+    stats.add_vector("memory_peak",    peak, REALSXP);
+    stats.add("memory_current_host",   static_cast<double>(acct.current(AV1R_MEM_HOST)),   REALSXP);
+    stats.add("memory_peak_host",      static_cast<double>(acct.peak(AV1R_MEM_HOST)),      REALSXP);
+    stats.add("memory_current_device", static_cast<double>(acct.current(AV1R_MEM_DEVICE)), REALSXP);
+    stats.add("memory_peak_device",    static_cast<double>(acct.peak(AV1R_MEM_DEVICE)),    REALSXP);
+}
+
+// ============================================================================
+// R_av1r_tile_layout(width, height, max_tiles)  →  list: AV1 tile layout,
+// который Vulkan encoder выберет (без лимитов драйвера)
+// ============================================================================
+extern "C" SEXP R_av1r_tile_layout(SEXP r_width, SEXP r_height, SEXP r_max_tiles) {
+    int w = Rf_asInteger(r_width), h = Rf_asInteger(r_height), m = Rf_asInteger(r_max_tiles);
+    if (w == NA_INTEGER || h == NA_INTEGER || w <= 0 || h <= 0)
+        Rf_error("tile_layout: positive width and height expected");
+    Av1rTileLayout L = av1r_tile_layout(static_cast<uint32_t>(w), static_cast<uint32_t>(h),
+                                        m == NA_INTEGER || m < 0 ? 0u : static_cast<uint32_t>(m),
+                                        Av1rTileLimits{});
+    static const char* names[] = { "cols", "rows", "uniform", "mi_col_starts", "mi_row_starts" };
+    SEXP res = PROTECT(Rf_allocVector(VECSXP, 5));
+    SEXP nms = PROTECT(Rf_allocVector(STRSXP, 5));
+    for (int i = 0; i < 5; i++) SET_STRING_ELT(nms, i, Rf_mkChar(names[i]));
+    Rf_setAttrib(res, R_NamesSymbol, nms);
+    SET_VECTOR_ELT(res, 0, Rf_ScalarInteger(static_cast<int>(L.cols)));
+    SET_VECTOR_ELT(res, 1, Rf_ScalarInteger(static_cast<int>(L.rows)));
+    SET_VECTOR_ELT(res, 2, Rf_ScalarLogical(L.uniform ? TRUE : FALSE));
+    const std::vector<uint16_t>* starts[] = { &L.miColStarts, &L.miRowStarts };
+    for (int k = 0; k < 2; k++) {
+        SEXP v = Rf_allocVector(INTSXP, static_cast<R_xlen_t>(starts[k]->size()));
+        SET_VECTOR_ELT(res, 3 + k, v);
+        for (size_t i = 0; i < starts[k]->size(); i++) INTEGER(v)[i] = (*starts[k])[i];
+    }
+    UNPROTECT(2);
+    return res;
+}
+
+// Source format + gray16 window from R arguments (character(1), NULL or c(lo, hi))
+static Av1rPixFmt parse_pix_fmt(SEXP r_format) {
+    if (!Rf_isString(r_format) || Rf_xlength(r_format) != 1)
+        Rf_error("format: character(1) expected");
+    try {
+        return av1r_pix_fmt_from_name(CHAR(STRING_ELT(r_format, 0)));
+    } catch (const std::exception& e) {
+        Rf_error("%s", e.what());
+    }
+    return AV1R_PIX_NV12;
+}
+
+static void parse_window(SEXP r_window, uint32_t* lo, uint32_t* hi) {
+    *lo = 0;
+    *hi = 65535;
+    if (Rf_isNull(r_window)) return;
+    if (!Rf_isNumeric(r_window) || Rf_xlength(r_window) != 2)
+        Rf_error("window: numeric(2) c(lo, hi) expected");
+    SEXP v = PROTECT(Rf_coerceVector(r_window, REALSXP));
+    const double a = REAL(v)[0], b = REAL(v)[1];
+    UNPROTECT(1);
+    if (ISNAN(a) || ISNAN(b) || a < 0 || b > 65535 || a >= b)
+        Rf_error("window: 0 <= lo < hi <= 65535 expected");
+    *lo = static_cast<uint32_t>(a);
+    *hi = static_cast<uint32_t>(b);
+}
+
+// ============================================================================
+// R_av1r_convert_nv12(format, frame, width, height, window)  →  raw NV12
+// CPU reference conversion (та же формула, что и compute shader)
+// ============================================================================
+extern "C" SEXP R_av1r_convert_nv12(SEXP r_format, SEXP r_frame, SEXP r_width,
+                                    SEXP r_height, SEXP r_window) {
+    const Av1rPixFmt fmt = parse_pix_fmt(r_format);
+    const int w = Rf_asInteger(r_width), h = Rf_asInteger(r_height);
+    if (w == NA_INTEGER || h == NA_INTEGER || w <= 0 || h <= 0 || (w | h) & 1)
+        Rf_error("convert_nv12: positive even width and height expected");
+    if (TYPEOF(r_frame) != RAWSXP ||
+        static_cast<size_t>(Rf_xlength(r_frame)) != av1r_pix_fmt_frame_bytes(fmt, w, h))
+        Rf_error("convert_nv12: raw vector of %lld bytes expected",
+                 (long long)av1r_pix_fmt_frame_bytes(fmt, w, h));
+    uint32_t lo, hi;
+    parse_window(r_window, &lo, &hi);
+    SEXP out = PROTECT(Rf_allocVector(RAWSXP,
+        static_cast<R_xlen_t>(av1r_pix_fmt_frame_bytes(AV1R_PIX_NV12, w, h))));
+    av1r_convert_to_nv12_cpu(fmt, RAW(r_frame), RAW(out), w, h, lo, hi);
+    UNPROTECT(1);
+    return out;
+}
+
+// ============================================================================
+// R_av1r_gpu_convert_bench(format, width, height, frames, window)  →  list
+// Compute shader vs CPU reference on synthetic frames. Uses a compute-only
+// device (works on lavapipe without an encode queue); the queue family is
+// chosen like the encoder's transfer queue.
+// ============================================================================
+extern "C" SEXP R_av1r_gpu_convert_bench(SEXP r_format, SEXP r_width, SEXP r_height,
+                                         SEXP r_frames, SEXP r_window) {
+    const Av1rPixFmt fmt = parse_pix_fmt(r_format);
+    const int w = Rf_asInteger(r_width), h = Rf_asInteger(r_height);
+    const int frames = Rf_asInteger(r_frames);
+    if (w == NA_INTEGER || h == NA_INTEGER || w <= 0 || h <= 0 || (w | h) & 1)
+        Rf_error("gpu_convert_bench: positive even width and height expected");
+    if (frames == NA_INTEGER || frames <= 0)
+        Rf_error("gpu_convert_bench: frames must be positive");
+    uint32_t lo, hi;
+    parse_window(r_window, &lo, &hi);
+
+    Av1rStatsList res;
+    std::string reason;
+
+    // Synthetic input (LCG, deterministic) and CPU reference
+    std::vector<uint8_t> src(av1r_pix_fmt_frame_bytes(fmt, w, h));
+    uint32_t seed = 12345u;
+    for (size_t i = 0; i < src.size(); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        src[i] = static_cast<uint8_t>(seed >> 24);
+    }
+    std::vector<uint8_t> ref(av1r_pix_fmt_frame_bytes(AV1R_PIX_NV12, w, h));
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    for (int i = 0; i < frames; i++)
+        av1r_convert_to_nv12_cpu(fmt, src.data(), ref.data(), w, h, lo, hi);
+    const double cpu_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count() / frames;
+
+#ifdef AV1R_USE_VULKAN
+    VkInstance inst = VK_NULL_HANDLE;
+    VkDevice   dev  = VK_NULL_HANDLE;
+    VkCommandPool pool = VK_NULL_HANDLE;
+    VkFence    fence = VK_NULL_HANDLE;
+    Av1rBuffer readback{};
+    char devName[256] = "";
+    double gpu_ms = 0.0, max_diff = -1.0;
+    try {
+        inst = av1r_create_instance();
+        VkPhysicalDevice phys = av1r_select_device(inst, -1);
+        av1r_device_name(phys, devName, sizeof(devName));
+        uint32_t fam = UINT32_MAX;
+        dev = av1r_create_compute_device(phys, &fam);
+        VkQueue queue = VK_NULL_HANDLE;
+        vkGetDeviceQueue(dev, fam, 0, &queue);
+        pool  = av1r_create_command_pool(dev, fam);
+        fence = av1r_create_fence(dev);
+        {
+            Av1rGpuConverter conv;
+            conv.init(phys, dev, fam, fmt, w, h, lo, hi);
+            readback = av1r_buffer_create(phys, dev, conv.nv12_bytes(),
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                0, "readback");
+
+            VkCommandBuffer cmd = av1r_alloc_command_buffer(dev, pool);
+            t0 = Clock::now();
+            for (int i = 0; i < frames; i++) {
+                std::memcpy(conv.input(), src.data(), conv.input_bytes());
+                vkResetCommandBuffer(cmd, 0);
+                av1r_begin_command_buffer(cmd);
+                conv.record(cmd);
+                VkBufferCopy region{0, 0, conv.nv12_bytes()};
+                vkCmdCopyBuffer(cmd, conv.nv12_buffer(), readback.buffer, 1, &region);
+                av1r_end_command_buffer(cmd);
+                av1r_reset_fence(dev, fence);
+                av1r_queue_submit(queue, cmd, fence);
+                av1r_wait_fence(dev, fence);
+            }
+            gpu_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count() / frames;
+
+            const uint8_t* got = static_cast<const uint8_t*>(readback.ptr);
+            max_diff = 0.0;
+            for (size_t i = 0; i < ref.size(); i++) {
+                const double d = std::abs(static_cast<int>(got[i]) - static_cast<int>(ref[i]));
+                if (d > max_diff) max_diff = d;
+            }
+        }
+    } catch (const std::exception& e) {
+        reason = e.what();
+    }
+    if (readback.buffer != VK_NULL_HANDLE) av1r_buffer_destroy(dev, readback);
+    if (fence != VK_NULL_HANDLE) vkDestroyFence(dev, fence, nullptr);
+    if (pool  != VK_NULL_HANDLE) vkDestroyCommandPool(dev, pool, nullptr);
+    if (dev   != VK_NULL_HANDLE) av1r_destroy_logical_device(dev);
+    if (inst  != VK_NULL_HANDLE) av1r_destroy_instance(inst);
+
+    res.add_logical("available", reason.empty());
+    res.add_string("reason", reason.c_str());
+    res.add_string("device", devName);
+    res.add("gpu_ms", reason.empty() ? gpu_ms : NA_REAL, REALSXP);
+    res.add("max_abs_diff", reason.empty() ? max_diff : NA_REAL, REALSXP);
+#else
+    reason = "package built without Vulkan";
+    res.add_logical("available", false);
+    res.add_string("reason", reason.c_str());
+    res.add_string("device", "");
+    res.add("gpu_ms", NA_REAL, REALSXP);
+    res.add("max_abs_diff", NA_REAL, REALSXP);
+#endif
+    res.add_string("format", av1r_pix_fmt_name(fmt));
+    res.add("width", w);
+    res.add("height", h);
+    res.add("frames", frames);
+    res.add("cpu_ms", cpu_ms, REALSXP);
+    return res.to_sexp();
+}
+
+// ============================================================================
+// R_av1r_vulkan_caps(refresh)  →  list: AV1 encode capabilities of the device
+// the encoder will use. Probed once per process; R/caps.R persists it to disk.
 // ============================================================================
 #ifdef AV1R_VULKAN_VIDEO_AV1
+static const char* vk_format_label(VkFormat f) {
+    switch (f) {
+        case VK_FORMAT_G8_B8R8_2PLANE_420_UNORM:                  return "NV12";
+        case VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM:                 return "I420";
+        case VK_FORMAT_G10X6_B10X6R10X6_2PLANE_420_UNORM_3PACK16: return "P010";
+        case VK_FORMAT_G16_B16R16_2PLANE_420_UNORM:               return "P016";
+        case VK_FORMAT_G8_B8R8_2PLANE_422_UNORM:                  return "NV16";
+        case VK_FORMAT_G8_B8_R8_3PLANE_444_UNORM:                 return "I444";
+        default:                                                  return nullptr;
+    }
+}
 
-#include "av1r_stream_encoder.h"
+static SEXP format_vector(const std::vector<VkFormat>& fmts) {
+    SEXP v = PROTECT(Rf_allocVector(STRSXP, static_cast<R_xlen_t>(fmts.size())));
+    for (size_t i = 0; i < fmts.size(); i++) {
+        const char* label = vk_format_label(fmts[i]);
+        std::string s = label ? label : "VkFormat(" + std::to_string(fmts[i]) + ")";
+        SET_STRING_ELT(v, static_cast<R_xlen_t>(i), Rf_mkChar(s.c_str()));
+    }
+    UNPROTECT(1);
+    return v;
+}
+#endif
 
-// Query minimum encode resolution (from av1r_encode_vulkan.cpp)
-void av1r_vulkan_query_min_extent(VkInstance, VkPhysicalDevice, uint32_t*, uint32_t*);
+extern "C" SEXP R_av1r_vulkan_caps(SEXP r_refresh) {
+    static const char* names[] = {
+        "av1", "device", "vendor_id", "device_id", "driver_version", "api_version",
+        "min_width", "min_height", "max_width", "max_height",
+        "max_dpb_slots", "max_active_refs", "max_quality_levels",
+        "src_formats", "dpb_formats"
+    };
+    const int n = static_cast<int>(sizeof(names) / sizeof(names[0]));
+    SEXP res = PROTECT(Rf_allocVector(VECSXP, n));
+    SEXP nms = PROTECT(Rf_allocVector(STRSXP, n));
+    for (int i = 0; i < n; i++) SET_STRING_ELT(nms, i, Rf_mkChar(names[i]));
+    Rf_setAttrib(res, R_NamesSymbol, nms);
+    SET_VECTOR_ELT(res, 0, Rf_ScalarLogical(FALSE));
+    SET_VECTOR_ELT(res, 1, Rf_mkString(""));
+    for (int i = 2; i < 13; i++) SET_VECTOR_ELT(res, i, Rf_ScalarInteger(NA_INTEGER));
+    SET_VECTOR_ELT(res, 4, Rf_ScalarReal(NA_REAL));
+    SET_VECTOR_ELT(res, 13, Rf_allocVector(STRSXP, 0));
+    SET_VECTOR_ELT(res, 14, Rf_allocVector(STRSXP, 0));
+
+#ifdef AV1R_VULKAN_VIDEO_AV1
+    bool refresh = Rf_asLogical(r_refresh) == TRUE;
+    try {
+        VkInstance inst = av1r_create_instance();
+        try {
+            VkPhysicalDevice dev = av1r_select_device(inst, -1);
+            if (av1r_device_supports_av1_encode(dev)) {
+                const Av1rVulkanCaps& c = av1r_vulkan_caps(inst, dev, refresh);
+                SET_VECTOR_ELT(res, 0,  Rf_ScalarLogical(c.valid ? TRUE : FALSE));
+                SET_VECTOR_ELT(res, 1,  Rf_mkString(c.deviceName));
+                SET_VECTOR_ELT(res, 2,  Rf_ScalarInteger(static_cast<int>(c.vendorId)));
+                SET_VECTOR_ELT(res, 3,  Rf_ScalarInteger(static_cast<int>(c.deviceId)));
+                SET_VECTOR_ELT(res, 4,  Rf_ScalarReal(static_cast<double>(c.driverVersion)));
+                char api[32];
+                snprintf(api, sizeof(api), "%u.%u.%u",
+                         VK_API_VERSION_MAJOR(c.apiVersion),
+                         VK_API_VERSION_MINOR(c.apiVersion),
+                         VK_API_VERSION_PATCH(c.apiVersion));
+                SET_VECTOR_ELT(res, 5,  Rf_mkString(api));
+                SET_VECTOR_ELT(res, 6,  Rf_ScalarInteger(static_cast<int>(c.minWidth)));
+                SET_VECTOR_ELT(res, 7,  Rf_ScalarInteger(static_cast<int>(c.minHeight)));
+                SET_VECTOR_ELT(res, 8,  Rf_ScalarInteger(static_cast<int>(c.maxWidth)));
+                SET_VECTOR_ELT(res, 9,  Rf_ScalarInteger(static_cast<int>(c.maxHeight)));
+                SET_VECTOR_ELT(res, 10, Rf_ScalarInteger(static_cast<int>(c.maxDpbSlots)));
+                SET_VECTOR_ELT(res, 11, Rf_ScalarInteger(static_cast<int>(c.maxActiveReferencePictures)));
+                SET_VECTOR_ELT(res, 12, Rf_ScalarInteger(static_cast<int>(c.maxQualityLevels)));
+                SET_VECTOR_ELT(res, 13, format_vector(c.srcFormats));
+                SET_VECTOR_ELT(res, 14, format_vector(c.dpbFormats));
+            }
+        } catch (...) {}
+        av1r_destroy_instance(inst);
+    } catch (...) {}
+#else
+    (void)r_refresh;
+#endif
+    UNPROTECT(2);
+    return res;
+}
+
+// Element of a named R list (av1r_options()), R_NilValue if absent
+static SEXP opt_elt(SEXP opts, const char* name) {
+    SEXP nms = Rf_getAttrib(opts, R_NamesSymbol);
+    if (Rf_isNull(nms)) return R_NilValue;
+    for (R_xlen_t i = 0; i < Rf_xlength(opts); i++) {
+        if (std::strcmp(CHAR(STRING_ELT(nms, i)), name) == 0) return VECTOR_ELT(opts, i);
+    }
+    return R_NilValue;
+}
+
+// Integer element of a named R list, `def` if absent/NULL/NA
+static int opt_int(SEXP opts, const char* name, int def) {
+    SEXP v = opt_elt(opts, name);
+    if (Rf_isNull(v) || Rf_xlength(v) == 0) return def;
+    int x = Rf_asInteger(v);
+    return x == NA_INTEGER ? def : x;
+}
+
+// Numeric element of a named R list, `def` if absent/NULL/NA
+static double opt_real(SEXP opts, const char* name, double def) {
+    SEXP v = opt_elt(opts, name);
+    if (Rf_isNull(v) || Rf_xlength(v) == 0) return def;
+    double x = Rf_asReal(v);
+    return ISNAN(x) ? def : x;
+}
+
+// R_CheckUserInterrupt() longjmps; under R_ToplevelExec it returns FALSE
+// instead, so native loops can clean up before they error
+static void check_interrupt_fn(void*) { R_CheckUserInterrupt(); }
+
+// User interrupt during a native wait on the R thread: a decode read
+// (Av1rDecodeConfig::interrupted) or the remux. Checked at most every
+// 100 ms; once seen it stays set, so the caller can tell an interrupted
+// wait from a failed one.
+class Av1rInterruptFlag {
+public:
+    bool operator()() {
+        if (seen_) return true;
+        const auto now = std::chrono::steady_clock::now();
+        if (now < next_) return false;
+        next_ = now + std::chrono::milliseconds(100);
+        seen_ = !R_ToplevelExec(check_interrupt_fn, nullptr);
+        return seen_;
+    }
+    bool seen() const { return seen_; }
+private:
+    std::chrono::steady_clock::time_point next_;
+    bool seen_ = false;
+};
+
+// Progress of the native encode loops: av1r_options(progress =,
+// progress_interval =). NULL → console line (default), FALSE → silent,
+// function → called with a record list. The callback runs under R_tryEval:
+// an R error or a FALSE return stops the loop, which then releases the
+// pipe, the IVF and the Vulkan session before Rf_error. frame_done() also
+// checks for a user interrupt (every 100 ms), which stops the loop the
+// same way.
+class Av1rProgressSink {
+public:
+    Av1rProgressSink(SEXP opts, const char* file, int totalFrames, int fps, bool console,
+                     const char* backend = "vulkan")
+        : file_(file), backend_(backend) {
+        SEXP p = opt_elt(opts, "progress");
+        if (Rf_isFunction(p)) callback_ = p;
+        else console_ = console && !(Rf_isLogical(p) && Rf_asLogical(p) == FALSE);
+        meter_.reset(totalFrames, opt_real(opts, "progress_interval", 1.0), fps);
+    }
+    // After each encoded frame; false = stop the encode (see error())
+    bool frame_done(uint64_t packetBytes) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= nextInterruptCheck_) {
+            nextInterruptCheck_ = now + std::chrono::milliseconds(100);
+            if (!R_ToplevelExec(check_interrupt_fn, nullptr)) {
+                error_ = "interrupted";
+                return false;
+            }
+        }
+        if (!meter_.frame_done(packetBytes) || (!callback_ && !console_)) return true;
+        return emit(meter_.report(false));
+    }
+    // Polled while other threads encode (chunked CPU encode): `frames` more
+    // frames and `bytes` more output since the previous call; the caller
+    // checks for interrupts itself
+    bool advance(int frames, uint64_t bytes) {
+        for (int i = 0; i < frames; i++) meter_.frame_done(i == 0 ? bytes : 0);
+        if (!meter_.due() || (!callback_ && !console_)) return true;
+        return emit(meter_.report(false));
+    }
+    void finish() {
+        if (callback_ || console_) emit(meter_.report(true));
+    }
+    const std::string& error() const { return error_; }
+private:
+    bool emit(const Av1rProgress& p) {
+        if (console_) {
+            if (p.frames == 0) return true;
+            if (p.totalFrames > 0 && !p.done)
+                REprintf("\r  [%s] %d/%d frames encoded, %.1f fps, ETA %.0f s  ", backend_,
+                         p.frames, p.totalFrames, p.fps, p.etaSec < 0 ? 0.0 : p.etaSec);
+            else
+                REprintf("\r  [%s] %d frames encoded, %.1f fps%s", backend_, p.frames, p.fps,
+                         p.done ? "\n" : "");
+            return true;
+        }
+        Av1rStatsList rec;
+        rec.add_string("backend", backend_);
+        rec.add_string("file", file_);
+        rec.add("frames", p.frames);
+        rec.add("total_frames", p.totalFrames > 0 ? p.totalFrames : NA_INTEGER);
+        rec.add("fps",          p.fps,        REALSXP);
+        rec.add("elapsed_sec",  p.elapsedSec, REALSXP);
+        rec.add("bytes",        static_cast<double>(p.bytes), REALSXP);
+        rec.add("bitrate_kbps", p.bitrateKbps, REALSXP);
+        rec.add("eta_sec",      p.etaSec < 0 ? NA_REAL : p.etaSec, REALSXP);
+        rec.add("stall_sec",    p.stallSec,   REALSXP);
+        rec.add_logical("stalled", p.stalled);
+        rec.add_logical("done",    p.done);
+        SEXP call = PROTECT(Rf_lang2(callback_, rec.to_sexp()));
+        int failed = 0;
+        SEXP res = R_tryEval(call, R_GlobalEnv, &failed);
+        UNPROTECT(1);
+        if (failed) {
+            error_ = "progress callback failed";
+            return false;
+        }
+        if (!p.done && Rf_isLogical(res) && Rf_length(res) == 1 && LOGICAL(res)[0] == FALSE) {
+            error_ = "cancelled by the progress callback";
+            return false;
+        }
+        return true;
+    }
+
+    Av1rProgressMeter meter_;
+    SEXP        callback_ = nullptr;
+    bool        console_  = false;
+    const char* file_;
+    const char* backend_;
+    std::string error_;
+    std::chrono::steady_clock::time_point nextInterruptCheck_;
+};
+
+// ============================================================================
+// IVF muxer shared by the native encoders (Vulkan, SVT-AV1)
+// ============================================================================
 
 // Minimal IVF muxer (AV1 raw bitstream → IVF container readable by ffmpeg)
 static void write_ivf_header(FILE* f, int width, int height, int fps, int n_frames) {
@@ -137,79 +722,204 @@ static void write_ivf_frame(FILE* f, const uint8_t* data, size_t size, uint64_t
     fwrite(data, 1, size, f);
 }
 
-extern "C" SEXP R_av1r_vulkan_encode(SEXP r_input, SEXP r_output,
-                                      SEXP r_width, SEXP r_height,
-                                      SEXP r_fps,   SEXP r_crf) {
-    const char* input  = CHAR(STRING_ELT(r_input,  0));
-    const char* output = CHAR(STRING_ELT(r_output, 0));
-    int width  = INTEGER(r_width)[0];
-    int height = INTEGER(r_height)[0];
-    int fps    = INTEGER(r_fps)[0];
-    int crf    = INTEGER(r_crf)[0];
+// Patch the frame count into a header written with 0 frames, close the file
+static void close_ivf(FILE* f, int n_frames) {
+    fseek(f, 24, SEEK_SET);
+    uint8_t fc[4] = {
+        static_cast<uint8_t>(n_frames & 0xFF),
+        static_cast<uint8_t>((n_frames >> 8) & 0xFF),
+        static_cast<uint8_t>((n_frames >> 16) & 0xFF),
+        static_cast<uint8_t>((n_frames >> 24) & 0xFF)
+    };
+    fwrite(fc, 1, 4, f);
+    fclose(f);
+}
 
-    // Align to even (NV12 requirement)
-    width  = width  & ~1;
-    height = height & ~1;
+// Wrap IVF → MP4 (or MKV) via ffmpeg, audio copied from the input;
+// ffmpeg's exit status. ffmpeg runs in the job pool while the R thread
+// polls `interrupted`; on an interrupt it gets SIGTERM and the partial
+// output is removed.
+static int remux_ivf(const std::string& ivf, const char* input, const char* output,
+                     Av1rInterruptFlag& interrupted) {
+    std::string wrap_cmd = std::string("ffmpeg -y -i \"") + ivf +
+        "\" -i \"" + input + "\" -map 0:v -map 1:a? -c:v copy -c:a copy"
+        " -movflags +faststart \"" +
+        output + "\" 2>/dev/null";
+    Av1rJobPool pool(std::vector<std::vector<std::string>>(1, std::vector<std::string>(1, wrap_cmd)),
+                     std::vector<std::string>(1, "ffmpeg remux"));
+    pool.start(std::vector<int>(1, 1));
+    bool killed = false;
+    while (!pool.finished()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (!killed && interrupted()) {
+            pool.kill(SIGTERM);
+            killed = true;
+        }
+    }
+    pool.join();
+    if (killed) remove(output);
+    return pool.job(0).status;
+}
+
+// ============================================================================
+// R_av1r_vulkan_encode(input, output, width, height, fps, options)
+// ffmpeg декодирует input в NV12 через pipe → C++ encode → IVF файл
+// options — список av1r_options(); возвращает список статистики кодирования
+// ============================================================================
+#ifdef AV1R_VULKAN_VIDEO_AV1
+
+#include "av1r_stream_encoder.h"
+
+// Instance, device and both queues of the encoder context
+static void init_encode_ctx(Av1rVulkanCtx& ctx) {
+    ctx.instance   = av1r_create_instance();
+    ctx.physDevice = av1r_select_device(ctx.instance, -1);
+    uint32_t encQfam  = UINT32_MAX;
+    uint32_t xferQfam = UINT32_MAX;
+    ctx.device     = av1r_create_logical_device(ctx.physDevice, &encQfam, &xferQfam);
+    ctx.encodeQueue.queue_family_index = encQfam;
+    vkGetDeviceQueue(ctx.device, encQfam, 0, &ctx.encodeQueue.queue);
+    ctx.transferQueue.queue_family_index = xferQfam;
+    vkGetDeviceQueue(ctx.device, xferQfam, 0, &ctx.transferQueue.queue);
+    ctx.initialized = true;
+}
+
+// Encoder settings from av1r_options(), shared by the file encode, the stub
+// benchmark and av1r_benchmark(); frame size, fps and source format are
+// set by the caller
+static void encode_config_from_options(SEXP r_options, Av1rEncodeConfig& cfg) {
+    cfg.crf    = opt_int(r_options, "crf", cfg.crf);
+    cfg.preset = opt_int(r_options, "preset", cfg.preset);
+    cfg.staticThreshold = opt_real(r_options, "static_threshold", cfg.staticThreshold);
+    cfg.keyintMax = opt_int(r_options, "keyint", cfg.keyintMax);
+    cfg.keyintMin = opt_int(r_options, "min_keyint", cfg.keyintMin);
+    cfg.sceneCut  = opt_real(r_options, "scenecut", cfg.sceneCut);
+    cfg.maxTiles  = opt_int(r_options, "tiles", cfg.maxTiles);
+    cfg.gpuTiming = opt_int(r_options, "gpu_timing", 0) != 0;
+}
+
+// Encoder statistics shared by R_av1r_vulkan_encode and the stub benchmark
+static void add_encoder_stats(Av1rStatsList& stats, const Av1rStreamEncoder* se,
+                              bool gpu_timing) {
+    stats.add("quality_level",      av1r_vulkan_stream_stats(se).qualityLevel);
+    stats.add("max_quality_levels", av1r_vulkan_stream_stats(se).maxQualityLevels);
+    stats.add("skipped_frames",     av1r_vulkan_stream_stats(se).skippedFrames);
+    stats.add("scene_cuts",         av1r_vulkan_stream_stats(se).sceneCuts);
+    stats.add_vector("keyframes",   av1r_vulkan_stream_stats(se).keyframes);
+    stats.add("tile_cols",          av1r_vulkan_stream_stats(se).tileCols);
+    stats.add("tile_rows",          av1r_vulkan_stream_stats(se).tileRows);
+    stats.add_logical("tile_uniform", av1r_vulkan_stream_stats(se).tileUniform);
+    stats.add_string("convert",     av1r_vulkan_stream_stats(se).convert);
+    if (gpu_timing) {
+        // Per-frame stage timings as flat columns; R/convert.R builds the data.frame
+        const Av1rEncodeStats& st = av1r_vulkan_stream_stats(se);
+        const size_t n = st.timings.size();
+        std::vector<double> fr(n), cv(n), up(n), en(n), rb(n), sy(n);
+        auto na = [](double x) { return std::isnan(x) ? NA_REAL : x; };
+        for (size_t i = 0; i < n; i++) {
+            fr[i] = st.timings[i].frame;
+            cv[i] = na(st.timings[i].convertMs);
+            up[i] = na(st.timings[i].uploadMs);
+            en[i] = na(st.timings[i].encodeMs);
+            rb[i] = na(st.timings[i].readbackMs);
+            sy[i] = na(st.timings[i].syncMs);
+        }
+        stats.add_logical("timing_transfer", st.timingTransfer);
+        stats.add_logical("timing_encode",   st.timingEncode);
+        stats.add("timestamp_period_ns", st.timestampPeriodNs, REALSXP);
+        stats.add_vector("timing_frame",       fr);
+        stats.add_vector("timing_convert_ms",  cv, REALSXP);
+        stats.add_vector("timing_upload_ms",   up, REALSXP);
+        stats.add_vector("timing_encode_ms",   en, REALSXP);
+        stats.add_vector("timing_readback_ms", rb, REALSXP);
+        stats.add_vector("timing_sync_ms",     sy, REALSXP);
+    }
+}
+
+// Body of R_av1r_vulkan_encode. Never calls Rf_error: the memory scope,
+// denoiser, progress sink and buffers must be destroyed before the caller
+// raises `err`, or av1r_memory() keeps counting them after a failed encode.
+static bool vulkan_encode_file(const char* input, const char* output,
+                               int width, int height, int fps,
+                               Av1rPixFmt src_fmt, uint32_t win_lo, uint32_t win_hi,
+                               SEXP r_options, Av1rStatsList& stats, std::string& err) {
+    // Memory used by this encode (host buffers + Vulkan allocations)
+    Av1rMemAccountPtr mem = std::make_shared<Av1rMemAccount>();
+    Av1rMemScope memScope(mem);
 
     // Init Vulkan first — we need physDevice to query min encode extent
     Av1rVulkanCtx ctx{};
     try {
-        ctx.instance   = av1r_create_instance();
-        ctx.physDevice = av1r_select_device(ctx.instance, 0);
-        uint32_t encQfam  = UINT32_MAX;
-        uint32_t xferQfam = UINT32_MAX;
-        ctx.device     = av1r_create_logical_device(ctx.physDevice, &encQfam, &xferQfam);
-        ctx.encodeQueue.queue_family_index = encQfam;
-        vkGetDeviceQueue(ctx.device, encQfam, 0, &ctx.encodeQueue.queue);
-        ctx.transferQueue.queue_family_index = xferQfam;
-        vkGetDeviceQueue(ctx.device, xferQfam, 0, &ctx.transferQueue.queue);
-        ctx.initialized = true;
+        AV1R_TRACE_SPAN("vulkan init", "vulkan");
+        init_encode_ctx(ctx);
     } catch (const std::exception& e) {
-        Rf_error("Vulkan init failed: %s", e.what());
+        err = std::string("Vulkan init failed: ") + e.what();
+        return false;
     }
 
-    // Query minimum encode resolution and scale up if needed
-    uint32_t minW = 0, minH = 0;
-    av1r_vulkan_query_min_extent(ctx.instance, ctx.physDevice, &minW, &minH);
+    // Minimum encode resolution from the capability registry; scale up if needed
+    const Av1rVulkanCaps& caps = av1r_vulkan_caps(ctx.instance, ctx.physDevice);
+    uint32_t minW = caps.minWidth, minH = caps.minHeight;
     if ((uint32_t)width  < minW) width  = (int)minW;
     if ((uint32_t)height < minH) height = (int)minH;
     // Re-align after possible adjustment
     width  = width  & ~1;
     height = height & ~1;
 
-    size_t frame_bytes = static_cast<size_t>(width * height * 3 / 2);
-
-    // ffmpeg pipe: decode to raw NV12
-    // Image sequences (printf pattern with %) and TIFF need -framerate before -i
-    std::string inp(input);
-    bool is_image_seq = (inp.find('%') != std::string::npos) ||
-        (inp.size() >= 4 && (inp.compare(inp.size()-4, 4, ".tif") == 0 ||
-                              inp.compare(inp.size()-5, 5, ".tiff") == 0));
+    size_t frame_bytes = av1r_pix_fmt_frame_bytes(src_fmt, width, height);
 
-    std::string cmd = "ffmpeg";
-    if (is_image_seq) cmd += " -framerate " + std::to_string(fps);
-    cmd += " -i \"" + inp + "\""
-           " -f rawvideo -pix_fmt nv12"
-           " -vf scale=" + std::to_string(width) + ":" + std::to_string(height) +
-           " -an - 2>/dev/null";
-
-    FILE* pipe = popen(cmd.c_str(), "r");
-    if (!pipe) {
+    // Decode to raw frames (NV12 or src_format): in-process libav when built
+    // with it, else (or when libav cannot open the input) the ffmpeg pipe
+    Av1rDecodeConfig dcfg;
+    dcfg.input     = input;
+    dcfg.width     = width;
+    dcfg.height    = height;
+    dcfg.fps       = fps;
+    dcfg.maxFrames = opt_int(r_options, "max_frames", 0);
+    dcfg.threads   = opt_int(r_options, "threads", 0);
+    dcfg.format    = src_fmt;
+    Av1rInterruptFlag interrupted;
+    dcfg.interrupted = std::ref(interrupted);
+    SEXP r_log = opt_elt(r_options, "decode_log");
+    if (Rf_isString(r_log) && Rf_length(r_log) == 1) dcfg.logFile = CHAR(STRING_ELT(r_log, 0));
+    const int max_frames = dcfg.maxFrames;
+    std::unique_ptr<Av1rFrameSource> source;
+    std::string decode_note;
+    try {
+        source = av1r_libav_source(dcfg);
+    } catch (const std::exception& e) {
+        decode_note = e.what();
+    }
+    try {
+        // an interrupt while libav opened the input is not a reason to retry
+        if (interrupted.seen()) throw std::runtime_error("interrupted");
+        if (!source) source = av1r_pipe_source(dcfg);
+    } catch (const std::exception& e) {
         av1r_destroy_logical_device(ctx.device);
         av1r_destroy_instance(ctx.instance);
-        Rf_error("Failed to open ffmpeg pipe");
+        err = e.what();
+        return false;
     }
 
     // Init streaming encoder
     Av1rStreamEncoder* se = av1r_vulkan_stream_new();
     try {
-        av1r_vulkan_stream_init(ctx, se, width, height, fps, crf);
+        Av1rEncodeConfig cfg;
+        cfg.width  = width;
+        cfg.height = height;
+        cfg.fps    = fps;
+        encode_config_from_options(r_options, cfg);
+        cfg.srcFormat = src_fmt;
+        cfg.windowLo  = win_lo;
+        cfg.windowHi  = win_hi;
+        av1r_vulkan_stream_init(ctx, se, cfg);
     } catch (const std::exception& e) {
         av1r_vulkan_stream_delete(se);
-        pclose(pipe);
+        source.reset();
         av1r_destroy_logical_device(ctx.device);
         av1r_destroy_instance(ctx.instance);
-        Rf_error("Vulkan encoder init failed: %s", e.what());
+        err = std::string("Vulkan encoder init failed: ") + e.what();
+        return false;
     }
 
     // Open IVF output (write header with 0 frames, update later)
@@ -218,25 +928,58 @@ extern "C" SEXP R_av1r_vulkan_encode(SEXP r_input, SEXP r_output,
     if (!fout) {
         av1r_vulkan_stream_finish(se);
         av1r_vulkan_stream_delete(se);
-        pclose(pipe);
+        source.reset();
         av1r_destroy_logical_device(ctx.device);
         av1r_destroy_instance(ctx.instance);
-        Rf_error("Cannot write output IVF: %s", ivf_tmp.c_str());
+        err = "Cannot write output IVF: " + ivf_tmp;
+        return false;
     }
     write_ivf_header(fout, width, height, fps, 0);
 
     // Stream: read one frame → encode → write IVF packet → repeat
     std::vector<uint8_t> frame_buf(frame_bytes);
     std::vector<uint8_t> packet;
+    Av1rMemCharge frameMem, packetMem;
+    frameMem.set(AV1R_MEM_HOST, "frame buffer", frame_buf.capacity());
     int n_frames = 0;
+    uint64_t out_bytes = 0;
+
+    // Optional temporal denoise between the decoder and the upload (NV12 only)
+    Av1rTemporalDenoiser denoiser;
+    denoiser.reset(width, height,
+                   src_fmt == AV1R_PIX_NV12 ? opt_real(r_options, "denoise", 0.0) : 0.0,
+                   opt_int(r_options, "threads", 0));
+    double denoise_sec = 0.0;
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point t_start = Clock::now();
     bool encode_error = false;
     std::string error_msg;
 
+    // ETA needs the frame count: probed by R (total_frames), capped by max_frames
+    int total_frames = opt_int(r_options, "total_frames", 0);
+    if (max_frames > 0 && (total_frames <= 0 || total_frames > max_frames))
+        total_frames = max_frames;
+    Av1rProgressSink progress(r_options, input, total_frames, fps, true);
+
     while (true) {
-        size_t got = fread(frame_buf.data(), 1, frame_bytes, pipe);
-        if (got != frame_bytes) break;
+        if (!source->read(frame_buf.data())) {
+            if (!source->error().empty()) {
+                encode_error = true;
+                error_msg = source->error();
+            }
+            break;
+        }
+
+        if (denoiser.enabled()) {
+            AV1R_TRACE_SPAN("denoise", "filter");
+            const Clock::time_point t0 = Clock::now();
+            denoiser.apply(frame_buf.data());
+            denoise_sec += std::chrono::duration<double>(Clock::now() - t0).count();
+        }
 
         try {
+            Av1rTraceSpan span("encode frame", "encode");
+            span.args("\"frame\":" + std::to_string(n_frames));
             av1r_vulkan_stream_encode(se, frame_buf.data(), n_frames, packet);
         } catch (const std::exception& e) {
             encode_error = true;
@@ -244,67 +987,1261 @@ extern "C" SEXP R_av1r_vulkan_encode(SEXP r_input, SEXP r_output,
             break;
         }
 
+        const int64_t tTrace = av1r_trace_now_us();
         write_ivf_frame(fout, packet.data(), packet.size(),
                         static_cast<uint64_t>(n_frames));
+        av1r_trace_span("ivf write", "io", tTrace, av1r_trace_now_us() - tTrace);
+        out_bytes += packet.size();
+        packetMem.set(AV1R_MEM_HOST, "packet", packet.capacity());
         n_frames++;
 
-        if (n_frames % 100 == 0)
-            REprintf("\r  [vulkan] %d frames encoded", n_frames);
+        if (!progress.frame_done(packet.size())) {
+            encode_error = true;
+            error_msg = progress.error();
+            break;
+        }
     }
-    if (n_frames > 0) REprintf("\r  [vulkan] %d frames encoded\n", n_frames);
 
-    pclose(pipe);
+    const std::string decoder = source->name();
+    source.reset();
+    const double encode_sec = std::chrono::duration<double>(Clock::now() - t_start).count();
+    stats.add("n_frames", n_frames);
+    stats.add("bytes",        static_cast<double>(out_bytes), REALSXP);
+    stats.add("bitrate_kbps", n_frames > 0 && fps > 0
+                              ? static_cast<double>(out_bytes) * 8.0 * fps / n_frames / 1000.0
+                              : 0.0, REALSXP);
+    stats.add("encode_sec",   encode_sec,  REALSXP);
+    stats.add("denoise_sec",  denoise_sec, REALSXP);
+    stats.add_string("decoder", decoder.c_str());
+    if (!decode_note.empty()) stats.add_string("decoder_note", decode_note.c_str());
+    add_encoder_stats(stats, se, opt_int(r_options, "gpu_timing", 0) != 0);
+    add_memory_stats(stats, *mem);
+    frameMem.release();
+    packetMem.release();
     av1r_vulkan_stream_finish(se);
     av1r_vulkan_stream_delete(se);
 
     // Update IVF header with actual frame count
-    fseek(fout, 24, SEEK_SET);
-    uint8_t fc[4] = {
-        static_cast<uint8_t>(n_frames & 0xFF),
-        static_cast<uint8_t>((n_frames >> 8) & 0xFF),
-        static_cast<uint8_t>((n_frames >> 16) & 0xFF),
-        static_cast<uint8_t>((n_frames >> 24) & 0xFF)
-    };
-    fwrite(fc, 1, 4, fout);
-    fclose(fout);
+    close_ivf(fout, n_frames);
 
     av1r_destroy_logical_device(ctx.device);
     av1r_destroy_instance(ctx.instance);
 
     if (encode_error) {
         remove(ivf_tmp.c_str());
-        Rf_error("Vulkan encode failed: %s", error_msg.c_str());
+        err = "Vulkan encode failed (" + decoder + " decode): " + error_msg;
+        return false;
     }
 
     if (n_frames == 0) {
         remove(ivf_tmp.c_str());
-        Rf_error("No frames decoded from input");
+        err = "No frames decoded from input";
+        return false;
     }
 
     // Wrap IVF → MP4 via ffmpeg
-    std::string wrap_cmd = std::string("ffmpeg -y -i \"") + ivf_tmp +
-        "\" -i \"" + input + "\" -map 0:v -map 1:a? -c:v copy -c:a copy"
-        " -movflags +faststart \"" +
-        output + "\" 2>/dev/null";
-    int ret = system(wrap_cmd.c_str());
+    const int ret = remux_ivf(ivf_tmp, input, output, interrupted);
     remove(ivf_tmp.c_str());
+    if (interrupted.seen()) {
+        err = "interrupted";
+        return false;
+    }
+    if (ret != 0) {
+        err = "ffmpeg mux failed (exit " + std::to_string(ret) + ")";
+        return false;
+    }
+    progress.finish();
+    return true;
+}
+
+extern "C" SEXP R_av1r_vulkan_encode(SEXP r_input, SEXP r_output,
+                                      SEXP r_width, SEXP r_height,
+                                      SEXP r_fps,   SEXP r_options) {
+    const char* input  = CHAR(STRING_ELT(r_input,  0));
+    const char* output = CHAR(STRING_ELT(r_output, 0));
+    // Align to even (NV12 requirement)
+    const int width  = INTEGER(r_width)[0]  & ~1;
+    const int height = INTEGER(r_height)[0] & ~1;
+    const int fps    = INTEGER(r_fps)[0];
+
+    // Source format for the pipe: NV12 by default; with gpu_convert the R side
+    // passes the file's native layout and the encoder converts it to NV12
+    SEXP r_src_fmt = opt_elt(r_options, "src_format");
+    const Av1rPixFmt src_fmt = Rf_isNull(r_src_fmt) ? AV1R_PIX_NV12 : parse_pix_fmt(r_src_fmt);
+    uint32_t win_lo, win_hi;
+    parse_window(opt_elt(r_options, "window"), &win_lo, &win_hi);
+
+    Av1rStatsList stats;
+    std::string err;
+    if (!vulkan_encode_file(input, output, width, height, fps, src_fmt, win_lo, win_hi,
+                            r_options, stats, err))
+        Rf_error("%s", err.c_str());
+    return stats.to_sexp();
+}
+
+// ============================================================================
+// R_av1r_vulkan_encode_bench(width, height, frames, output, options)  →  list
+// Encodes synthetic NV12 frames without ffmpeg and measures host time per
+// frame (struct building, submission, readback, IVF write). Under
+// AV1R_VULKAN_STUB the driver work is negligible, so frame_ms is the CPU
+// overhead of the encode path itself. output = "" skips the IVF.
+// ============================================================================
+// Body of R_av1r_vulkan_encode_bench; like vulkan_encode_file it reports
+// failures through `err` so the encode state is gone before Rf_error
+static bool vulkan_encode_bench(int width, int height, int frames, const char* output,
+                                SEXP r_options, Av1rStatsList& stats, std::string& err) {
+    const int fps = 30;
+    Av1rMemAccountPtr mem = std::make_shared<Av1rMemAccount>();
+    Av1rMemScope memScope(mem);
+
+    Av1rVulkanCtx ctx{};
+    try {
+        init_encode_ctx(ctx);
+    } catch (const std::exception& e) {
+        err = std::string("Vulkan init failed: ") + e.what();
+        return false;
+    }
+    const bool stub = av1r_vk_stub_active();
+    char devName[256] = "";
+    av1r_device_name(ctx.physDevice, devName, sizeof(devName));
+
+    Av1rStreamEncoder* se = av1r_vulkan_stream_new();
+    try {
+        Av1rEncodeConfig cfg;
+        cfg.width  = width;
+        cfg.height = height;
+        cfg.fps    = fps;
+        encode_config_from_options(r_options, cfg);
+        av1r_vulkan_stream_init(ctx, se, cfg);
+    } catch (const std::exception& e) {
+        av1r_vulkan_stream_delete(se);
+        av1r_destroy_logical_device(ctx.device);
+        av1r_destroy_instance(ctx.instance);
+        err = std::string("Vulkan encoder init failed: ") + e.what();
+        return false;
+    }
+
+    FILE* fout = nullptr;
+    if (output[0] != '\0') {
+        fout = fopen(output, "wb");
+        if (fout) write_ivf_header(fout, width, height, fps, frames);
+    }
+
+    // Moving diagonal ramp: every frame differs, so none is skipped as static
+    std::vector<uint8_t> frame(av1r_pix_fmt_frame_bytes(AV1R_PIX_NV12, width, height));
+    std::vector<uint8_t> packet;
+    Av1rMemCharge frameMem, packetMem;
+    frameMem.set(AV1R_MEM_HOST, "frame buffer", frame.capacity());
+    std::vector<double> frame_ms;
+    frame_ms.reserve(frames);
+    uint64_t out_bytes = 0;
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point t_start = Clock::now();
+    std::string error_msg;
+    Av1rProgressSink progress(r_options, "synthetic", frames, fps, false);
+
+    for (int i = 0; i < frames; i++) {
+        uint8_t* y = frame.data();
+        for (int r = 0; r < height; r++)
+            for (int c = 0; c < width; c++)
+                y[static_cast<size_t>(r) * width + c] = static_cast<uint8_t>((r + c + 4 * i) & 0xFF);
+        std::memset(frame.data() + static_cast<size_t>(width) * height, 128,
+                    static_cast<size_t>(width) * height / 2);
+
+        const Clock::time_point t0 = Clock::now();
+        try {
+            av1r_vulkan_stream_encode(se, frame.data(), i, packet);
+        } catch (const std::exception& e) {
+            error_msg = e.what();
+            break;
+        }
+        if (fout) write_ivf_frame(fout, packet.data(), packet.size(), static_cast<uint64_t>(i));
+        frame_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+        out_bytes += packet.size();
+        packetMem.set(AV1R_MEM_HOST, "packet", packet.capacity());
+        if (!progress.frame_done(packet.size())) {
+            error_msg = progress.error();
+            break;
+        }
+    }
+    const double encode_sec = std::chrono::duration<double>(Clock::now() - t_start).count();
+    if (fout) fclose(fout);
+
+    const int n_frames = static_cast<int>(frame_ms.size());
+    stats.add_string("driver", stub ? "stub" : "vulkan");
+    stats.add_string("device", devName);
+    stats.add("n_frames", n_frames);
+    stats.add("bytes",        static_cast<double>(out_bytes), REALSXP);
+    stats.add("bitrate_kbps", n_frames > 0
+                              ? static_cast<double>(out_bytes) * 8.0 * fps / n_frames / 1000.0
+                              : 0.0, REALSXP);
+    stats.add("encode_sec",   encode_sec, REALSXP);
+    stats.add_vector("frame_ms", frame_ms, REALSXP);
+    add_encoder_stats(stats, se, opt_int(r_options, "gpu_timing", 0) != 0);
+    add_memory_stats(stats, *mem);
+    frameMem.release();
+    packetMem.release();
+    av1r_vulkan_stream_finish(se);
+    av1r_vulkan_stream_delete(se);
+    av1r_destroy_logical_device(ctx.device);
+    av1r_destroy_instance(ctx.instance);
 
-    if (ret != 0)
-        Rf_error("ffmpeg mux failed (exit %d)", ret);
+    if (!error_msg.empty()) {
+        if (fout) remove(output);
+        err = "Vulkan encode failed: " + error_msg;
+        return false;
+    }
+    progress.finish();
+    return true;
+}
+
+extern "C" SEXP R_av1r_vulkan_encode_bench(SEXP r_width, SEXP r_height, SEXP r_frames,
+                                            SEXP r_output, SEXP r_options) {
+    const int width  = Rf_asInteger(r_width), height = Rf_asInteger(r_height);
+    const int frames = Rf_asInteger(r_frames);
+    if (width == NA_INTEGER || height == NA_INTEGER || width <= 0 || height <= 0 ||
+        (width | height) & 1)
+        Rf_error("vulkan_encode_bench: positive even width and height expected");
+    if (frames == NA_INTEGER || frames <= 0)
+        Rf_error("vulkan_encode_bench: frames must be positive");
+    const char* output = CHAR(STRING_ELT(r_output, 0));
 
-    return Rf_ScalarInteger(0);
+    Av1rStatsList stats;
+    std::string err;
+    if (!vulkan_encode_bench(width, height, frames, output, r_options, stats, err))
+        Rf_error("%s", err.c_str());
+    return stats.to_sexp();
 }
 #endif // AV1R_VULKAN_VIDEO_AV1
 
+// ============================================================================
+// R_av1r_svt_encode(input, output, width, height, fps, options)  →  list
+// Same pipeline as R_av1r_vulkan_encode with libSvtAv1Enc in place of the
+// GPU: frame source (libav or ffmpeg pipe, I420) → denoise → SVT-AV1 →
+// IVF → remux. Packets lag the input by the lookahead and are drained
+// after the last frame.
+// ============================================================================
+// Body of R_av1r_svt_encode; failures go to `err`, raised by the caller once
+// the encoder, source and buffers are freed
+static bool svt_encode_file(const char* input, const char* output,
+                            int width, int height, int fps,
+                            SEXP r_options, Av1rStatsList& stats, std::string& err) {
+    Av1rMemAccountPtr mem = std::make_shared<Av1rMemAccount>();
+    Av1rMemScope memScope(mem);
+
+    Av1rDecodeConfig dcfg;
+    dcfg.input     = input;
+    dcfg.width     = width;
+    dcfg.height    = height;
+    dcfg.fps       = fps;
+    dcfg.maxFrames = opt_int(r_options, "max_frames", 0);
+    dcfg.threads   = opt_int(r_options, "threads", 0);
+    dcfg.format    = AV1R_PIX_I420;
+    Av1rInterruptFlag interrupted;
+    dcfg.interrupted = std::ref(interrupted);
+    SEXP r_log = opt_elt(r_options, "decode_log");
+    if (Rf_isString(r_log) && Rf_length(r_log) == 1) dcfg.logFile = CHAR(STRING_ELT(r_log, 0));
+
+    Av1rSvtConfig cfg;
+    cfg.width     = width;
+    cfg.height    = height;
+    cfg.fps       = fps;
+    cfg.crf       = opt_int(r_options, "crf", cfg.crf);
+    cfg.preset    = opt_int(r_options, "preset", cfg.preset);
+    cfg.threads   = opt_int(r_options, "threads", cfg.threads);
+    cfg.lookahead = opt_int(r_options, "lookahead", cfg.lookahead);
+    cfg.keyintMax = opt_int(r_options, "keyint", cfg.keyintMax);
+    std::unique_ptr<Av1rSvtEncoder> enc;
+    try {
+        enc.reset(new Av1rSvtEncoder(cfg));
+    } catch (const std::exception& e) {
+        err = std::string("SVT-AV1 encoder init failed: ") + e.what();
+        return false;
+    }
+
+    std::unique_ptr<Av1rFrameSource> source;
+    std::string decode_note;
+    try {
+        source = av1r_libav_source(dcfg);
+    } catch (const std::exception& e) {
+        decode_note = e.what();
+    }
+    try {
+        // an interrupt while libav opened the input is not a reason to retry
+        if (interrupted.seen()) throw std::runtime_error("interrupted");
+        if (!source) source = av1r_pipe_source(dcfg);
+    } catch (const std::exception& e) {
+        enc.reset();
+        err = e.what();
+        return false;
+    }
+
+    std::string ivf_tmp = std::string(output) + ".ivf";
+    FILE* fout = fopen(ivf_tmp.c_str(), "wb");
+    if (!fout) {
+        source.reset();
+        enc.reset();
+        err = "Cannot write output IVF: " + ivf_tmp;
+        return false;
+    }
+    write_ivf_header(fout, width, height, fps, 0);
+
+    std::vector<uint8_t> frame_buf(av1r_pix_fmt_frame_bytes(AV1R_PIX_I420, width, height));
+    Av1rSvtPacket packet;
+    Av1rMemCharge frameMem, packetMem;
+    frameMem.set(AV1R_MEM_HOST, "frame buffer", frame_buf.capacity());
+
+    // The temporal filter works per sample, so the I420 planes pass as one block
+    Av1rTemporalDenoiser denoiser;
+    denoiser.reset(width, height, opt_real(r_options, "denoise", 0.0),
+                   opt_int(r_options, "threads", 0));
+    double denoise_sec = 0.0;
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point t_start = Clock::now();
+
+    int total_frames = opt_int(r_options, "total_frames", 0);
+    if (dcfg.maxFrames > 0 && (total_frames <= 0 || total_frames > dcfg.maxFrames))
+        total_frames = dcfg.maxFrames;
+    Av1rProgressSink progress(r_options, input, total_frames, fps, true, "svt");
+
+    int n_in = 0, n_frames = 0;
+    uint64_t out_bytes = 0;
+    std::vector<int> keyframes;
+    std::string error_msg;
+    bool input_done = false;
+    try {
+        while (!enc->done()) {
+            if (!input_done) {
+                if (source->read(frame_buf.data())) {
+                    if (denoiser.enabled()) {
+                        AV1R_TRACE_SPAN("denoise", "filter");
+                        const Clock::time_point t0 = Clock::now();
+                        denoiser.apply(frame_buf.data());
+                        denoise_sec += std::chrono::duration<double>(Clock::now() - t0).count();
+                    }
+                    Av1rTraceSpan span("encode frame", "encode");
+                    span.args("\"frame\":" + std::to_string(n_in));
+                    enc->send(frame_buf.data(), n_in++);
+                } else {
+                    error_msg = source->error();
+                    if (!error_msg.empty()) break;
+                    enc->finish();
+                    input_done = true;
+                }
+            }
+            // Everything the encoder has ready; after finish() this waits
+            bool got;
+            while (true) {
+                {
+                    AV1R_TRACE_SPAN("svt packet", "encode");
+                    got = enc->receive(packet);
+                }
+                if (!got) break;
+                const int64_t tTrace = av1r_trace_now_us();
+                write_ivf_frame(fout, packet.data.data(), packet.data.size(),
+                                static_cast<uint64_t>(packet.pts));
+                av1r_trace_span("ivf write", "io", tTrace, av1r_trace_now_us() - tTrace);
+                if (packet.keyframe) keyframes.push_back(static_cast<int>(packet.pts));
+                out_bytes += packet.data.size();
+                packetMem.set(AV1R_MEM_HOST, "packet", packet.data.capacity());
+                n_frames++;
+                if (!progress.frame_done(packet.data.size())) {
+                    error_msg = progress.error();
+                    break;
+                }
+            }
+            if (!error_msg.empty()) break;
+        }
+    } catch (const std::exception& e) {
+        error_msg = e.what();
+    }
+
+    const std::string decoder = source->name();
+    source.reset();
+    enc.reset();
+    const double encode_sec = std::chrono::duration<double>(Clock::now() - t_start).count();
+    stats.add("n_frames", n_frames);
+    stats.add("bytes",        static_cast<double>(out_bytes), REALSXP);
+    stats.add("bitrate_kbps", n_frames > 0 && fps > 0
+                              ? static_cast<double>(out_bytes) * 8.0 * fps / n_frames / 1000.0
+                              : 0.0, REALSXP);
+    stats.add("encode_sec",   encode_sec,  REALSXP);
+    stats.add("denoise_sec",  denoise_sec, REALSXP);
+    stats.add_string("decoder", decoder.c_str());
+    if (!decode_note.empty()) stats.add_string("decoder_note", decode_note.c_str());
+    stats.add_vector("keyframes", keyframes);
+    stats.add("lookahead", cfg.lookahead >= 0 ? cfg.lookahead : NA_INTEGER);
+    stats.add_string("svt_version", av1r_svt_version().c_str());
+    add_memory_stats(stats, *mem);
+    frameMem.release();
+    packetMem.release();
+    close_ivf(fout, n_frames);
+
+    if (!error_msg.empty()) {
+        remove(ivf_tmp.c_str());
+        err = "SVT-AV1 encode failed (" + decoder + " decode): " + error_msg;
+        return false;
+    }
+    if (n_frames == 0) {
+        remove(ivf_tmp.c_str());
+        err = "No frames decoded from input";
+        return false;
+    }
+
+    const int ret = remux_ivf(ivf_tmp, input, output, interrupted);
+    remove(ivf_tmp.c_str());
+    if (interrupted.seen()) {
+        err = "interrupted";
+        return false;
+    }
+    if (ret != 0) {
+        err = "ffmpeg mux failed (exit " + std::to_string(ret) + ")";
+        return false;
+    }
+    progress.finish();
+    return true;
+}
+
+extern "C" SEXP R_av1r_svt_encode(SEXP r_input, SEXP r_output,
+                                   SEXP r_width, SEXP r_height,
+                                   SEXP r_fps,   SEXP r_options) {
+    const char* input  = CHAR(STRING_ELT(r_input,  0));
+    const char* output = CHAR(STRING_ELT(r_output, 0));
+    // I420 needs even dimensions
+    const int width  = INTEGER(r_width)[0]  & ~1;
+    const int height = INTEGER(r_height)[0] & ~1;
+    const int fps    = INTEGER(r_fps)[0];
+
+    Av1rStatsList stats;
+    std::string err;
+    if (!svt_encode_file(input, output, width, height, fps, r_options, stats, err))
+        Rf_error("%s", err.c_str());
+    return stats.to_sexp();
+}
+
+// ============================================================================
+// R_av1r_benchmark(width, height, bits, frames, encode, output, options)  →  list
+// Per-stage timings (ms per frame) on synthetic fluorescence frames (see
+// av1r_bench.h): source = frame generation, convert = gray16 → NV12,
+// upload / encode / readback / sync = Vulkan encoder stages (GPU timestamps
+// with gpu_timing), obu = OBU walk of the packet, mux = IVF write.
+// Stages that did not run are NA. encode = FALSE times source + CPU convert.
+// ============================================================================
+// Body of R_av1r_benchmark: scene, buffers and encoder are freed before the
+// caller raises `err`
+static bool run_benchmark(int w, int h, int bits, int frames, bool encode,
+                          const char* output, uint32_t win_lo, uint32_t win_hi,
+                          SEXP r_options, Av1rStatsList& res, std::string& err) {
+    Av1rSynthScene scene;
+    try {
+        scene.reset(w, h, bits, 0xA1Bu);
+    } catch (const std::exception& e) {
+        err = std::string("benchmark: ") + e.what();
+        return false;
+    }
+    const Av1rPixFmt src_fmt = bits == 16 ? AV1R_PIX_GRAY16 : AV1R_PIX_NV12;
+
+    std::vector<uint8_t> src(scene.frame_bytes());
+    std::vector<uint8_t> nv12(av1r_pix_fmt_frame_bytes(AV1R_PIX_NV12, w, h));
+    const size_t n = static_cast<size_t>(frames);
+    std::vector<double> source(n, NA_REAL), convert(n, NA_REAL), upload(n, NA_REAL),
+                        enc(n, NA_REAL), readback(n, NA_REAL), sync(n, NA_REAL),
+                        obu(n, NA_REAL), mux(n, NA_REAL);
+    typedef std::chrono::steady_clock Clock;
+    auto ms_since = [](Clock::time_point t0) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    };
+
+    std::string driver = "none", convert_mode = src_fmt == AV1R_PIX_NV12 ? "none" : "cpu";
+    char devName[256] = "";
+    double out_bytes = 0.0;
+    Av1rObuCounts counts;
+
+    if (!encode) {
+        for (size_t i = 0; i < n; i++) {
+            Clock::time_point t0 = Clock::now();
+            scene.render(static_cast<int>(i), src.data());
+            source[i] = ms_since(t0);
+            if (src_fmt != AV1R_PIX_NV12) {
+                t0 = Clock::now();
+                av1r_convert_to_nv12_cpu(src_fmt, src.data(), nv12.data(), w, h, win_lo, win_hi);
+                convert[i] = ms_since(t0);
+            }
+        }
+    } else {
+#ifdef AV1R_VULKAN_VIDEO_AV1
+        Av1rVulkanCtx ctx{};
+        try {
+            init_encode_ctx(ctx);
+        } catch (const std::exception& e) {
+            err = std::string("Vulkan init failed: ") + e.what();
+            return false;
+        }
+        driver = av1r_vk_stub_active() ? "stub" : "vulkan";
+        av1r_device_name(ctx.physDevice, devName, sizeof(devName));
+
+        Av1rStreamEncoder* se = av1r_vulkan_stream_new();
+        try {
+            Av1rEncodeConfig cfg;
+            cfg.width  = w;
+            cfg.height = h;
+            cfg.fps    = 30;
+            encode_config_from_options(r_options, cfg);
+            cfg.srcFormat = src_fmt;
+            cfg.windowLo  = win_lo;
+            cfg.windowHi  = win_hi;
+            cfg.staticThreshold = Av1rEncodeConfig().staticThreshold;   // every frame encoded
+            cfg.gpuTiming = true;   // stage split
+            av1r_vulkan_stream_init(ctx, se, cfg);
+        } catch (const std::exception& e) {
+            av1r_vulkan_stream_delete(se);
+            av1r_destroy_logical_device(ctx.device);
+            av1r_destroy_instance(ctx.instance);
+            err = std::string("Vulkan encoder init failed: ") + e.what();
+            return false;
+        }
+        convert_mode = av1r_vulkan_stream_stats(se).convert;
+
+        FILE* fout = output[0] != '\0' ? fopen(output, "wb") : nullptr;
+        if (fout) write_ivf_header(fout, w, h, 30, frames);
+        std::vector<uint8_t> packet;
+        std::string error_msg;
+        auto na = [](double x) { return std::isnan(x) ? NA_REAL : x; };
+        for (size_t i = 0; i < n && error_msg.empty(); i++) {
+            Clock::time_point t0 = Clock::now();
+            scene.render(static_cast<int>(i), src.data());
+            source[i] = ms_since(t0);
+            try {
+                av1r_vulkan_stream_encode(se, src.data(), static_cast<int>(i), packet);
+                t0 = Clock::now();
+                av1r_obu_walk(packet.data(), packet.size(), counts);
+                obu[i] = ms_since(t0);
+            } catch (const std::exception& e) {
+                error_msg = e.what();
+                break;
+            }
+            const Av1rEncodeStats& st = av1r_vulkan_stream_stats(se);
+            if (!st.timings.empty() && st.timings.back().frame == i) {
+                const Av1rFrameTiming& t = st.timings.back();
+                convert[i]  = src_fmt == AV1R_PIX_NV12 ? NA_REAL : na(t.convertMs);
+                upload[i]   = na(t.uploadMs);
+                enc[i]      = na(t.encodeMs);
+                readback[i] = na(t.readbackMs);
+                sync[i]     = na(t.syncMs);
+            }
+            if (fout) {
+                t0 = Clock::now();
+                write_ivf_frame(fout, packet.data(), packet.size(), static_cast<uint64_t>(i));
+                fflush(fout);
+                mux[i] = ms_since(t0);
+            }
+            out_bytes += static_cast<double>(packet.size());
+        }
+        if (fout) fclose(fout);
+        av1r_vulkan_stream_finish(se);
+        av1r_vulkan_stream_delete(se);
+        av1r_destroy_logical_device(ctx.device);
+        av1r_destroy_instance(ctx.instance);
+        if (!error_msg.empty()) {
+            err = "Vulkan encode failed: " + error_msg;
+            return false;
+        }
+#else
+        (void)output;
+        (void)r_options;
+        err = "benchmark: package built without Vulkan AV1 encode support";
+        return false;
+#endif
+    }
+
+    res.add_string("driver", driver.c_str());
+    res.add_string("device", devName);
+    res.add("width", w);
+    res.add("height", h);
+    res.add("bits", bits);
+    res.add("frames", frames);
+    res.add_string("convert", convert_mode.c_str());
+    res.add("bytes", out_bytes, REALSXP);
+    res.add("obus", counts.obus, REALSXP);
+    res.add("obu_frames", counts.frames, REALSXP);
+    res.add_vector("source_ms",   source,   REALSXP);
+    res.add_vector("convert_ms",  convert,  REALSXP);
+    res.add_vector("upload_ms",   upload,   REALSXP);
+    res.add_vector("encode_ms",   enc,      REALSXP);
+    res.add_vector("readback_ms", readback, REALSXP);
+    res.add_vector("sync_ms",     sync,     REALSXP);
+    res.add_vector("obu_ms",      obu,      REALSXP);
+    res.add_vector("mux_ms",      mux,      REALSXP);
+    return true;
+}
+
+extern "C" SEXP R_av1r_benchmark(SEXP r_width, SEXP r_height, SEXP r_bits, SEXP r_frames,
+                                 SEXP r_encode, SEXP r_output, SEXP r_options) {
+    const int w = Rf_asInteger(r_width), h = Rf_asInteger(r_height);
+    const int bits = Rf_asInteger(r_bits), frames = Rf_asInteger(r_frames);
+    const bool encode = Rf_asLogical(r_encode) == TRUE;
+    if (frames == NA_INTEGER || frames <= 0)
+        Rf_error("benchmark: frames must be positive");
+    uint32_t win_lo, win_hi;
+    parse_window(opt_elt(r_options, "window"), &win_lo, &win_hi);
+
+    Av1rStatsList res;
+    std::string err;
+    if (!run_benchmark(w, h, bits, frames, encode, CHAR(STRING_ELT(r_output, 0)),
+                       win_lo, win_hi, r_options, res, err))
+        Rf_error("%s", err.c_str());
+    return res.to_sexp();
+}
+
+// ============================================================================
+// R_av1r_synth_frames(width, height, bits, frames, seed, scene)  →  raw
+// Frames 0 .. frames-1 of the benchmark scene back to back, NV12 (bits 8)
+// or gray16le (bits 16). `scene`: named list of Av1rSynthParams scale
+// factors (density, size, photons, gain, drift; absent = 1). Corpus for
+// the CRF model calibration (inst/bench/crf_corpus.R).
+// ============================================================================
+extern "C" SEXP R_av1r_synth_frames(SEXP r_width, SEXP r_height, SEXP r_bits, SEXP r_frames,
+                                    SEXP r_seed, SEXP r_scene) {
+    const int w = Rf_asInteger(r_width), h = Rf_asInteger(r_height);
+    const int bits = Rf_asInteger(r_bits), frames = Rf_asInteger(r_frames);
+    const double seed = Rf_asReal(r_seed);
+    if (frames == NA_INTEGER || frames <= 0)
+        Rf_error("synthetic frames: frames must be positive");
+    if (ISNAN(seed) || seed < 0)
+        Rf_error("synthetic frames: seed must be a non-negative number");
+    Av1rSynthParams params;
+    params.density = opt_real(r_scene, "density", params.density);
+    params.size    = opt_real(r_scene, "size",    params.size);
+    params.photons = opt_real(r_scene, "photons", params.photons);
+    params.gain    = opt_real(r_scene, "gain",    params.gain);
+    params.drift   = opt_real(r_scene, "drift",   params.drift);
+
+    SEXP out = R_NilValue;
+    std::string err;
+    {   // scene freed before any Rf_error
+        Av1rSynthScene scene;
+        try {
+            scene.reset(w, h, bits, static_cast<uint64_t>(seed), params);
+        } catch (const std::exception& e) {
+            err = e.what();
+        }
+        if (err.empty()) {
+            const size_t bytes = scene.frame_bytes();
+            out = PROTECT(Rf_allocVector(RAWSXP, static_cast<R_xlen_t>(bytes * frames)));
+            for (int i = 0; i < frames; i++) scene.render(i, RAW(out) + bytes * i);
+            UNPROTECT(1);
+        }
+    }
+    if (!err.empty()) Rf_error("%s", err.c_str());
+    return out;
+}
+
+// ============================================================================
+// Trace control (av1r_options(trace = "file.json"), R/trace.R)
+// R_av1r_trace_start(path) → logical: FALSE when a trace is already running
+// R_av1r_trace_stop()      → integer: spans written
+// R_av1r_trace_now()       → numeric: µs since start, NA when off
+// R_av1r_trace_span(name, cat, t0, child): span from t0 to now; child = TRUE
+//   puts it on its own process row (ffmpeg/ffprobe run by R)
+// ============================================================================
+extern "C" SEXP R_av1r_trace_start(SEXP r_path) {
+    if (!Rf_isString(r_path) || Rf_length(r_path) != 1 || STRING_ELT(r_path, 0) == NA_STRING)
+        Rf_error("trace: path must be a single string");
+    return Rf_ScalarLogical(av1r_trace_start(CHAR(STRING_ELT(r_path, 0))) ? TRUE : FALSE);
+}
+
+extern "C" SEXP R_av1r_trace_stop(void) {
+    size_t n = 0;
+    std::string err;
+    try {
+        n = av1r_trace_stop();
+    } catch (const std::exception& e) {
+        err = e.what();
+    }
+    if (!err.empty()) Rf_error("%s", err.c_str());
+    return Rf_ScalarInteger(static_cast<int>(n));
+}
+
+extern "C" SEXP R_av1r_trace_now(void) {
+    return Rf_ScalarReal(av1r_trace_on() ? static_cast<double>(av1r_trace_now_us()) : NA_REAL);
+}
+
+extern "C" SEXP R_av1r_trace_span(SEXP r_name, SEXP r_cat, SEXP r_t0, SEXP r_child) {
+    const double t0 = Rf_asReal(r_t0);
+    if (!av1r_trace_on() || ISNAN(t0)) return R_NilValue;
+    const char* name = CHAR(STRING_ELT(r_name, 0));
+    const uint32_t track = Rf_asLogical(r_child) == TRUE ? av1r_trace_child(name) : 0;
+    const int64_t ts = static_cast<int64_t>(t0);
+    av1r_trace_span(name, CHAR(STRING_ELT(r_cat, 0)), ts, av1r_trace_now_us() - ts, track);
+    return R_NilValue;
+}
+
+// ============================================================================
+// R_av1r_memory(reset)  →  list: process-wide memory accounting, same
+// columns as the per-encode stats; reset = TRUE restarts the peaks
+// R_av1r_mem_charge(category, domain, delta): host/device bytes allocated
+// (delta > 0) or released on the R side, e.g. the magick TIFF stack
+// ============================================================================
+extern "C" SEXP R_av1r_memory(SEXP r_reset) {
+    Av1rStatsList stats;
+    add_memory_stats(stats, av1r_mem_process());
+    SEXP res = PROTECT(stats.to_sexp());
+    if (Rf_asLogical(r_reset) == TRUE) av1r_mem_process().reset_peaks();
+    UNPROTECT(1);
+    return res;
+}
+
+extern "C" SEXP R_av1r_mem_charge(SEXP r_category, SEXP r_domain, SEXP r_delta) {
+    if (!Rf_isString(r_category) || Rf_length(r_category) != 1 ||
+        !Rf_isString(r_domain) || Rf_length(r_domain) != 1)
+        Rf_error("mem_charge: category and domain must be single strings");
+    const bool device = std::strcmp(CHAR(STRING_ELT(r_domain, 0)), "device") == 0;
+    const double delta = Rf_asReal(r_delta);
+    if (ISNAN(delta)) Rf_error("mem_charge: delta must be a number");
+    av1r_mem_process().add(device ? AV1R_MEM_DEVICE : AV1R_MEM_HOST,
+                           CHAR(STRING_ELT(r_category, 0)), static_cast<int64_t>(delta));
+    return R_NilValue;
+}
+
+// ============================================================================
+// R_av1r_probe(path)  →  list: container, codec, pix_fmt, width, height,
+// fps_num, fps_den, frames, duration_us, bitrate of the first video stream
+// from the container headers (NA where not stored), or NULL for formats
+// the native probe does not know (R then asks ffprobe)
+// ============================================================================
+extern "C" SEXP R_av1r_probe(SEXP r_path) {
+    if (!Rf_isString(r_path) || Rf_length(r_path) != 1 || STRING_ELT(r_path, 0) == NA_STRING)
+        Rf_error("probe: path must be a single string");
+    const char* path = CHAR(STRING_ELT(r_path, 0));
+    Av1rProbeInfo info;
+    try {
+        if (!av1r_probe_file(path, info)) return R_NilValue;
+    } catch (const std::exception&) {
+        return R_NilValue;
+    }
+    auto num = [](double x, bool known) { return known ? x : NA_REAL; };
+    Av1rStatsList res;
+    res.add_string("container", info.container.c_str());
+    res.add_string("codec", info.codec.c_str());
+    res.add_string("pix_fmt", info.pixFmt.c_str());
+    res.add("width",  info.width);
+    res.add("height", info.height);
+    res.add("fps_num", num(double(info.fpsNum), info.fpsNum > 0), REALSXP);
+    res.add("fps_den", num(double(info.fpsDen), info.fpsNum > 0), REALSXP);
+    res.add("frames",  num(double(info.frames), info.frames >= 0), REALSXP);
+    res.add("duration_us", num(double(info.durationUs), info.durationUs >= 0), REALSXP);
+    res.add("bitrate", num(info.bitrate, info.bitrate >= 0), REALSXP);
+    return res.to_sexp();
+}
+
+// ============================================================================
+// R_av1r_fingerprint(paths, sample, threads)  →  list(hash, size): sampled
+// XXH64 of each file (av1r_hash.h), hex; "" and NA size for unreadable
+// files. Files are spread over `threads` threads (0 = up to 8): the reads
+// are small and mostly wait on the disk or network share.
+// ============================================================================
+extern "C" SEXP R_av1r_fingerprint(SEXP r_paths, SEXP r_sample, SEXP r_threads) {
+    if (!Rf_isString(r_paths)) Rf_error("fingerprint: paths must be a character vector");
+    const size_t n = static_cast<size_t>(Rf_xlength(r_paths));
+    std::vector<std::string> paths(n);
+    for (size_t i = 0; i < n; i++)
+        if (STRING_ELT(r_paths, i) != NA_STRING) paths[i] = CHAR(STRING_ELT(r_paths, i));
+    const size_t sample = static_cast<size_t>(std::max(0.0, Rf_asReal(r_sample)));
+    int threads = Rf_asInteger(r_threads);
+    if (threads == NA_INTEGER || threads <= 0)
+        threads = static_cast<int>(std::min(8u, std::max(1u, std::thread::hardware_concurrency())));
+    threads = static_cast<int>(std::min<size_t>(static_cast<size_t>(threads), std::max<size_t>(n, 1)));
+
+    std::vector<std::string> hash(n);
+    std::vector<double> size(n, NA_REAL);
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t i; (i = next.fetch_add(1)) < n; ) {
+            uint64_t h = 0, sz = 0;
+            if (paths[i].empty() || !av1r_file_fingerprint(paths[i], sample, h, sz)) continue;
+            hash[i] = av1r_hash_hex(h);
+            size[i] = static_cast<double>(sz);
+        }
+    };
+    {
+        AV1R_TRACE_SPAN("fingerprint", "io");
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++) pool.emplace_back(work);
+        work();
+        for (std::thread& t : pool) t.join();
+    }
+    Av1rStatsList res;
+    res.add_strings("hash", hash);
+    res.add_vector("size", size, REALSXP);
+    return res.to_sexp();
+}
+
+// ============================================================================
+// Batch input prefetch (av1r_prefetch.h), external pointer like the
+// background jobs
+// ============================================================================
+static void release_prefetch(SEXP ptr) {
+    delete static_cast<Av1rPrefetcher*>(R_ExternalPtrAddr(ptr));
+    R_ClearExternalPtr(ptr);
+}
+
+// R_av1r_prefetch_start(paths, depth, budget_mb) → external pointer;
+// depth is c(front, back): the windows for jobs taken from each end
+extern "C" SEXP R_av1r_prefetch_start(SEXP r_paths, SEXP r_depth, SEXP r_budget) {
+    if (!Rf_isString(r_paths)) Rf_error("prefetch: paths must be a character vector");
+    if (!Rf_isInteger(r_depth) || Rf_xlength(r_depth) < 1 || Rf_xlength(r_depth) > 2)
+        Rf_error("prefetch: depth must be one or two integers");
+    std::vector<std::string> paths;
+    for (R_xlen_t i = 0; i < Rf_xlength(r_paths); i++)
+        paths.push_back(STRING_ELT(r_paths, i) == NA_STRING ? "" : CHAR(STRING_ELT(r_paths, i)));
+    const double mb = Rf_asReal(r_budget);
+    if (ISNAN(mb) || mb < 0) Rf_error("prefetch: budget must be a non-negative number");
+    Av1rPrefetcher* pf = nullptr;
+    try {
+        const int head = INTEGER(r_depth)[0];
+        const int tail = Rf_xlength(r_depth) > 1 ? INTEGER(r_depth)[1] : 0;
+        pf = new Av1rPrefetcher(paths, head == NA_INTEGER ? 0 : head, tail == NA_INTEGER ? 0 : tail,
+                                static_cast<uint64_t>(mb * 1048576.0));
+    } catch (const std::exception& e) {
+        Rf_error("could not start prefetch: %s", e.what());
+    }
+    SEXP ptr = PROTECT(R_MakeExternalPtr(pf, Rf_install("av1r_prefetch"), R_NilValue));
+    R_RegisterCFinalizerEx(ptr, release_prefetch, TRUE);
+    UNPROTECT(1);
+    return ptr;
+}
+
+// R_av1r_prefetch_opened(prefetch, i, tail): file i (1-based) is being
+// encoded by a worker taking jobs from the front (or the back)
+extern "C" SEXP R_av1r_prefetch_opened(SEXP ptr, SEXP r_i, SEXP r_tail) {
+    Av1rPrefetcher* pf = TYPEOF(ptr) == EXTPTRSXP
+        ? static_cast<Av1rPrefetcher*>(R_ExternalPtrAddr(ptr)) : nullptr;
+    const int i = Rf_asInteger(r_i);
+    if (pf && i != NA_INTEGER && i >= 1)
+        pf->opened(static_cast<size_t>(i - 1), Rf_asLogical(r_tail) == TRUE);
+    return R_NilValue;
+}
+
+// R_av1r_prefetch_poll(prefetch) → list(files, bytes) prefetched so far
+extern "C" SEXP R_av1r_prefetch_poll(SEXP ptr) {
+    Av1rStatsList res;
+    Av1rPrefetcher* pf = TYPEOF(ptr) == EXTPTRSXP
+        ? static_cast<Av1rPrefetcher*>(R_ExternalPtrAddr(ptr)) : nullptr;
+    res.add("files", pf ? pf->files() : 0);
+    res.add("bytes", pf ? static_cast<double>(pf->bytes()) : 0.0, REALSXP);
+    return res.to_sexp();
+}
+
+// R_av1r_prefetch_stop(prefetch) → as R_av1r_prefetch_poll(); frees it
+extern "C" SEXP R_av1r_prefetch_stop(SEXP ptr) {
+    SEXP res = PROTECT(R_av1r_prefetch_poll(ptr));
+    if (TYPEOF(ptr) == EXTPTRSXP && R_ExternalPtrAddr(ptr)) release_prefetch(ptr);
+    UNPROTECT(1);
+    return res;
+}
+
+// R_av1r_first_byte(path) → seconds to open and read the first 64 KiB
+// (the input stall of an encode), NA if unreadable
+extern "C" SEXP R_av1r_first_byte(SEXP r_path) {
+    if (!Rf_isString(r_path) || Rf_length(r_path) != 1 || STRING_ELT(r_path, 0) == NA_STRING)
+        Rf_error("first_byte: path must be a single string");
+    const double t = av1r_first_byte_sec(CHAR(STRING_ELT(r_path, 0)));
+    return Rf_ScalarReal(t < 0 ? NA_REAL : t);
+}
+
+// R_av1r_xxh64(raw)  →  hex XXH64 of a raw vector (options hash)
+extern "C" SEXP R_av1r_xxh64(SEXP r_data) {
+    if (TYPEOF(r_data) != RAWSXP) Rf_error("xxh64: raw vector expected");
+    const std::string h = av1r_hash_hex(av1r_xxh64(RAW(r_data), static_cast<size_t>(Rf_xlength(r_data))));
+    return Rf_mkString(h.c_str());
+}
+
+// ============================================================================
+// R_av1r_ssim_y4m(ref, dist)  →  list(ssim, ssim_y, ssim_u, ssim_v, frames)
+// SSIM of two 8-bit 4:2:0 Y4M files (av1r_metrics.h), ffmpeg's ssim filter
+// formula; the quality probe compares its cached segments with it
+// ============================================================================
+extern "C" SEXP R_av1r_ssim_y4m(SEXP r_ref, SEXP r_dist) {
+    Av1rSsimResult r;
+    std::string err;
+    try {
+        r = av1r_ssim_y4m(CHAR(STRING_ELT(r_ref, 0)), CHAR(STRING_ELT(r_dist, 0)));
+    } catch (const std::exception& e) {
+        err = e.what();
+    }
+    if (!err.empty()) Rf_error("SSIM: %s", err.c_str());
+    Av1rStatsList res;
+    res.add("ssim",   r.frames > 0 ? r.all : NA_REAL, REALSXP);
+    res.add("ssim_y", r.frames > 0 ? r.y   : NA_REAL, REALSXP);
+    res.add("ssim_u", r.frames > 0 ? r.u   : NA_REAL, REALSXP);
+    res.add("ssim_v", r.frames > 0 ? r.v   : NA_REAL, REALSXP);
+    res.add("frames", r.frames);
+    return res.to_sexp();
+}
+
+// ============================================================================
+// R_av1r_measure(ref, dist, size, fps, max_frames, stride, threads, msssim)
+// Both videos decoded in-process (or ffmpeg pipe) to size = c(w, h) and
+// scored natively (av1r_metrics.h). Per-frame columns (frame is 1-based)
+// plus aggregates ssim / psnr = c(Y, U, V, All); ms_ssim NA unless asked.
+// ============================================================================
+extern "C" SEXP R_av1r_measure(SEXP r_ref, SEXP r_dist, SEXP r_size, SEXP r_fps,
+                               SEXP r_max, SEXP r_stride, SEXP r_threads, SEXP r_msssim) {
+    Av1rMetricsConfig cfg;
+    cfg.ref       = CHAR(STRING_ELT(r_ref, 0));
+    cfg.dist      = CHAR(STRING_ELT(r_dist, 0));
+    cfg.width     = INTEGER(r_size)[0];
+    cfg.height    = INTEGER(r_size)[1];
+    cfg.fps       = Rf_asInteger(r_fps);
+    cfg.maxFrames = Rf_asInteger(r_max);
+    cfg.stride    = Rf_asInteger(r_stride);
+    cfg.threads   = Rf_asInteger(r_threads);
+    cfg.msssim    = Rf_asLogical(r_msssim) == TRUE;
+    if (cfg.maxFrames == NA_INTEGER) cfg.maxFrames = 0;
+
+    Av1rMetricsResult r;
+    std::string err;
+    try {
+        r = av1r_measure(cfg, [](int) { return R_ToplevelExec(check_interrupt_fn, nullptr) != FALSE; });
+    } catch (const std::exception& e) {
+        err = e.what();
+    }
+    if (!err.empty()) Rf_error("measure: %s", err.c_str());
+
+    const size_t n = r.frames.size();
+    std::vector<int> index(n);
+    std::vector<double> cols[9];
+    for (auto& c : cols) c.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        const Av1rFrameScore& f = r.frames[i];
+        index[i] = f.index + 1;
+        for (int p = 0; p < 4; p++) {
+            cols[p][i]     = f.ssim[p];
+            cols[4 + p][i] = f.psnr[p];
+        }
+        cols[8][i] = std::isnan(f.msssim) ? NA_REAL : f.msssim;
+    }
+    Av1rStatsList res;
+    res.add_vector("frame",   index);
+    res.add_vector("ssim_y",  cols[0], REALSXP);
+    res.add_vector("ssim_u",  cols[1], REALSXP);
+    res.add_vector("ssim_v",  cols[2], REALSXP);
+    res.add_vector("ssim",    cols[3], REALSXP);
+    res.add_vector("psnr_y",  cols[4], REALSXP);
+    res.add_vector("psnr_u",  cols[5], REALSXP);
+    res.add_vector("psnr_v",  cols[6], REALSXP);
+    res.add_vector("psnr",    cols[7], REALSXP);
+    res.add_vector("ms_ssim", cols[8], REALSXP);
+    res.add_vector("agg_ssim", std::vector<double>(r.ssim, r.ssim + 4), REALSXP);
+    res.add_vector("agg_psnr", std::vector<double>(r.psnr, r.psnr + 4), REALSXP);
+    res.add("agg_ms_ssim", std::isnan(r.msssim) ? NA_REAL : r.msssim, REALSXP);
+    res.add("decoded", r.decoded);
+    res.add_string("decoder", r.decoder.c_str());
+    res.add_string("kernel", av1r_metrics_kernel());
+    return res.to_sexp();
+}
+
+// ============================================================================
+// R_av1r_content_stats(input, size, fps, starts, format, frames)
+// Content statistics for the CRF predictor (R/crf_model.R): at each start
+// (seconds) `frames` consecutive frames are decoded (libav seek, else
+// ffmpeg -ss) as "i420" or "gray16" luma and measured (av1r_analysis.h).
+// → list: start, variance, noise, temporal, lo, hi (per sample, NA where
+//   decoding failed), decoder
+// ============================================================================
+extern "C" SEXP R_av1r_content_stats(SEXP r_input, SEXP r_size, SEXP r_fps, SEXP r_starts,
+                                     SEXP r_format, SEXP r_frames) {
+    Av1rDecodeConfig dcfg;
+    dcfg.input     = CHAR(STRING_ELT(r_input, 0));
+    dcfg.width     = INTEGER(r_size)[0];
+    dcfg.height    = INTEGER(r_size)[1];
+    dcfg.fps       = Rf_asInteger(r_fps);
+    dcfg.maxFrames = std::max(1, Rf_asInteger(r_frames));
+    const bool wide = std::strcmp(CHAR(STRING_ELT(r_format, 0)), "gray16") == 0;
+    dcfg.format    = wide ? AV1R_PIX_GRAY16 : AV1R_PIX_I420;
+    const int w = dcfg.width, h = dcfg.height;
+    const size_t luma = static_cast<size_t>(w) * h;
+    const size_t bytes = av1r_pix_fmt_frame_bytes(dcfg.format, w, h);
+
+    const R_xlen_t n = Rf_xlength(r_starts);
+    Av1rStatsList res;
+    std::string err;
+    {   // buffers freed before any Rf_error
+        std::vector<double> cols[5];
+        for (auto& c : cols) c.assign(static_cast<size_t>(n), NA_REAL);
+        std::string decoder;
+        std::vector<uint8_t> cur(bytes), prev(bytes);
+        for (R_xlen_t i = 0; i < n; i++) {
+            dcfg.startSec = REAL(r_starts)[i];
+            std::unique_ptr<Av1rFrameSource> source;
+            try {
+                source = av1r_libav_source(dcfg);
+            } catch (const std::exception&) {
+                source.reset();
+            }
+            try {
+                if (!source) source = av1r_pipe_source(dcfg);
+            } catch (const std::exception& e) {
+                err = e.what();
+                break;
+            }
+            decoder = source->name();
+            // Spatial statistics averaged over the frames, temporal over the pairs
+            Av1rContentStats acc;
+            double temporal = 0.0;
+            int got = 0;
+            for (; got < dcfg.maxFrames && source->read(cur.data()); got++) {
+                const Av1rContentStats s = wide
+                    ? av1r_content_stats_u16(reinterpret_cast<const uint16_t*>(cur.data()), w, h, w)
+                    : av1r_content_stats_u8(cur.data(), w, h, w);
+                acc.variance += s.variance;
+                acc.noise    += s.noise;
+                acc.lo       += s.lo;
+                acc.hi       += s.hi;
+                if (got > 0)
+                    temporal += wide
+                        ? av1r_temporal_diff_u16(reinterpret_cast<const uint16_t*>(cur.data()),
+                                                 reinterpret_cast<const uint16_t*>(prev.data()), luma)
+                        : av1r_temporal_diff_u8(cur.data(), prev.data(), luma);
+                cur.swap(prev);
+            }
+            if (got == 0) continue;
+            const size_t k = static_cast<size_t>(i);
+            cols[0][k] = acc.variance / got;
+            cols[1][k] = acc.noise / got;
+            cols[2][k] = got > 1 ? temporal / (got - 1) : NA_REAL;
+            cols[3][k] = acc.lo / got;
+            cols[4][k] = acc.hi / got;
+        }
+        res.add_vector("start", std::vector<double>(REAL(r_starts), REAL(r_starts) + n), REALSXP);
+        res.add_vector("variance", cols[0], REALSXP);
+        res.add_vector("noise",    cols[1], REALSXP);
+        res.add_vector("temporal", cols[2], REALSXP);
+        res.add_vector("lo",       cols[3], REALSXP);
+        res.add_vector("hi",       cols[4], REALSXP);
+        res.add_string("decoder", decoder.c_str());
+    }
+    if (!err.empty()) Rf_error("content stats: %s", err.c_str());
+    return res.to_sexp();
+}
+
+// ============================================================================
+// R_av1r_run_jobs(cmds, workers, name, backend, options, file, total_frames,
+//                 fps, prefetch)
+// Runs shell commands, at most `workers` at a time: ffmpeg chunk encodes
+// (R/chunked.R) or per-file Rscript workers (convert_folder(jobs =)), and
+// reports their summed frames through the progress option as `backend`.
+// Hybrid batch: cmds is a list with one character vector per worker class
+// ("" = not for that class), workers and name one entry per class.
+// The R thread polls every 50 ms; on an interrupt or a cancelling callback
+// no further jobs are started, the running ones get SIGTERM and the call
+// errors once they exit. `prefetch` (R_av1r_prefetch_start() over the job
+// inputs in job order, or NULL) is told when each job starts.
+// → list: status, worker, class, start_sec, end_sec, frames (one per job)
+// ============================================================================
+extern "C" SEXP R_av1r_run_jobs(SEXP r_cmds, SEXP r_workers, SEXP r_name, SEXP r_backend,
+                                SEXP r_options, SEXP r_file, SEXP r_total, SEXP r_fps,
+                                SEXP r_prefetch) {
+    std::vector<std::vector<std::string>> cmds;
+    const bool classes = TYPEOF(r_cmds) == VECSXP;
+    for (R_xlen_t c = 0; c < (classes ? Rf_xlength(r_cmds) : 1); c++) {
+        SEXP v = classes ? VECTOR_ELT(r_cmds, c) : r_cmds;
+        if (!Rf_isString(v)) Rf_error("run_jobs: cmds must be character vectors");
+        cmds.emplace_back();
+        for (R_xlen_t i = 0; i < Rf_xlength(v); i++)
+            cmds.back().push_back(STRING_ELT(v, i) == NA_STRING ? "" : CHAR(STRING_ELT(v, i)));
+    }
+    std::vector<int> workers;
+    for (R_xlen_t c = 0; c < Rf_xlength(r_workers); c++)
+        workers.push_back(Rf_isInteger(r_workers) ? INTEGER(r_workers)[c]
+                                                  : static_cast<int>(REAL(r_workers)[c]));
+    std::vector<std::string> names;
+    for (R_xlen_t c = 0; c < Rf_xlength(r_name); c++) names.push_back(CHAR(STRING_ELT(r_name, c)));
+    if (workers.size() != cmds.size() || names.empty())
+        Rf_error("run_jobs: one worker count per command class expected");
+    const int total = Rf_asInteger(r_total);
+    const std::string name = names[0];
+    Av1rProgressSink progress(r_options, CHAR(STRING_ELT(r_file, 0)),
+                              total == NA_INTEGER ? 0 : total, Rf_asInteger(r_fps),
+                              true, CHAR(STRING_ELT(r_backend, 0)));
+
+    Av1rPrefetcher* prefetch = TYPEOF(r_prefetch) == EXTPTRSXP
+        ? static_cast<Av1rPrefetcher*>(R_ExternalPtrAddr(r_prefetch)) : nullptr;
+
+    std::string err;
+    Av1rStatsList res;
+    {   // the pool joins its threads before any Rf_error
+        Av1rJobPool pool(cmds, names);
+        pool.start(workers);
+        int reportedFrames = 0;
+        uint64_t reportedBytes = 0;
+        std::vector<char> seen(pool.size(), 0);
+        while (!pool.finished()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (prefetch)
+                for (size_t i = 0; i < pool.size(); i++)
+                    if (!seen[i] && pool.job(i).started.load()) {
+                        seen[i] = 1;
+                        prefetch->opened(i, pool.job(i).cls != 0);
+                    }
+            if (!err.empty()) continue;
+            if (!R_ToplevelExec(check_interrupt_fn, nullptr)) {
+                err = "interrupted";
+                pool.kill(SIGTERM);
+                continue;
+            }
+            const int frames = pool.frames();
+            const uint64_t bytes = pool.bytes();
+            if (frames <= reportedFrames) continue;
+            if (!progress.advance(frames - reportedFrames, bytes - reportedBytes)) {
+                err = progress.error();
+                pool.kill(SIGTERM);
+            }
+            reportedFrames = frames;
+            reportedBytes  = bytes;
+        }
+        pool.join();
+
+        std::vector<int> status, worker, cls, frames;
+        std::vector<double> t0, t1;
+        for (size_t i = 0; i < pool.size(); i++) {
+            const Av1rJob& j = pool.job(i);
+            status.push_back(j.status);
+            worker.push_back(j.worker + 1);
+            cls.push_back(j.cls + 1);
+            frames.push_back(j.frames.load());
+            t0.push_back(j.startSec);
+            t1.push_back(j.endSec);
+        }
+        res.add_vector("status",    status);
+        res.add_vector("worker",    worker);
+        res.add_vector("class",     cls);
+        res.add_vector("start_sec", t0, REALSXP);
+        res.add_vector("end_sec",   t1, REALSXP);
+        res.add_vector("frames",    frames);
+    }
+    if (!err.empty()) Rf_error("%s %s", name.c_str(), err.c_str());
+    progress.finish();
+    return res.to_sexp();
+}
+
+// ============================================================================
+// Background jobs (convert_async(), R/async.R): one command in a pool of
+// its own behind an external pointer, polled from R. Releasing the job —
+// explicitly, by the garbage collector or at R exit — kills its process
+// group, so no encode outlives its handle.
+// ============================================================================
+static void release_job(SEXP ptr) {
+    Av1rJobPool* pool = static_cast<Av1rJobPool*>(R_ExternalPtrAddr(ptr));
+    if (!pool) return;
+#ifdef SIGKILL
+    pool->kill(SIGKILL);
+#endif
+    delete pool;   // joins the reader thread
+    R_ClearExternalPtr(ptr);
+}
+
+static Av1rJobPool* job_pool(SEXP ptr) {
+    if (TYPEOF(ptr) != EXTPTRSXP || !R_ExternalPtrAddr(ptr))
+        Rf_error("AV1R job already released");
+    return static_cast<Av1rJobPool*>(R_ExternalPtrAddr(ptr));
+}
+
+// R_av1r_job_start(cmd, name) → external pointer
+extern "C" SEXP R_av1r_job_start(SEXP r_cmd, SEXP r_name) {
+    if (!Rf_isString(r_cmd) || Rf_xlength(r_cmd) != 1) Rf_error("job_start: one command expected");
+    Av1rJobPool* pool = nullptr;
+    try {
+        pool = new Av1rJobPool({ { CHAR(STRING_ELT(r_cmd, 0)) } },
+                               { CHAR(STRING_ELT(r_name, 0)) });
+        pool->start({ 1 });
+    } catch (const std::exception& e) {
+        delete pool;
+        Rf_error("could not start job: %s", e.what());
+    }
+    SEXP ptr = PROTECT(R_MakeExternalPtr(pool, Rf_install("av1r_job"), R_NilValue));
+    R_RegisterCFinalizerEx(ptr, release_job, TRUE);
+    UNPROTECT(1);
+    return ptr;
+}
+
+// R_av1r_job_poll(job) → list: running, status (exit code, NA while
+// running), frames, bytes, elapsed_sec
+extern "C" SEXP R_av1r_job_poll(SEXP ptr) {
+    const Av1rJobPool* pool = job_pool(ptr);
+    const bool running = !pool->finished();
+    const Av1rJob& j = pool->job(0);
+    Av1rStatsList res;
+    res.add_logical("running", running);
+    res.add("status", running ? NA_INTEGER : j.status);
+    res.add("frames", j.frames.load());
+    res.add("bytes",  static_cast<double>(j.bytes.load()), REALSXP);
+    res.add("elapsed_sec", running ? NA_REAL : j.endSec - j.startSec, REALSXP);
+    return res.to_sexp();
+}
+
+// R_av1r_job_kill(job, force): SIGTERM (SIGKILL with force) to the job's
+// process group; nothing on Windows, where the job runs to its end
+extern "C" SEXP R_av1r_job_kill(SEXP ptr, SEXP r_force) {
+    Av1rJobPool* pool = job_pool(ptr);
+#ifdef SIGKILL
+    pool->kill(Rf_asLogical(r_force) == TRUE ? SIGKILL : SIGTERM);
+#else
+    (void)r_force;
+    pool->cancel();
+#endif
+    return R_NilValue;
+}
+
+// R_av1r_job_release(job): kill if still running, join, free
+extern "C" SEXP R_av1r_job_release(SEXP ptr) {
+    if (TYPEOF(ptr) == EXTPTRSXP) release_job(ptr);
+    return R_NilValue;
+}
+
 // ============================================================================
 // Registration table
 // ============================================================================
 static const R_CallMethodDef CallEntries[] = {
     { "R_av1r_vulkan_available", (DL_FUNC) &R_av1r_vulkan_available, 0 },
+    { "R_av1r_libav_version",    (DL_FUNC) &R_av1r_libav_version,    0 },
+    { "R_av1r_svt_version",      (DL_FUNC) &R_av1r_svt_version,      0 },
     { "R_av1r_vulkan_devices",   (DL_FUNC) &R_av1r_vulkan_devices,   0 },
     { "R_av1r_detect_backend",   (DL_FUNC) &R_av1r_detect_backend,   1 },
+    { "R_av1r_vulkan_caps",      (DL_FUNC) &R_av1r_vulkan_caps,      1 },
+    { "R_av1r_frame_sad",        (DL_FUNC) &R_av1r_frame_sad,        2 },
+    { "R_av1r_scene_scores",     (DL_FUNC) &R_av1r_scene_scores,     4 },
+    { "R_av1r_tile_layout",      (DL_FUNC) &R_av1r_tile_layout,      3 },
+    { "R_av1r_convert_nv12",     (DL_FUNC) &R_av1r_convert_nv12,     5 },
+    { "R_av1r_gpu_convert_bench", (DL_FUNC) &R_av1r_gpu_convert_bench, 5 },
+    { "R_av1r_benchmark",        (DL_FUNC) &R_av1r_benchmark,        7 },
+    { "R_av1r_synth_frames",     (DL_FUNC) &R_av1r_synth_frames,     6 },
+    { "R_av1r_trace_start",      (DL_FUNC) &R_av1r_trace_start,      1 },
+    { "R_av1r_trace_stop",       (DL_FUNC) &R_av1r_trace_stop,       0 },
+    { "R_av1r_trace_now",        (DL_FUNC) &R_av1r_trace_now,        0 },
+    { "R_av1r_trace_span",       (DL_FUNC) &R_av1r_trace_span,       4 },
+    { "R_av1r_memory",           (DL_FUNC) &R_av1r_memory,           1 },
+    { "R_av1r_mem_charge",       (DL_FUNC) &R_av1r_mem_charge,       3 },
+    { "R_av1r_run_jobs",         (DL_FUNC) &R_av1r_run_jobs,         9 },
+    { "R_av1r_job_start",        (DL_FUNC) &R_av1r_job_start,        2 },
+    { "R_av1r_job_poll",         (DL_FUNC) &R_av1r_job_poll,         1 },
+    { "R_av1r_job_kill",         (DL_FUNC) &R_av1r_job_kill,         2 },
+    { "R_av1r_job_release",      (DL_FUNC) &R_av1r_job_release,      1 },
+    { "R_av1r_probe",            (DL_FUNC) &R_av1r_probe,            1 },
+    { "R_av1r_fingerprint",      (DL_FUNC) &R_av1r_fingerprint,      3 },
+    { "R_av1r_xxh64",            (DL_FUNC) &R_av1r_xxh64,            1 },
+    { "R_av1r_prefetch_start",   (DL_FUNC) &R_av1r_prefetch_start,   3 },
+    { "R_av1r_prefetch_opened",  (DL_FUNC) &R_av1r_prefetch_opened,  3 },
+    { "R_av1r_prefetch_poll",    (DL_FUNC) &R_av1r_prefetch_poll,    1 },
+    { "R_av1r_prefetch_stop",    (DL_FUNC) &R_av1r_prefetch_stop,    1 },
+    { "R_av1r_first_byte",       (DL_FUNC) &R_av1r_first_byte,       1 },
+    { "R_av1r_svt_encode",       (DL_FUNC) &R_av1r_svt_encode,       6 },
+    { "R_av1r_ssim_y4m",         (DL_FUNC) &R_av1r_ssim_y4m,         2 },
+    { "R_av1r_measure",          (DL_FUNC) &R_av1r_measure,          8 },
+    { "R_av1r_content_stats",    (DL_FUNC) &R_av1r_content_stats,    6 },
 #ifdef AV1R_VULKAN_VIDEO_AV1
     { "R_av1r_vulkan_encode",    (DL_FUNC) &R_av1r_vulkan_encode,    6 },
+    { "R_av1r_vulkan_encode_bench", (DL_FUNC) &R_av1r_vulkan_encode_bench, 5 },
 #endif
     { nullptr, nullptr, 0 }
 };
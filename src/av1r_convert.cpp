@@ -0,0 +1,330 @@
+// Source pixel format -> NV12: CPU reference + Vulkan compute pipeline.
+// Формулы CPU и шейдера (src/shaders/av1r_to_nv12.comp) совпадают побайтно.
+
+#include "av1r_convert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+Av1rPixFmt av1r_pix_fmt_from_name(const char* name)
+{
+    const std::string s(name ? name : "");
+    if (s == "nv12")   return AV1R_PIX_NV12;
+    if (s == "gray16") return AV1R_PIX_GRAY16;
+    if (s == "rgb24")  return AV1R_PIX_RGB24;
+    if (s == "i420")   return AV1R_PIX_I420;
+    throw std::runtime_error("Unknown source pixel format: " + s);
+}
+
+const char* av1r_pix_fmt_name(Av1rPixFmt fmt)
+{
+    switch (fmt) {
+    case AV1R_PIX_GRAY16: return "gray16";
+    case AV1R_PIX_RGB24:  return "rgb24";
+    case AV1R_PIX_I420:   return "i420";
+    default:              return "nv12";
+    }
+}
+
+const char* av1r_pix_fmt_ffmpeg(Av1rPixFmt fmt)
+{
+    switch (fmt) {
+    case AV1R_PIX_GRAY16: return "gray16le";
+    case AV1R_PIX_RGB24:  return "rgb24";
+    case AV1R_PIX_I420:   return "yuv420p";
+    default:              return "nv12";
+    }
+}
+
+size_t av1r_pix_fmt_frame_bytes(Av1rPixFmt fmt, int width, int height)
+{
+    const size_t px = static_cast<size_t>(width) * height;
+    switch (fmt) {
+    case AV1R_PIX_GRAY16: return px * 2;
+    case AV1R_PIX_RGB24:  return px * 3;
+    default:              return px * 3 / 2;   // NV12, I420
+    }
+}
+
+size_t av1r_pix_fmt_row_bytes(Av1rPixFmt fmt, int width)
+{
+    switch (fmt) {
+    case AV1R_PIX_GRAY16: return static_cast<size_t>(width) * 2;
+    case AV1R_PIX_RGB24:  return static_cast<size_t>(width) * 3;
+    default:              return static_cast<size_t>(width);
+    }
+}
+
+// ============================================================================
+// CPU reference
+// ============================================================================
+static inline uint8_t window16(uint32_t v, uint32_t lo, uint32_t hi)
+{
+    const uint32_t r = hi - lo;
+    const uint32_t g = std::min(std::max(v, lo), hi);
+    return static_cast<uint8_t>(16u + ((g - lo) * 219u + r / 2u) / r);
+}
+
+static inline uint8_t luma_rgb(int r, int g, int b)
+{
+    return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+void av1r_convert_to_nv12_cpu(Av1rPixFmt fmt, const uint8_t* src, uint8_t* dst,
+                              int width, int height,
+                              uint32_t win_lo, uint32_t win_hi)
+{
+    const size_t W = static_cast<size_t>(width), H = static_cast<size_t>(height);
+    uint8_t* Y  = dst;
+    uint8_t* UV = dst + W * H;
+
+    switch (fmt) {
+    case AV1R_PIX_NV12:
+        std::memcpy(dst, src, W * H * 3 / 2);
+        break;
+
+    case AV1R_PIX_GRAY16: {
+        if (win_hi <= win_lo)
+            throw std::runtime_error("gray16 window must satisfy lo < hi");
+        for (size_t i = 0; i < W * H; i++) {
+            const uint32_t v = src[2 * i] | (static_cast<uint32_t>(src[2 * i + 1]) << 8);
+            Y[i] = window16(v, win_lo, win_hi);
+        }
+        std::memset(UV, 128, W * H / 2);
+        break;
+    }
+
+    case AV1R_PIX_RGB24:
+        for (size_t y = 0; y < H; y += 2) {
+            const uint8_t* r0 = src + y * W * 3;
+            const uint8_t* r1 = r0 + W * 3;
+            for (size_t x = 0; x < W; x += 2) {
+                const uint8_t* p[4] = { r0 + x * 3, r0 + x * 3 + 3, r1 + x * 3, r1 + x * 3 + 3 };
+                Y[y * W + x]           = luma_rgb(p[0][0], p[0][1], p[0][2]);
+                Y[y * W + x + 1]       = luma_rgb(p[1][0], p[1][1], p[1][2]);
+                Y[(y + 1) * W + x]     = luma_rgb(p[2][0], p[2][1], p[2][2]);
+                Y[(y + 1) * W + x + 1] = luma_rgb(p[3][0], p[3][1], p[3][2]);
+                const int r = (p[0][0] + p[1][0] + p[2][0] + p[3][0] + 2) >> 2;
+                const int g = (p[0][1] + p[1][1] + p[2][1] + p[3][1] + 2) >> 2;
+                const int b = (p[0][2] + p[1][2] + p[2][2] + p[3][2] + 2) >> 2;
+                uint8_t* uv = UV + (y / 2) * W + x;
+                uv[0] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                uv[1] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+        break;
+
+    case AV1R_PIX_I420: {
+        std::memcpy(Y, src, W * H);
+        const uint8_t* U = src + W * H;
+        const uint8_t* V = U + (W / 2) * (H / 2);
+        for (size_t y = 0; y < H / 2; y++) {
+            uint8_t* uv = UV + y * W;
+            for (size_t x = 0; x < W / 2; x++) {
+                uv[2 * x]     = U[y * (W / 2) + x];
+                uv[2 * x + 1] = V[y * (W / 2) + x];
+            }
+        }
+        break;
+    }
+    }
+}
+
+#ifdef AV1R_USE_VULKAN
+
+// ============================================================================
+// GPU pipeline
+// ============================================================================
+#ifdef AV1R_HAVE_SHADERS
+static const uint32_t av1r_to_nv12_spv[] = {
+#include "av1r_to_nv12.spv.inc"
+};
+#endif
+
+static const uint32_t LOCAL_X = 16;   // local_size_x in the shader (4 px each)
+static const uint32_t LOCAL_Y = 8;    // local_size_y (2 rows each)
+
+bool av1r_gpu_convert_compiled()
+{
+#ifdef AV1R_HAVE_SHADERS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Av1rGpuConverter::init(VkPhysicalDevice phys, VkDevice device, uint32_t queueFamily,
+                            Av1rPixFmt fmt, int width, int height,
+                            uint32_t winLo, uint32_t winHi)
+{
+    destroy();
+#ifndef AV1R_HAVE_SHADERS
+    (void)phys; (void)device; (void)queueFamily; (void)fmt;
+    (void)width; (void)height; (void)winLo; (void)winHi;
+    throw std::runtime_error("GPU conversion not compiled in (glslc not found at configure)");
+#else
+    if (fmt == AV1R_PIX_NV12)
+        throw std::runtime_error("GPU conversion: source is already NV12");
+    if (width % 4 != 0 || height % 2 != 0)
+        throw std::runtime_error("GPU conversion needs width % 4 == 0 and even height");
+    if (fmt == AV1R_PIX_GRAY16 && winHi <= winLo)
+        throw std::runtime_error("gray16 window must satisfy lo < hi");
+
+    uint32_t qcount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(phys, &qcount, nullptr);
+    std::vector<VkQueueFamilyProperties> qprops(qcount);
+    vkGetPhysicalDeviceQueueFamilyProperties(phys, &qcount, qprops.data());
+    if (queueFamily >= qcount || !(qprops[queueFamily].queueFlags & VK_QUEUE_COMPUTE_BIT))
+        throw std::runtime_error("GPU conversion: transfer queue family has no COMPUTE bit");
+
+    device_   = device;
+    inBytes_  = av1r_pix_fmt_frame_bytes(fmt, width, height);
+    outBytes_ = av1r_pix_fmt_frame_bytes(AV1R_PIX_NV12, width, height);
+    push_[0] = fmt;
+    push_[1] = static_cast<uint32_t>(width);
+    push_[2] = static_cast<uint32_t>(height);
+    push_[3] = winLo;
+    push_[4] = winHi;
+
+    try {
+        // Вход: host-visible (memcpy кадра с CPU), выход: device-local
+        in_ = av1r_buffer_create(phys, device, (inBytes_ + 3) & ~size_t(3),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            0, "convert input");
+        out_ = av1r_buffer_create(phys, device, outBytes_,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, "convert output");
+
+        VkShaderModuleCreateInfo smci{};
+        smci.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        smci.codeSize = sizeof(av1r_to_nv12_spv);
+        smci.pCode    = av1r_to_nv12_spv;
+        if (vkCreateShaderModule(device, &smci, nullptr, &shader_) != VK_SUCCESS)
+            throw std::runtime_error("vkCreateShaderModule failed");
+
+        VkDescriptorSetLayoutBinding binds[2]{};
+        for (uint32_t i = 0; i < 2; i++) {
+            binds[i].binding         = i;
+            binds[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            binds[i].descriptorCount = 1;
+            binds[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        VkDescriptorSetLayoutCreateInfo dslci{};
+        dslci.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        dslci.bindingCount = 2;
+        dslci.pBindings    = binds;
+        if (vkCreateDescriptorSetLayout(device, &dslci, nullptr, &dsl_) != VK_SUCCESS)
+            throw std::runtime_error("vkCreateDescriptorSetLayout failed");
+
+        VkPushConstantRange pcr{};
+        pcr.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pcr.size       = sizeof(push_);
+        VkPipelineLayoutCreateInfo plci{};
+        plci.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        plci.setLayoutCount         = 1;
+        plci.pSetLayouts            = &dsl_;
+        plci.pushConstantRangeCount = 1;
+        plci.pPushConstantRanges    = &pcr;
+        if (vkCreatePipelineLayout(device, &plci, nullptr, &layout_) != VK_SUCCESS)
+            throw std::runtime_error("vkCreatePipelineLayout failed");
+
+        VkComputePipelineCreateInfo cpci{};
+        cpci.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        cpci.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        cpci.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+        cpci.stage.module = shader_;
+        cpci.stage.pName  = "main";
+        cpci.layout       = layout_;
+        VkPipeline pipe = VK_NULL_HANDLE;
+        if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &cpci, nullptr, &pipe) != VK_SUCCESS)
+            throw std::runtime_error("vkCreateComputePipelines failed");
+
+        VkDescriptorPoolSize ps{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 };
+        VkDescriptorPoolCreateInfo dpci{};
+        dpci.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        dpci.maxSets       = 1;
+        dpci.poolSizeCount = 1;
+        dpci.pPoolSizes    = &ps;
+        if (vkCreateDescriptorPool(device, &dpci, nullptr, &pool_) != VK_SUCCESS) {
+            vkDestroyPipeline(device, pipe, nullptr);
+            throw std::runtime_error("vkCreateDescriptorPool failed");
+        }
+
+        VkDescriptorSetAllocateInfo dsai{};
+        dsai.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        dsai.descriptorPool     = pool_;
+        dsai.descriptorSetCount = 1;
+        dsai.pSetLayouts        = &dsl_;
+        if (vkAllocateDescriptorSets(device, &dsai, &set_) != VK_SUCCESS) {
+            vkDestroyPipeline(device, pipe, nullptr);
+            throw std::runtime_error("vkAllocateDescriptorSets failed");
+        }
+
+        VkDescriptorBufferInfo dbi[2]{};
+        dbi[0].buffer = in_.buffer;  dbi[0].range = VK_WHOLE_SIZE;
+        dbi[1].buffer = out_.buffer; dbi[1].range = VK_WHOLE_SIZE;
+        VkWriteDescriptorSet w[2]{};
+        for (uint32_t i = 0; i < 2; i++) {
+            w[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            w[i].dstSet          = set_;
+            w[i].dstBinding      = i;
+            w[i].descriptorCount = 1;
+            w[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            w[i].pBufferInfo     = &dbi[i];
+        }
+        vkUpdateDescriptorSets(device, 2, w, 0, nullptr);
+
+        pipeline_ = pipe;   // ready() только после полной инициализации
+    } catch (...) {
+        destroy();
+        throw;
+    }
+#endif
+}
+
+void Av1rGpuConverter::record(VkCommandBuffer cmd)
+{
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout_,
+                            0, 1, &set_, 0, nullptr);
+    vkCmdPushConstants(cmd, layout_, VK_SHADER_STAGE_COMPUTE_BIT,
+                       0, sizeof(push_), push_);
+    const uint32_t gx = (push_[1] / 4 + LOCAL_X - 1) / LOCAL_X;
+    const uint32_t gy = (push_[2] / 2 + LOCAL_Y - 1) / LOCAL_Y;
+    vkCmdDispatch(cmd, gx, gy, 1);
+
+    // compute write → transfer read (vkCmdCopyBufferToImage / vkCmdCopyBuffer)
+    VkBufferMemoryBarrier b{};
+    b.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    b.srcAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+    b.dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.buffer              = out_.buffer;
+    b.size                = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         0, nullptr, 1, &b, 0, nullptr);
+}
+
+void Av1rGpuConverter::destroy()
+{
+    if (device_ == VK_NULL_HANDLE) return;
+    if (pool_)     vkDestroyDescriptorPool(device_, pool_, nullptr);
+    if (pipeline_) vkDestroyPipeline(device_, pipeline_, nullptr);
+    if (layout_)   vkDestroyPipelineLayout(device_, layout_, nullptr);
+    if (dsl_)      vkDestroyDescriptorSetLayout(device_, dsl_, nullptr);
+    if (shader_)   vkDestroyShaderModule(device_, shader_, nullptr);
+    av1r_buffer_destroy(device_, in_);
+    av1r_buffer_destroy(device_, out_);
+    pool_ = VK_NULL_HANDLE; pipeline_ = VK_NULL_HANDLE; layout_ = VK_NULL_HANDLE;
+    dsl_ = VK_NULL_HANDLE; shader_ = VK_NULL_HANDLE; set_ = VK_NULL_HANDLE;
+    device_ = VK_NULL_HANDLE;
+}
+
+#endif // AV1R_USE_VULKAN
@@ -0,0 +1,81 @@
+// Source pixel format -> NV12 conversion for the Vulkan encoder.
+// GPU path: compute shader (src/shaders/av1r_to_nv12.comp) on the transfer
+// queue family, output copied into the encoder's source image.
+// CPU path: bit-exact reference, used as fallback and by the benchmark.
+
+#ifndef AV1R_CONVERT_H
+#define AV1R_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Values match the shader's push constant `fmt`
+enum Av1rPixFmt : uint32_t {
+    AV1R_PIX_NV12   = 0,   // passthrough
+    AV1R_PIX_GRAY16 = 1,   // gray16le, windowed to limited-range Y
+    AV1R_PIX_RGB24  = 2,   // packed R,G,B
+    AV1R_PIX_I420   = 3,   // yuv420p (planar Y, U, V)
+};
+
+// "nv12" / "gray16" / "rgb24" / "i420"; throws on unknown names
+Av1rPixFmt  av1r_pix_fmt_from_name(const char* name);
+const char* av1r_pix_fmt_name(Av1rPixFmt fmt);
+// ffmpeg -pix_fmt for the rawvideo pipe
+const char* av1r_pix_fmt_ffmpeg(Av1rPixFmt fmt);
+// Bytes per frame of width x height (even dimensions)
+size_t      av1r_pix_fmt_frame_bytes(Av1rPixFmt fmt, int width, int height);
+// Bytes per row of the first plane (what frame analysis looks at)
+size_t      av1r_pix_fmt_row_bytes(Av1rPixFmt fmt, int width);
+
+// BT.601 limited range. gray16: [win_lo, win_hi] -> Y 16..235, UV = 128.
+// Same integer math as the shader, so both paths give identical bytes.
+void av1r_convert_to_nv12_cpu(Av1rPixFmt fmt, const uint8_t* src, uint8_t* dst,
+                              int width, int height,
+                              uint32_t win_lo = 0, uint32_t win_hi = 65535);
+
+#ifdef AV1R_USE_VULKAN
+
+#include <vulkan/vulkan.h>
+#include "av1r_vulkan_ctx.h"
+
+// true when configure found glslc and the SPIR-V was compiled in
+bool av1r_gpu_convert_compiled();
+
+// Compute pipeline converting one frame per record() into an NV12 storage
+// buffer. The caller copies the frame into input() before submitting.
+class Av1rGpuConverter {
+public:
+    // Throws std::runtime_error when the shader is not compiled in, the queue
+    // family has no COMPUTE bit or width is not a multiple of 4.
+    void init(VkPhysicalDevice phys, VkDevice device, uint32_t queueFamily,
+              Av1rPixFmt fmt, int width, int height,
+              uint32_t winLo, uint32_t winHi);
+    void destroy();
+    bool ready() const { return pipeline_ != VK_NULL_HANDLE; }
+
+    uint8_t* input() { return static_cast<uint8_t*>(in_.ptr); }
+    size_t   input_bytes() const { return inBytes_; }
+    VkBuffer nv12_buffer() const { return out_.buffer; }
+    size_t   nv12_bytes() const { return outBytes_; }
+
+    // Dispatch + barrier making the NV12 buffer readable by transfer commands
+    void record(VkCommandBuffer cmd);
+
+    ~Av1rGpuConverter() { destroy(); }
+
+private:
+    VkDevice              device_   = VK_NULL_HANDLE;
+    VkShaderModule        shader_   = VK_NULL_HANDLE;
+    VkDescriptorSetLayout dsl_      = VK_NULL_HANDLE;
+    VkPipelineLayout      layout_   = VK_NULL_HANDLE;
+    VkPipeline            pipeline_ = VK_NULL_HANDLE;
+    VkDescriptorPool      pool_     = VK_NULL_HANDLE;
+    VkDescriptorSet       set_      = VK_NULL_HANDLE;
+    Av1rBuffer            in_{}, out_{};
+    size_t                inBytes_ = 0, outBytes_ = 0;
+    uint32_t              push_[5] = {};   // fmt, width, height, winLo, winHi
+};
+
+#endif // AV1R_USE_VULKAN
+
+#endif
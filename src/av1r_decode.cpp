@@ -0,0 +1,365 @@
+// Raw frame sources (см. av1r_decode.h): libav в процессе, если собран
+// с AV1R_HAVE_LIBAV, иначе ffmpeg через popen.
+
+#include "av1r_decode.h"
+#include "av1r_trace.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef AV1R_HAVE_LIBAV
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+#ifndef _WIN32
+#  include <cerrno>
+#  include <csignal>
+#  include <poll.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+namespace {
+
+// ============================================================================
+// ffmpeg child process: ffmpeg ... -f rawvideo - | fread
+// ============================================================================
+
+// Last lines of the ffmpeg log, joined with "; "
+std::string log_tail(const std::string& path, size_t lines) {
+    std::ifstream in(path.c_str());
+    std::vector<std::string> all;
+    std::string line;
+    while (std::getline(in, line)) if (!line.empty()) all.push_back(line);
+    std::string out;
+    for (size_t i = all.size() > lines ? all.size() - lines : 0; i < all.size(); i++)
+        out += (out.empty() ? "" : "; ") + all[i];
+    return out;
+}
+
+class PipeSource : public Av1rFrameSource {
+public:
+    explicit PipeSource(const Av1rDecodeConfig& cfg)
+        : cfg_(cfg), frameBytes_(av1r_pix_fmt_frame_bytes(cfg.format, cfg.width, cfg.height)) {
+        // Image sequences (printf pattern with %) and TIFF need -framerate before -i
+        const std::string& inp = cfg.input;
+        const bool image_seq = inp.find('%') != std::string::npos ||
+            (inp.size() >= 4 && inp.compare(inp.size() - 4, 4, ".tif") == 0) ||
+            (inp.size() >= 5 && inp.compare(inp.size() - 5, 5, ".tiff") == 0);
+
+        std::string cmd = "ffmpeg -nostdin -loglevel error";
+        if (image_seq) cmd += " -framerate " + std::to_string(cfg.fps);
+        if (cfg.startSec > 0) cmd += " -ss " + std::to_string(cfg.startSec);
+        cmd += " -i \"" + inp + "\"";
+        if (cfg.maxFrames > 0) cmd += " -frames:v " + std::to_string(cfg.maxFrames);
+        cmd += std::string(" -f rawvideo -pix_fmt ") + av1r_pix_fmt_ffmpeg(cfg.format) +
+               " -vf scale=" + std::to_string(cfg.width) + ":" + std::to_string(cfg.height) +
+               " -an - 2>" + (cfg.logFile.empty() ? std::string("/dev/null")
+                                                  : "\"" + cfg.logFile + "\"");
+
+#ifndef _WIN32
+        // The shell reports its pid on the first line before exec'ing
+        // ffmpeg, so an interrupted read can terminate the decode
+        cmd = "echo $$; exec " + cmd;
+#endif
+
+        // ffmpeg decode lives from popen to pclose: its own process row in the trace
+        track_ = av1r_trace_child("ffmpeg decode");
+        start_ = av1r_trace_now_us();
+        pipe_  = popen(cmd.c_str(), "r");
+        if (!pipe_) throw std::runtime_error("Failed to open ffmpeg pipe");
+#ifndef _WIN32
+        char c = 0;
+        long pid = 0;
+        ssize_t k;
+        while ((k = ::read(fileno(pipe_), &c, 1)) != 0 && c != '\n') {
+            if (k < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (c >= '0' && c <= '9') pid = pid * 10 + (c - '0');
+        }
+        pid_ = static_cast<pid_t>(pid);
+#endif
+    }
+    ~PipeSource() override { close(); }
+
+    bool read(uint8_t* dst) override {
+        if (!pipe_) return false;
+        const int64_t t0 = av1r_trace_now_us();
+        const size_t got = fill(dst, frameBytes_);
+        av1r_trace_span("pipe read", "io", t0, av1r_trace_now_us() - t0);
+        if (got == frameBytes_) return true;
+        if (interrupted_) {
+            error_ = "interrupted";
+            close();
+            return false;
+        }
+        const int st = close();
+        if (st != 0) {
+            error_ = "ffmpeg decode exited with status " + std::to_string(st);
+            const std::string tail = cfg_.logFile.empty() ? std::string() : log_tail(cfg_.logFile, 3);
+            if (!tail.empty()) error_ += ": " + tail;
+        }
+        return false;
+    }
+    std::string error() const override { return error_; }
+    const char* name() const override { return "pipe"; }
+private:
+    // Reads up to `n` bytes of the pipe; fewer at its end or on an
+    // interrupt (interrupted_, ffmpeg terminated). The POSIX path reads the
+    // descriptor directly (no stdio buffer) so poll() sees all pending data.
+    size_t fill(uint8_t* dst, size_t n) {
+#ifdef _WIN32
+        return std::fread(dst, 1, n, pipe_);
+#else
+        const int fd = fileno(pipe_);
+        size_t got = 0;
+        while (got < n && !interrupted_) {
+            if (cfg_.interrupted) {
+                pollfd p = { fd, POLLIN, 0 };
+                const int r = ::poll(&p, 1, 100);
+                if (cfg_.interrupted()) {
+                    interrupted_ = true;
+                    if (pid_ > 0) ::kill(pid_, SIGTERM);
+                    break;
+                }
+                if (r == 0 || (r < 0 && errno == EINTR)) continue;
+            }
+            const ssize_t k = ::read(fd, dst + got, n - got);
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) break;
+            got += static_cast<size_t>(k);
+        }
+        return got;
+#endif
+    }
+    // Exit status of ffmpeg (0 once closed)
+    int close() {
+        if (!pipe_) return 0;
+        const int st = pclose(pipe_);
+        pipe_ = nullptr;
+        av1r_trace_span("ffmpeg decode", "process", start_, av1r_trace_now_us() - start_, track_);
+#ifdef _WIN32
+        return st;
+#else
+        return st == -1 ? 127 : WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+#endif
+    }
+
+    Av1rDecodeConfig cfg_;
+    size_t      frameBytes_;
+    FILE*       pipe_  = nullptr;
+#ifndef _WIN32
+    pid_t       pid_   = 0;
+#endif
+    bool        interrupted_ = false;
+    uint32_t    track_ = 0;
+    int64_t     start_ = 0;
+    std::string error_;
+};
+
+// ============================================================================
+// In-process decode: libavformat → libavcodec (frame threads) → swscale
+// ============================================================================
+#ifdef AV1R_HAVE_LIBAV
+
+std::string av_err(int err) {
+    char buf[AV_ERROR_MAX_STRING_SIZE] = { 0 };
+    av_strerror(err, buf, sizeof(buf));
+    return buf;
+}
+
+AVPixelFormat av_pix_fmt(Av1rPixFmt fmt) {
+    switch (fmt) {
+    case AV1R_PIX_GRAY16: return AV_PIX_FMT_GRAY16LE;
+    case AV1R_PIX_RGB24:  return AV_PIX_FMT_RGB24;
+    case AV1R_PIX_I420:   return AV_PIX_FMT_YUV420P;
+    default:              return AV_PIX_FMT_NV12;
+    }
+}
+
+class LibavSource : public Av1rFrameSource {
+public:
+    explicit LibavSource(const Av1rDecodeConfig& cfg) : cfg_(cfg), dstFmt_(av_pix_fmt(cfg.format)) {
+        AV1R_TRACE_SPAN("libav open", "decode");
+        av_log_set_level(AV_LOG_QUIET);   // ошибки возвращаются кодами
+        // Image sequences: image2 demuxer at the requested rate, like -framerate
+#if LIBAVFORMAT_VERSION_MAJOR >= 59
+        const AVInputFormat* ifmt = nullptr;
+#else
+        AVInputFormat* ifmt = nullptr;
+#endif
+        AVDictionary* opts = nullptr;
+        // Blocking reads (open, av_read_frame) poll cfg.interrupted
+        fmt_ = avformat_alloc_context();
+        if (!fmt_) fail("avformat_alloc_context failed");
+        if (cfg_.interrupted) {
+            fmt_->interrupt_callback.callback = &LibavSource::interrupt_cb;
+            fmt_->interrupt_callback.opaque   = this;
+        }
+        if (cfg.input.find('%') != std::string::npos) {
+            ifmt = av_find_input_format("image2");
+            av_dict_set(&opts, "framerate", std::to_string(cfg.fps).c_str(), 0);
+        }
+        int err = avformat_open_input(&fmt_, cfg.input.c_str(), ifmt, &opts);
+        av_dict_free(&opts);
+        if (interrupted_) fail("interrupted");
+        if (err < 0) fail("cannot open " + cfg.input, err);
+        if ((err = avformat_find_stream_info(fmt_, nullptr)) < 0) fail("cannot read stream info", err);
+        stream_ = av_find_best_stream(fmt_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (stream_ < 0) fail("no video stream", stream_);
+        for (unsigned i = 0; i < fmt_->nb_streams; i++)
+            if (static_cast<int>(i) != stream_) fmt_->streams[i]->discard = AVDISCARD_ALL;
+
+        const AVCodecParameters* par = fmt_->streams[stream_]->codecpar;
+        const AVCodec* codec = avcodec_find_decoder(par->codec_id);
+        if (!codec) fail(std::string("no decoder for ") + avcodec_get_name(par->codec_id));
+        dec_ = avcodec_alloc_context3(codec);
+        if (!dec_) fail("avcodec_alloc_context3 failed");
+        if ((err = avcodec_parameters_to_context(dec_, par)) < 0) fail("decoder parameters", err);
+        dec_->thread_count = cfg.threads;   // 0 = по числу ядер
+        dec_->thread_type  = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        if ((err = avcodec_open2(dec_, codec, nullptr)) < 0) fail("cannot open decoder", err);
+        pkt_   = av_packet_alloc();
+        frame_ = av_frame_alloc();
+        if (!pkt_ || !frame_) fail("av_frame_alloc failed");
+
+        // Seek to the keyframe before startSec; read() drops the frames
+        // decoded before it. Inputs that cannot seek are decoded from the
+        // start and dropped up to it as well.
+        if (cfg.startSec > 0) {
+            const AVStream* st = fmt_->streams[stream_];
+            const int64_t t0 = st->start_time == AV_NOPTS_VALUE ? 0 : st->start_time;
+            startPts_ = t0 + av_rescale_q(static_cast<int64_t>(cfg.startSec * AV_TIME_BASE),
+                                          av_make_q(1, AV_TIME_BASE), st->time_base);
+            av_seek_frame(fmt_, stream_, startPts_, AVSEEK_FLAG_BACKWARD);
+        }
+    }
+    ~LibavSource() override { release(); }
+
+    bool read(uint8_t* dst) override {
+        if (cfg_.maxFrames > 0 && frames_ >= cfg_.maxFrames) return false;
+        AV1R_TRACE_SPAN("decode", "decode");
+        for (;;) {
+            if (!next_frame()) return false;
+            const int64_t pts = frame_->best_effort_timestamp;
+            if (startPts_ == AV_NOPTS_VALUE || pts == AV_NOPTS_VALUE || pts >= startPts_) break;
+            av_frame_unref(frame_);
+        }
+        // Scaled and converted straight into the encoder's frame buffer;
+        // the context is rebuilt if the source size or format changes
+        sws_ = sws_getCachedContext(sws_, frame_->width, frame_->height,
+                                    static_cast<AVPixelFormat>(frame_->format),
+                                    cfg_.width, cfg_.height, dstFmt_, SWS_BICUBIC,
+                                    nullptr, nullptr, nullptr);
+        if (!sws_) {
+            error_ = std::string("swscale cannot convert ") +
+                     av_get_pix_fmt_name(static_cast<AVPixelFormat>(frame_->format));
+            return false;
+        }
+        uint8_t* planes[4];
+        int      lines[4];
+        av_image_fill_arrays(planes, lines, dst, dstFmt_, cfg_.width, cfg_.height, 1);
+        sws_scale(sws_, frame_->data, frame_->linesize, 0, frame_->height, planes, lines);
+        av_frame_unref(frame_);
+        frames_++;
+        return true;
+    }
+    std::string error() const override { return error_; }
+    const char* name() const override { return "libav"; }
+private:
+    // Constructor errors: the destructor will not run
+    [[noreturn]] void fail(const std::string& msg) {
+        release();
+        throw std::runtime_error(msg);
+    }
+    [[noreturn]] void fail(const std::string& what, int err) { fail(what + ": " + av_err(err)); }
+    static int interrupt_cb(void* opaque) {
+        LibavSource* self = static_cast<LibavSource*>(opaque);
+        if (!self->interrupted_ && self->cfg_.interrupted()) self->interrupted_ = true;
+        return self->interrupted_ ? 1 : 0;
+    }
+    void release() {
+        sws_freeContext(sws_);
+        sws_ = nullptr;
+        av_frame_free(&frame_);
+        av_packet_free(&pkt_);
+        avcodec_free_context(&dec_);
+        avformat_close_input(&fmt_);
+    }
+    // Next decoded frame into frame_; false at the end or on an error
+    bool next_frame() {
+        for (;;) {
+            int err = avcodec_receive_frame(dec_, frame_);
+            if (err == 0) return true;
+            if (err == AVERROR_EOF) return false;
+            if (err != AVERROR(EAGAIN)) { error_ = "decode: " + av_err(err); return false; }
+            if (flushing_) return false;
+            err = av_read_frame(fmt_, pkt_);
+            if (err == AVERROR_EOF) {
+                flushing_ = true;
+                avcodec_send_packet(dec_, nullptr);
+                continue;
+            }
+            if (err < 0) {
+                error_ = interrupted_ ? std::string("interrupted") : "read: " + av_err(err);
+                return false;
+            }
+            if (pkt_->stream_index == stream_) err = avcodec_send_packet(dec_, pkt_);
+            av_packet_unref(pkt_);
+            // Corrupt packets are skipped, as the ffmpeg CLI does
+            if (err < 0 && err != AVERROR_INVALIDDATA) {
+                error_ = "decode: " + av_err(err);
+                return false;
+            }
+        }
+    }
+
+    Av1rDecodeConfig cfg_;
+    AVPixelFormat    dstFmt_;
+    AVFormatContext* fmt_   = nullptr;
+    AVCodecContext*  dec_   = nullptr;
+    SwsContext*      sws_   = nullptr;
+    AVPacket*        pkt_   = nullptr;
+    AVFrame*         frame_ = nullptr;
+    int              stream_ = -1;
+    int              frames_ = 0;
+    int64_t          startPts_ = AV_NOPTS_VALUE;   // stream time base
+    bool             flushing_ = false;
+    bool             interrupted_ = false;
+    std::string      error_;
+};
+
+#endif // AV1R_HAVE_LIBAV
+
+} // namespace
+
+std::unique_ptr<Av1rFrameSource> av1r_libav_source(const Av1rDecodeConfig& cfg) {
+#ifdef AV1R_HAVE_LIBAV
+    return std::unique_ptr<Av1rFrameSource>(new LibavSource(cfg));
+#else
+    (void)cfg;
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<Av1rFrameSource> av1r_pipe_source(const Av1rDecodeConfig& cfg) {
+    return std::unique_ptr<Av1rFrameSource>(new PipeSource(cfg));
+}
+
+std::string av1r_libav_version() {
+#ifdef AV1R_HAVE_LIBAV
+    return AV_STRINGIFY(LIBAVCODEC_VERSION);
+#else
+    return "";
+#endif
+}
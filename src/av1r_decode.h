@@ -0,0 +1,63 @@
+// Raw frame sources for the Vulkan encode loop (R_av1r_vulkan_encode).
+//
+// With libavformat/libavcodec/libswscale found by configure
+// (AV1R_HAVE_LIBAV), the input is decoded in-process: frame-threaded
+// decode, and swscale writes the scaled frame in the encoder's source
+// layout straight into the caller's frame buffer. No shell, no child
+// process, no pipe copy, and decoder errors come back as messages.
+// Otherwise (or when libav cannot open the input) the frames come from
+// `ffmpeg ... -f rawvideo -` through popen, as before; its stderr goes to
+// a log file whose tail is reported when decoding fails.
+//
+// Both sources poll Av1rDecodeConfig::interrupted while they wait, so a
+// stalled input (network mount, slow pipe) can still be interrupted: libav
+// through its AVIOInterruptCB, the pipe every 100 ms of poll(), after which
+// ffmpeg gets SIGTERM.
+
+#ifndef AV1R_DECODE_H
+#define AV1R_DECODE_H
+
+#include "av1r_convert.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+struct Av1rDecodeConfig {
+    std::string input;             // file or printf pattern (image sequence)
+    int         width     = 0;     // output size (even), scaled to if different
+    int         height    = 0;
+    int         fps       = 25;    // frame rate of image sequences
+    int         maxFrames = 0;     // 0 = all
+    double      startSec  = 0;     // first frame at or after this time (seek)
+    int         threads   = 0;     // decoder threads, 0 = auto
+    Av1rPixFmt  format    = AV1R_PIX_NV12;
+    std::string logFile;           // pipe: ffmpeg stderr ("" = discarded)
+    // Polled while a read waits for input (R thread only); true stops the
+    // decode with error() "interrupted". Empty = never polled.
+    std::function<bool()> interrupted;
+};
+
+class Av1rFrameSource {
+public:
+    virtual ~Av1rFrameSource() {}
+    // Next frame (av1r_pix_fmt_frame_bytes() bytes) into `dst`; false at
+    // the end of the input or on an error
+    virtual bool read(uint8_t* dst) = 0;
+    // Why read() returned false; "" for a clean end of the input
+    virtual std::string error() const = 0;
+    // "libav" or "pipe"
+    virtual const char* name() const = 0;
+};
+
+// In-process decoder; nullptr when built without libav. Throws
+// std::runtime_error when the input cannot be opened or decoded.
+std::unique_ptr<Av1rFrameSource> av1r_libav_source(const Av1rDecodeConfig& cfg);
+// ffmpeg child process; throws std::runtime_error if popen fails
+std::unique_ptr<Av1rFrameSource> av1r_pipe_source(const Av1rDecodeConfig& cfg);
+
+// Version of the linked libavcodec ("" without libav)
+std::string av1r_libav_version();
+
+#endif
@@ -0,0 +1,113 @@
+// Temporal denoise prefilter: out = ref + (in - ref) * alpha(|in - ref|) / 64
+// alpha = min(64, a0 + slope * min(|in - ref|, 63) / 4) — маленькие разности (шум)
+// усредняются с предыдущим кадром, большие (движение) проходят как есть.
+// SSE2 по 16 байт, строки NV12 (Y + UV) делятся между потоками.
+
+#include "av1r_denoise.h"
+#include "av1r_trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define AV1R_DENOISE_SSE2 1
+#endif
+
+static inline uint8_t blend1(int in, int ref, int a0, int slope) {
+    const int d = in - ref;
+    const int alpha = std::min(64, a0 + ((std::min(std::abs(d), 63) * slope) >> 2));
+    return static_cast<uint8_t>(ref + ((d * alpha + 32) >> 6));
+}
+
+// Filter n bytes of `cur` against `ref`; result goes to both
+static void blend_span(uint8_t* cur, uint8_t* ref, size_t n, int a0, int slope) {
+    size_t i = 0;
+#if defined(AV1R_DENOISE_SSE2)
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128i a0v    = _mm_set1_epi16(static_cast<short>(a0));
+    const __m128i slopev = _mm_set1_epi16(static_cast<short>(slope));
+    const __m128i max64  = _mm_set1_epi16(64);
+    const __m128i max63  = _mm_set1_epi16(63);
+    const __m128i round  = _mm_set1_epi16(32);
+    for (; i + 16 <= n; i += 16) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+        __m128i rf = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ref + i));
+        __m128i out[2];
+        for (int h = 0; h < 2; h++) {
+            __m128i in16 = h ? _mm_unpackhi_epi8(in, zero) : _mm_unpacklo_epi8(in, zero);
+            __m128i rf16 = h ? _mm_unpackhi_epi8(rf, zero) : _mm_unpacklo_epi8(rf, zero);
+            __m128i d    = _mm_sub_epi16(in16, rf16);
+            __m128i ad   = _mm_min_epi16(_mm_max_epi16(d, _mm_sub_epi16(zero, d)), max63);
+            __m128i a    = _mm_min_epi16(_mm_add_epi16(a0v,
+                               _mm_srai_epi16(_mm_mullo_epi16(ad, slopev), 2)), max64);
+            __m128i t    = _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(d, a), round), 6);
+            out[h] = _mm_add_epi16(rf16, t);
+        }
+        __m128i o = _mm_packus_epi16(out[0], out[1]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(cur + i), o);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ref + i), o);
+    }
+#endif
+    for (; i < n; i++) {
+        cur[i] = blend1(cur[i], ref[i], a0, slope);
+        ref[i] = cur[i];
+    }
+}
+
+void Av1rTemporalDenoiser::reset(int width, int height, double strength, int threads) {
+    rowBytes_ = static_cast<size_t>(width);
+    rows_     = static_cast<size_t>(height) * 3 / 2;    // Y + interleaved UV
+    haveRef_  = false;
+
+    strength = std::min(1.0, std::max(0.0, strength));
+    // strength 1: новый кадр весит ~0.15 при |diff| = 0, полностью — с |diff| >= 32
+    a0_ = static_cast<int>(std::lround(64.0 * (1.0 - 0.85 * strength)));
+    const int thr = 4 + static_cast<int>(std::lround(28.0 * strength));
+    slope_ = a0_ < 64 ? (4 * (64 - a0_) + thr - 1) / thr : 0;   // в 1/4
+
+    // Reference frame only when the filter is on (apply() is not called otherwise)
+    if (enabled()) {
+        ref_.assign(rowBytes_ * rows_, 0);
+    } else {
+        ref_.clear();
+        ref_.shrink_to_fit();
+    }
+    mem_.set(AV1R_MEM_HOST, "denoise reference", ref_.capacity());
+
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    threads_ = std::max(1, std::min(threads, 8));
+}
+
+void Av1rTemporalDenoiser::apply(uint8_t* nv12) {
+    if (!enabled()) return;
+    if (!haveRef_) {
+        std::memcpy(ref_.data(), nv12, ref_.size());
+        haveRef_ = true;
+        return;
+    }
+
+    const int nThreads = static_cast<int>(std::min<size_t>(threads_, rows_ / 16 + 1));
+    if (nThreads <= 1) {
+        blend_span(nv12, ref_.data(), ref_.size(), a0_, slope_);
+        return;
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(static_cast<size_t>(nThreads));
+    const size_t band = (rows_ + nThreads - 1) / nThreads;
+    for (int t = 0; t < nThreads; t++) {
+        const size_t r0 = t * band, r1 = std::min(rows_, r0 + band);
+        if (r0 >= r1) break;
+        // Потоки создаются на каждый кадр: в trace — стабильная дорожка на полосу
+        const uint32_t track = av1r_trace_on()
+            ? av1r_trace_track(("denoise band " + std::to_string(t)).c_str()) : 0;
+        pool.emplace_back([=]() {
+            Av1rTraceSpan span("denoise rows", "filter", track);
+            blend_span(nv12 + r0 * rowBytes_, ref_.data() + r0 * rowBytes_,
+                       (r1 - r0) * rowBytes_, a0_, slope_);
+        });
+    }
+    for (auto& th : pool) th.join();
+}
@@ -0,0 +1,37 @@
+// Temporal denoise prefilter for NV12 frames (CPU, SSE2 + row-parallel threads).
+// Recursive motion-adaptive filter: each sample is blended with the previous
+// filtered frame; the blend weight rises with |difference| so shot noise is
+// averaged out while real changes (motion, stage moves) pass through.
+
+#ifndef AV1R_DENOISE_H
+#define AV1R_DENOISE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "av1r_memstats.h"
+
+class Av1rTemporalDenoiser {
+public:
+    Av1rTemporalDenoiser() = default;
+    ~Av1rTemporalDenoiser() { mem_.release(); }
+    Av1rTemporalDenoiser(const Av1rTemporalDenoiser&) = delete;
+    Av1rTemporalDenoiser& operator=(const Av1rTemporalDenoiser&) = delete;
+
+    // strength 0..1 (0 = off); threads 0 = hardware concurrency (max 8)
+    void reset(int width, int height, double strength, int threads);
+    bool enabled() const { return a0_ < 64; }
+    // Filter one NV12 frame in place; the first frame becomes the reference
+    void apply(uint8_t* nv12);
+private:
+    size_t rowBytes_ = 0, rows_ = 0;
+    int a0_ = 64;        // weight of the new sample at |diff| = 0, in 1/64
+    int slope_ = 0;      // weight increase per unit of |diff|, in 1/4
+    int threads_ = 1;
+    std::vector<uint8_t> ref_;
+    bool haveRef_ = false;
+    Av1rMemCharge mem_;
+};
+
+#endif
@@ -0,0 +1,160 @@
+// In-process SVT-AV1 encode (см. av1r_encode_svt.h)
+
+#include "av1r_encode_svt.h"
+#include "av1r_trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef AV1R_HAVE_SVTAV1
+#include <svt-av1/EbSvtAv1Enc.h>
+#endif
+
+#ifdef AV1R_HAVE_SVTAV1
+
+namespace {
+
+[[noreturn]] void svt_fail(const char* what, EbErrorType err) {
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "SVT-AV1 %s failed (0x%x)", what, static_cast<unsigned>(err));
+    throw std::runtime_error(buf);
+}
+
+} // namespace
+
+struct Av1rSvtEncoder::Impl {
+    EbComponentType*         handle = nullptr;
+    EbSvtAv1EncConfiguration param;
+    EbSvtIOFormat            picture;
+    EbBufferHeaderType       input;
+    int  width = 0, height = 0;
+    bool initialized = false;   // svt_av1_enc_init succeeded
+    bool finishing   = false;   // EOS sent
+    bool eos         = false;   // EOS received
+
+    ~Impl() {
+        if (initialized) svt_av1_enc_deinit(handle);
+        if (handle) svt_av1_enc_deinit_handle(handle);
+    }
+};
+
+Av1rSvtEncoder::Av1rSvtEncoder(const Av1rSvtConfig& cfg) : impl_(new Impl) {
+    AV1R_TRACE_SPAN("svt init", "encode");
+    Impl& s = *impl_;
+    s.width  = cfg.width;
+    s.height = cfg.height;
+    std::memset(&s.param, 0, sizeof(s.param));
+#if SVT_AV1_CHECK_VERSION(3, 0, 0)
+    EbErrorType err = svt_av1_enc_init_handle(&s.handle, &s.param);
+#else
+    EbErrorType err = svt_av1_enc_init_handle(&s.handle, nullptr, &s.param);
+#endif
+    if (err != EB_ErrorNone) svt_fail("init_handle", err);
+
+    // Defaults filled in by init_handle; only what AV1R controls is changed
+    EbSvtAv1EncConfiguration& p = s.param;
+    p.source_width           = static_cast<uint32_t>(cfg.width);
+    p.source_height          = static_cast<uint32_t>(cfg.height);
+    p.frame_rate_numerator   = static_cast<uint32_t>(cfg.fps);
+    p.frame_rate_denominator = 1;
+    p.encoder_bit_depth      = 8;
+    p.encoder_color_format   = EB_YUV420;
+    p.enc_mode               = static_cast<int8_t>(cfg.preset);
+    p.rate_control_mode      = 0;   // CRF (CQP with adaptive quantization)
+    p.qp                     = static_cast<uint32_t>(cfg.crf);
+    if (cfg.keyintMax > 0) p.intra_period_length = cfg.keyintMax - 1;
+    if (cfg.lookahead >= 0) p.look_ahead_distance = static_cast<uint32_t>(cfg.lookahead);
+    if (cfg.threads > 0) {
+#if SVT_AV1_CHECK_VERSION(3, 0, 0)
+        p.level_of_parallelism = static_cast<uint32_t>(cfg.threads);
+#else
+        p.logical_processors   = static_cast<uint32_t>(cfg.threads);
+#endif
+    }
+    if ((err = svt_av1_enc_set_parameter(s.handle, &p)) != EB_ErrorNone)
+        svt_fail("set_parameter", err);
+    if ((err = svt_av1_enc_init(s.handle)) != EB_ErrorNone) svt_fail("init", err);
+    s.initialized = true;
+
+    // One input header reused for every frame: SVT copies the picture
+    std::memset(&s.picture, 0, sizeof(s.picture));
+    std::memset(&s.input, 0, sizeof(s.input));
+    s.picture.y_stride  = static_cast<uint32_t>(cfg.width);
+    s.picture.cb_stride = static_cast<uint32_t>(cfg.width / 2);
+    s.picture.cr_stride = static_cast<uint32_t>(cfg.width / 2);
+    s.input.size        = sizeof(EbBufferHeaderType);
+    s.input.p_buffer    = reinterpret_cast<uint8_t*>(&s.picture);
+    s.input.n_filled_len = static_cast<uint32_t>(cfg.width * cfg.height * 3 / 2);
+    s.input.pic_type    = EB_AV1_INVALID_PICTURE;
+}
+
+Av1rSvtEncoder::~Av1rSvtEncoder() {}
+
+void Av1rSvtEncoder::send(const uint8_t* i420, int64_t pts) {
+    Impl& s = *impl_;
+    const size_t luma = static_cast<size_t>(s.width) * s.height;
+    s.picture.luma = const_cast<uint8_t*>(i420);
+    s.picture.cb   = const_cast<uint8_t*>(i420 + luma);
+    s.picture.cr   = const_cast<uint8_t*>(i420 + luma + luma / 4);
+    s.input.pts    = pts;
+    s.input.flags  = 0;
+    EbErrorType err = svt_av1_enc_send_picture(s.handle, &s.input);
+    if (err != EB_ErrorNone) svt_fail("send_picture", err);
+}
+
+void Av1rSvtEncoder::finish() {
+    Impl& s = *impl_;
+    if (s.finishing) return;
+    EbBufferHeaderType eos;
+    std::memset(&eos, 0, sizeof(eos));
+    eos.flags    = EB_BUFFERFLAG_EOS;
+    eos.pic_type = EB_AV1_INVALID_PICTURE;
+    EbErrorType err = svt_av1_enc_send_picture(s.handle, &eos);
+    if (err != EB_ErrorNone) svt_fail("send_picture (EOS)", err);
+    s.finishing = true;
+}
+
+bool Av1rSvtEncoder::receive(Av1rSvtPacket& pkt) {
+    Impl& s = *impl_;
+    if (s.eos) return false;
+    EbBufferHeaderType* out = nullptr;
+    // After EOS get_packet blocks until the encoder has a packet
+    EbErrorType err = svt_av1_enc_get_packet(s.handle, &out, s.finishing ? 1 : 0);
+    if (err == EB_NoErrorEmptyQueue) return false;
+    if (err != EB_ErrorNone) svt_fail("get_packet", err);
+    const bool last = (out->flags & EB_BUFFERFLAG_EOS) != 0;
+    const bool have = out->n_filled_len > 0;
+    if (have) {
+        pkt.data.assign(out->p_buffer, out->p_buffer + out->n_filled_len);
+        pkt.pts      = out->pts;
+        pkt.keyframe = out->pic_type == EB_AV1_KEY_PICTURE;
+    }
+    svt_av1_enc_release_out_buffer(&out);
+    if (last) s.eos = true;
+    return have;
+}
+
+bool Av1rSvtEncoder::done() const { return impl_->eos; }
+
+std::string av1r_svt_version() {
+    const char* v = svt_av1_get_version();
+    return v ? v : "";
+}
+
+#else // !AV1R_HAVE_SVTAV1
+
+struct Av1rSvtEncoder::Impl {};
+
+Av1rSvtEncoder::Av1rSvtEncoder(const Av1rSvtConfig&) {
+    throw std::runtime_error("AV1R was built without SVT-AV1 (libSvtAv1Enc)");
+}
+Av1rSvtEncoder::~Av1rSvtEncoder() {}
+void Av1rSvtEncoder::send(const uint8_t*, int64_t) {}
+void Av1rSvtEncoder::finish() {}
+bool Av1rSvtEncoder::receive(Av1rSvtPacket&) { return false; }
+bool Av1rSvtEncoder::done() const { return true; }
+
+std::string av1r_svt_version() { return ""; }
+
+#endif // AV1R_HAVE_SVTAV1
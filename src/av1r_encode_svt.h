@@ -0,0 +1,62 @@
+// In-process SVT-AV1 encoder (libSvtAv1Enc) for av1r_options(backend = "svt").
+//
+// Fed by the same frame sources as the Vulkan path (av1r_decode.h, I420
+// layout) and written through the same IVF muxer and remux, so the CPU
+// encode needs no ffmpeg encode process. SVT-AV1 is asynchronous: with
+// lookahead, packets come out some frames after their pictures went in,
+// and the rest is drained after finish().
+//
+// Built when configure finds SvtAv1Enc (AV1R_HAVE_SVTAV1); otherwise the
+// constructor throws and av1r_svt_version() is "".
+
+#ifndef AV1R_ENCODE_SVT_H
+#define AV1R_ENCODE_SVT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Av1rSvtConfig {
+    int width     = 0;     // even
+    int height    = 0;
+    int fps       = 25;
+    int crf       = 28;    // 0..63
+    int preset    = 8;     // enc_mode 0..13
+    int threads   = 0;     // 0 = all cores
+    int lookahead = -1;    // frames, -1 = encoder default
+    int keyintMax = -1;    // frames between keyframes, -1 = encoder default
+};
+
+struct Av1rSvtPacket {
+    std::vector<uint8_t> data;
+    int64_t pts      = 0;
+    bool    keyframe = false;
+};
+
+class Av1rSvtEncoder {
+public:
+    // Throws std::runtime_error if the encoder rejects the configuration
+    // (or the package was built without SVT-AV1)
+    explicit Av1rSvtEncoder(const Av1rSvtConfig& cfg);
+    ~Av1rSvtEncoder();
+    Av1rSvtEncoder(const Av1rSvtEncoder&) = delete;
+    Av1rSvtEncoder& operator=(const Av1rSvtEncoder&) = delete;
+
+    // One I420 frame (width * height * 3/2 bytes); SVT copies it
+    void send(const uint8_t* i420, int64_t pts);
+    // End of input; receive() then waits for the remaining packets
+    void finish();
+    // Next packet; false when none is ready yet (before finish()) or all
+    // packets were delivered (after finish())
+    bool receive(Av1rSvtPacket& pkt);
+    bool done() const;
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Version of the linked libSvtAv1Enc ("" without SVT-AV1)
+std::string av1r_svt_version();
+
+#endif
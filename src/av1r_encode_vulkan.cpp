@@ -13,7 +13,14 @@
 #include <cstring>
 #include <cstdio>
 #include <limits>
+#include <chrono>
+#include <cmath>
 #include "av1r_vulkan_ctx.h"
+#include "av1r_stream_encoder.h"
+#include "av1r_analysis.h"
+#include "av1r_tiles.h"
+#include "av1r_convert.h"
+#include "av1r_trace.h"
 
 // av1r_commands.cpp
 VkCommandPool   av1r_create_command_pool(VkDevice, uint32_t);
@@ -27,7 +34,7 @@ void            av1r_reset_fence(VkDevice, VkFence);
 // av1r_memory.cpp
 Av1rBuffer av1r_buffer_create(VkPhysicalDevice, VkDevice, size_t,
                                VkBufferUsageFlags, VkMemoryPropertyFlags,
-                               VkMemoryPropertyFlags);
+                               VkMemoryPropertyFlags, const char*);
 void       av1r_buffer_destroy(VkDevice, Av1rBuffer&);
 
 // ============================================================================
@@ -85,6 +92,9 @@ struct Av1rEncoder {
     // Query pool для получения размера bitstream (строки 464-476 примера)
     VkQueryPool queryPool = VK_NULL_HANDLE;
 
+    // Учёт device memory (av1r_memstats.h), освобождается в destroyEncoder
+    Av1rMemCharge sessionMem, dpbMem, srcMem, bitstreamMem;
+
     // Command pools + fence
     VkCommandPool encodeCommandPool   = VK_NULL_HANDLE;
     VkCommandPool transferCommandPool = VK_NULL_HANDLE;
@@ -103,8 +113,33 @@ struct Av1rEncoder {
     uint32_t height = 0;
     uint32_t fps    = 0;
     uint32_t crf    = 28;
+    uint32_t preset = 8;
+    uint32_t keyintMax = 0;     // период key frames (se.keyintMax), для rate control
     uint32_t frameCount = 0;
 
+    // Последний закодированный кадр: DPB slot, order_hint, тип.
+    // Явное состояние вместо чётности frameCount — после пропущенных
+    // (static) кадров чётность больше не совпадает со слотом.
+    uint32_t lastSlot      = 0;
+    uint8_t  lastOrderHint = 0;
+    bool     lastWasKey    = false;
+
+    // Tile layout (из размера кадра, max_tiles и лимитов драйвера)
+    uint32_t       maxTiles = 0;
+    Av1rTileLayout tiles;
+
+    // Keyframe placement: текущий кадр key? + индекс последнего key frame
+    bool     keyFrame      = false;
+    uint32_t lastKeyIndex  = 0;
+
+    // Quality level (из preset) + usage hints
+    VkVideoEncodeUsageInfoKHR        usageInfo{};
+    VkVideoEncodeQualityLevelInfoKHR qualityLevelInfo{};
+    // Предпочтения драйвера для этого уровня (VkVideoEncodeAV1QualityLevelPropertiesKHR)
+    VkVideoEncodeAV1RateControlFlagsKHR preferredRcFlags = 0;
+    uint32_t preferredGopFrameCount = 0;
+    uint32_t singleRefNameMask      = 0;   // 0 = все 7 reference names
+
     // AV1 codec state (аналог m_sps/m_pps из примера)
     StdVideoAV1SequenceHeader seqHeader{};
 
@@ -128,22 +163,62 @@ struct Av1rEncoder {
     VkVideoProfileListInfoKHR videoProfileList{};
     VkVideoEncodeAV1ProfileInfoKHR av1ProfileInfo{};
 
+    // Capability registry entry (не владеем, см. av1r_vulkan_caps)
+    const Av1rVulkanCaps* caps = nullptr;
+
+    Av1rEncodeStats stats{};
+
     bool initialized = false;
 };
 
 // ============================================================================
-// Query minimum coded extent for AV1 encode (called before ffmpeg pipe)
+// Capability registry: probe the AV1 encode profile once per process.
+// min/max coded extent, DPB limits, rate control modes and the src/DPB
+// formats are shared by detect_backend(), option checks (R/caps.R) and
+// av1r_vulkan_encode_init(), so the driver is asked only once.
 // ============================================================================
-void av1r_vulkan_query_min_extent(VkInstance instance, VkPhysicalDevice physDevice,
-                                   uint32_t* out_min_w, uint32_t* out_min_h)
+static void query_video_formats(PFN_vkGetPhysicalDeviceVideoFormatPropertiesKHR pfn,
+                                VkPhysicalDevice physDevice,
+                                const VkVideoProfileListInfoKHR* profileList,
+                                VkImageUsageFlags usage,
+                                std::vector<VkFormat>& out)
 {
-    *out_min_w = 0;
-    *out_min_h = 0;
+    out.clear();
+    VkPhysicalDeviceVideoFormatInfoKHR fmtInfo{};
+    fmtInfo.sType      = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VIDEO_FORMAT_INFO_KHR;
+    fmtInfo.pNext      = profileList;
+    fmtInfo.imageUsage = usage;
+
+    uint32_t fmtCount = 0;
+    if (pfn(physDevice, &fmtInfo, &fmtCount, nullptr) != VK_SUCCESS || fmtCount == 0)
+        return;
+    std::vector<VkVideoFormatPropertiesKHR> fmtProps(fmtCount);
+    for (auto& f : fmtProps) f.sType = VK_STRUCTURE_TYPE_VIDEO_FORMAT_PROPERTIES_KHR;
+    if (pfn(physDevice, &fmtInfo, &fmtCount, fmtProps.data()) != VK_SUCCESS)
+        return;
+    for (uint32_t i = 0; i < fmtCount; i++)
+        out.push_back(fmtProps[i].format);
+}
 
-    // Load instance-level function directly (device funcs may not be loaded yet)
-    auto pfn = (PFN_vkGetPhysicalDeviceVideoCapabilitiesKHR)
+static void query_caps(VkInstance instance, VkPhysicalDevice physDevice,
+                       Av1rVulkanCaps& out)
+{
+    out = Av1rVulkanCaps{};
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physDevice, &props);
+    strncpy(out.deviceName, props.deviceName, sizeof(out.deviceName) - 1);
+    out.vendorId      = props.vendorID;
+    out.deviceId      = props.deviceID;
+    out.driverVersion = props.driverVersion;
+    out.apiVersion    = props.apiVersion;
+
+    // Load instance-level functions directly (device funcs may not be loaded yet)
+    auto pfnCaps = (PFN_vkGetPhysicalDeviceVideoCapabilitiesKHR)
         vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceVideoCapabilitiesKHR");
-    if (!pfn) return;
+    auto pfnFmts = (PFN_vkGetPhysicalDeviceVideoFormatPropertiesKHR)
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceVideoFormatPropertiesKHR");
+    if (!pfnCaps || !pfnFmts) return;
 
     VkVideoEncodeAV1ProfileInfoKHR av1Prof{};
     av1Prof.sType      = VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_PROFILE_INFO_KHR;
@@ -157,6 +232,7 @@ void av1r_vulkan_query_min_extent(VkInstance instance, VkPhysicalDevice physDevi
     profile.lumaBitDepth        = VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
     profile.chromaBitDepth      = VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
 
+    // VkVideoEncodeAV1CapabilitiesKHR must be in the chain — RADV writes to it
     VkVideoEncodeAV1CapabilitiesKHR av1Caps{};
     av1Caps.sType = VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_CAPABILITIES_KHR;
 
@@ -168,11 +244,48 @@ void av1r_vulkan_query_min_extent(VkInstance instance, VkPhysicalDevice physDevi
     caps.sType = VK_STRUCTURE_TYPE_VIDEO_CAPABILITIES_KHR;
     caps.pNext = &encodeCaps;
 
-    VkResult res = pfn(physDevice, &profile, &caps);
-    if (res != VK_SUCCESS) return;
+    if (pfnCaps(physDevice, &profile, &caps) != VK_SUCCESS) return;
+
+    out.minWidth                   = caps.minCodedExtent.width;
+    out.minHeight                  = caps.minCodedExtent.height;
+    out.maxWidth                   = caps.maxCodedExtent.width;
+    out.maxHeight                  = caps.maxCodedExtent.height;
+    out.maxDpbSlots                = caps.maxDpbSlots;
+    out.maxActiveReferencePictures = caps.maxActiveReferencePictures;
+    out.maxQualityLevels           = encodeCaps.maxQualityLevels;
+    out.rateControlModes           = encodeCaps.rateControlModes;
+    out.maxTileCols                = av1Caps.maxTiles.width;
+    out.maxTileRows                = av1Caps.maxTiles.height;
+    out.minTileWidth               = av1Caps.minTileSize.width;
+    out.minTileHeight              = av1Caps.minTileSize.height;
+    out.maxTileWidth               = av1Caps.maxTileSize.width;
+    out.maxTileHeight              = av1Caps.maxTileSize.height;
+
+    VkVideoProfileListInfoKHR profileList{};
+    profileList.sType        = VK_STRUCTURE_TYPE_VIDEO_PROFILE_LIST_INFO_KHR;
+    profileList.profileCount = 1;
+    profileList.pProfiles    = &profile;
+
+    query_video_formats(pfnFmts, physDevice, &profileList,
+                        VK_IMAGE_USAGE_VIDEO_ENCODE_SRC_BIT_KHR, out.srcFormats);
+    query_video_formats(pfnFmts, physDevice, &profileList,
+                        VK_IMAGE_USAGE_VIDEO_ENCODE_DPB_BIT_KHR, out.dpbFormats);
+
+    out.valid = true;
+}
 
-    *out_min_w = caps.minCodedExtent.width;
-    *out_min_h = caps.minCodedExtent.height;
+const Av1rVulkanCaps& av1r_vulkan_caps(VkInstance instance, VkPhysicalDevice physDevice,
+                                        bool refresh)
+{
+    static Av1rVulkanCaps cached{};
+    static bool probed = false;
+    static bool probedStub = false;
+    if (refresh || !probed || probedStub != av1r_vk_stub_active()) {
+        query_caps(instance, physDevice, cached);
+        probed = true;
+        probedStub = av1r_vk_stub_active();
+    }
+    return cached;
 }
 
 // ============================================================================
@@ -180,10 +293,96 @@ void av1r_vulkan_query_min_extent(VkInstance instance, VkPhysicalDevice physDevi
 // Адаптировано из VideoEncoder::createVideoSession() строки 139-250
 // H.264 profile/capabilities → AV1 profile/capabilities
 // ============================================================================
+// ============================================================================
+// Usage hints + quality level
+// preset 0..13 (0 = slowest/best, как у SVT-AV1) линейно отображается на
+// quality levels драйвера maxQualityLevels-1..0: в Vulkan больший level =
+// выше качество (и медленнее), поэтому preset 0 → старший уровень.
+// ============================================================================
+static void initUsageInfo(Av1rEncoder& enc)
+{
+    enc.usageInfo.sType             = VK_STRUCTURE_TYPE_VIDEO_ENCODE_USAGE_INFO_KHR;
+    enc.usageInfo.videoUsageHints   = VK_VIDEO_ENCODE_USAGE_TRANSCODING_BIT_KHR |
+                                      VK_VIDEO_ENCODE_USAGE_RECORDING_BIT_KHR;
+    enc.usageInfo.videoContentHints = VK_VIDEO_ENCODE_CONTENT_CAMERA_BIT_KHR;
+    if (enc.preset <= 3)
+        enc.usageInfo.tuningMode = VK_VIDEO_ENCODE_TUNING_MODE_HIGH_QUALITY_KHR;
+    else if (enc.preset >= 11)
+        enc.usageInfo.tuningMode = VK_VIDEO_ENCODE_TUNING_MODE_LOW_LATENCY_KHR;
+    else
+        enc.usageInfo.tuningMode = VK_VIDEO_ENCODE_TUNING_MODE_DEFAULT_KHR;
+}
+
+static void selectQualityLevel(Av1rEncoder& enc)
+{
+    const uint32_t maxLevels = enc.caps->maxQualityLevels;
+    uint32_t level = 0;
+    if (maxLevels > 1) {
+        const uint32_t preset = enc.preset > 13 ? 13 : enc.preset;
+        level = ((13 - preset) * (maxLevels - 1) + 6) / 13;
+        if (level > maxLevels - 1) level = maxLevels - 1;
+    }
+
+    // Убедиться, что драйвер принимает этот уровень для нашего профиля, и
+    // взять его предпочтительные настройки rate control / GOP / references
+    VkPhysicalDeviceVideoEncodeQualityLevelInfoKHR qlInfo{};
+    qlInfo.sType         = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VIDEO_ENCODE_QUALITY_LEVEL_INFO_KHR;
+    qlInfo.pVideoProfile = &enc.videoProfile;
+    qlInfo.qualityLevel  = level;
+
+    VkVideoEncodeAV1QualityLevelPropertiesKHR av1Props{};
+    av1Props.sType = VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_QUALITY_LEVEL_PROPERTIES_KHR;
+    VkVideoEncodeQualityLevelPropertiesKHR qlProps{};
+    qlProps.sType = VK_STRUCTURE_TYPE_VIDEO_ENCODE_QUALITY_LEVEL_PROPERTIES_KHR;
+    qlProps.pNext = &av1Props;
+
+    auto pfn = av1r_vk_video_funcs().GetPhysDevEncodeQualityLevelProperties;
+    if (maxLevels == 0 || !pfn || pfn(enc.physDevice, &qlInfo, &qlProps) != VK_SUCCESS) {
+        level = 0;  // driver default
+    } else {
+        // CQP остаётся, если он есть: crf задаётся через constantQIndex.
+        // Иначе — режим, который драйвер предпочитает для этого уровня.
+        if (enc.chosenRateControlMode != VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR &&
+            (enc.caps->rateControlModes & qlProps.preferredRateControlMode))
+            enc.chosenRateControlMode = qlProps.preferredRateControlMode;
+        enc.preferredRcFlags       = av1Props.preferredRateControlFlags;
+        enc.preferredGopFrameCount = av1Props.preferredGopFrameCount;
+        enc.singleRefNameMask      = av1Props.preferredSingleReferenceNameMask;
+    }
+
+    enc.qualityLevelInfo.sType        = VK_STRUCTURE_TYPE_VIDEO_ENCODE_QUALITY_LEVEL_INFO_KHR;
+    enc.qualityLevelInfo.qualityLevel = level;
+
+    enc.stats.qualityLevel     = level;
+    enc.stats.maxQualityLevels = maxLevels;
+}
+
+// ============================================================================
+// Tile layout: несколько тайлов — параллельный decode в viewers/analysis tools
+// ============================================================================
+static void selectTileLayout(Av1rEncoder& enc)
+{
+    const Av1rVulkanCaps& caps = *enc.caps;
+    Av1rTileLimits limits;
+    limits.maxCols   = caps.maxTileCols;
+    limits.maxRows   = caps.maxTileRows;
+    limits.minWidth  = caps.minTileWidth;
+    limits.minHeight = caps.minTileHeight;
+    limits.maxWidth  = caps.maxTileWidth;
+    limits.maxHeight = caps.maxTileHeight;
+    enc.tiles = av1r_tile_layout(enc.width, enc.height, enc.maxTiles, limits);
+
+    enc.stats.tileCols    = enc.tiles.cols;
+    enc.stats.tileRows    = enc.tiles.rows;
+    enc.stats.tileUniform = enc.tiles.uniform;
+}
+
 static void createVideoSession(Av1rEncoder& enc, int crf)
 {
-    // AV1 profile (аналог строки 140-148 примера)
+    // AV1 profile (аналог строки 140-148 примера) + usage hints
+    initUsageInfo(enc);
     enc.av1ProfileInfo.sType      = VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_PROFILE_INFO_KHR;
+    enc.av1ProfileInfo.pNext      = &enc.usageInfo;
     enc.av1ProfileInfo.stdProfile = STD_VIDEO_AV1_PROFILE_MAIN;
 
     enc.videoProfile.sType               = VK_STRUCTURE_TYPE_VIDEO_PROFILE_INFO_KHR;
@@ -197,64 +396,41 @@ static void createVideoSession(Av1rEncoder& enc, int crf)
     enc.videoProfileList.profileCount = 1;
     enc.videoProfileList.pProfiles    = &enc.videoProfile;
 
-    // Запрос capabilities (строки 154-174 примера, AV1 структуры)
-    VkVideoEncodeAV1CapabilitiesKHR av1Caps{};
-    av1Caps.sType = VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_CAPABILITIES_KHR;
-
-    VkVideoEncodeCapabilitiesKHR encodeCaps{};
-    encodeCaps.sType = VK_STRUCTURE_TYPE_VIDEO_ENCODE_CAPABILITIES_KHR;
-    encodeCaps.pNext = &av1Caps;
-
-    VkVideoCapabilitiesKHR caps{};
-    caps.sType = VK_STRUCTURE_TYPE_VIDEO_CAPABILITIES_KHR;
-    caps.pNext = &encodeCaps;
-
-    VkResult res = av1r_vk_video_funcs().GetPhysDevVideoCapabilities(enc.physDevice,
-                                                           &enc.videoProfile, &caps);
-    if (res != VK_SUCCESS)
-        throw std::runtime_error("vkGetPhysicalDeviceVideoCapabilitiesKHR failed: " +
-                                 std::to_string(res));
+    // Capabilities и форматы берём из реестра (строки 154-235 примера)
+    const Av1rVulkanCaps& caps = *enc.caps;
+    if (!caps.valid)
+        throw std::runtime_error("vkGetPhysicalDeviceVideoCapabilitiesKHR failed for AV1 encode profile");
 
     // Use DISABLED mode (CQP) — driver controls quality via constantQIndex per frame
-    if (encodeCaps.rateControlModes & VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR)
+    if (caps.rateControlModes & VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR)
         enc.chosenRateControlMode = VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR;
     else
         enc.chosenRateControlMode = VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DEFAULT_KHR;
 
-    // Определение поддерживаемых форматов (строки 190-235 примера)
-    VkPhysicalDeviceVideoFormatInfoKHR fmtInfo{};
-    fmtInfo.sType       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VIDEO_FORMAT_INFO_KHR;
-    fmtInfo.pNext       = &enc.videoProfileList;
-    fmtInfo.imageUsage  = VK_IMAGE_USAGE_VIDEO_ENCODE_SRC_BIT_KHR;
-
-    uint32_t fmtCount = 0;
-    av1r_vk_video_funcs().GetPhysDevVideoFormatProperties(enc.physDevice, &fmtInfo, &fmtCount, nullptr);
-    std::vector<VkVideoFormatPropertiesKHR> fmtProps(fmtCount);
-    for (auto& f : fmtProps) f.sType = VK_STRUCTURE_TYPE_VIDEO_FORMAT_PROPERTIES_KHR;
-    av1r_vk_video_funcs().GetPhysDevVideoFormatProperties(enc.physDevice, &fmtInfo,
-                                                &fmtCount, fmtProps.data());
-
     enc.srcFormat = VK_FORMAT_UNDEFINED;
-    for (const auto& f : fmtProps) {
-        if (f.format == VK_FORMAT_G8_B8R8_2PLANE_420_UNORM ||
-            f.format == VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM) {
-            enc.srcFormat = f.format;
+    for (VkFormat f : caps.srcFormats) {
+        if (f == VK_FORMAT_G8_B8R8_2PLANE_420_UNORM ||
+            f == VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM) {
+            enc.srcFormat = f;
             break;
         }
     }
     if (enc.srcFormat == VK_FORMAT_UNDEFINED)
         throw std::runtime_error("No supported NV12/YUV420 format for AV1 encode src");
 
-    // DPB формат (строки 223-235 примера)
-    fmtInfo.imageUsage = VK_IMAGE_USAGE_VIDEO_ENCODE_DPB_BIT_KHR;
-    av1r_vk_video_funcs().GetPhysDevVideoFormatProperties(enc.physDevice, &fmtInfo, &fmtCount, nullptr);
-    std::vector<VkVideoFormatPropertiesKHR> dpbFmtProps(fmtCount);
-    for (auto& f : dpbFmtProps) f.sType = VK_STRUCTURE_TYPE_VIDEO_FORMAT_PROPERTIES_KHR;
-    av1r_vk_video_funcs().GetPhysDevVideoFormatProperties(enc.physDevice, &fmtInfo,
-                                                &fmtCount, dpbFmtProps.data());
-    if (dpbFmtProps.empty())
+    if (caps.dpbFormats.empty())
         throw std::runtime_error("No supported DPB format for AV1 encode");
-    enc.dpbFormat = dpbFmtProps[0].format;
+    enc.dpbFormat = caps.dpbFormats[0];
+
+    if (enc.width > caps.maxWidth || enc.height > caps.maxHeight)
+        throw std::runtime_error("Frame " + std::to_string(enc.width) + "x" +
+                                 std::to_string(enc.height) +
+                                 " exceeds maximum coded extent " +
+                                 std::to_string(caps.maxWidth) + "x" +
+                                 std::to_string(caps.maxHeight));
+
+    selectQualityLevel(enc);
+    selectTileLayout(enc);
 
     // AV1 sequence header (аналог SPS/PPS, строки 237-249 примера)
     static const VkExtensionProperties av1StdExt = {
@@ -273,7 +449,7 @@ static void createVideoSession(Av1rEncoder& enc, int crf)
     sessionCI.referencePictureFormat      = enc.dpbFormat;
     sessionCI.pStdHeaderVersion           = &av1StdExt;
 
-    res = av1r_vk_video_funcs().CreateVideoSession(enc.device, &sessionCI, nullptr, &enc.videoSession);
+    VkResult res = av1r_vk_video_funcs().CreateVideoSession(enc.device, &sessionCI, nullptr, &enc.videoSession);
     if (res != VK_SUCCESS)
         throw std::runtime_error("vkCreateVideoSessionKHR failed: " + std::to_string(res));
 }
@@ -293,6 +469,7 @@ static void allocateVideoSessionMemory(Av1rEncoder& enc)
 
     enc.sessionMemory.resize(count, VK_NULL_HANDLE);
     std::vector<VkBindVideoSessionMemoryInfoKHR> binds(count);
+    VkDeviceSize total = 0;
 
     for (uint32_t i = 0; i < count; i++) {
         const auto& mr = reqs[i].memoryRequirements;
@@ -312,7 +489,9 @@ static void allocateVideoSessionMemory(Av1rEncoder& enc)
         binds[i].memory           = enc.sessionMemory[i];
         binds[i].memoryOffset     = 0;
         binds[i].memorySize       = mr.size;
+        total += mr.size;
     }
+    enc.sessionMem.set(AV1R_MEM_DEVICE, "session", total);
     av1r_vk_video_funcs().BindVideoSessionMemory(enc.device, enc.videoSession, count, binds.data());
 }
 
@@ -347,8 +526,10 @@ static void createVideoSessionParameters(Av1rEncoder& enc)
     colorConfig.chroma_sample_position   = STD_VIDEO_AV1_CHROMA_SAMPLE_POSITION_UNKNOWN;
     enc.seqHeader.pColorConfig = &colorConfig;
 
+    // Session parameters создаются под выбранный quality level
     VkVideoEncodeAV1SessionParametersCreateInfoKHR av1ParamsCI{};
     av1ParamsCI.sType             = VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_SESSION_PARAMETERS_CREATE_INFO_KHR;
+    av1ParamsCI.pNext             = &enc.qualityLevelInfo;
     av1ParamsCI.pStdSequenceHeader = &enc.seqHeader;
 
     VkVideoSessionParametersCreateInfoKHR paramsCI{};
@@ -399,14 +580,15 @@ static void getSequenceHeader(Av1rEncoder& enc)
 // ============================================================================
 // Выделение VkImage с памятью (DPB и src образы)
 // ============================================================================
-static void createImage(VkPhysicalDevice phys, VkDevice device,
-                        uint32_t width, uint32_t height,
-                        VkFormat format,
-                        VkImageUsageFlags usage,
-                        const void* pNext,
-                        VkImage& outImage, VkDeviceMemory& outMemory,
-                        const uint32_t* queueFamilies = nullptr,
-                        uint32_t queueFamilyCount = 0)
+// Returns the size of the memory allocated for the image
+static VkDeviceSize createImage(VkPhysicalDevice phys, VkDevice device,
+                                uint32_t width, uint32_t height,
+                                VkFormat format,
+                                VkImageUsageFlags usage,
+                                const void* pNext,
+                                VkImage& outImage, VkDeviceMemory& outMemory,
+                                const uint32_t* queueFamilies = nullptr,
+                                uint32_t queueFamilyCount = 0)
 {
     VkImageCreateInfo ici{};
     ici.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -450,6 +632,7 @@ static void createImage(VkPhysicalDevice phys, VkDevice device,
     ai.memoryTypeIndex = mt;
     vkAllocateMemory(device, &ai, nullptr, &outMemory);
     vkBindImageMemory(device, outImage, outMemory, 0);
+    return mr.size;
 }
 
 // ============================================================================
@@ -460,8 +643,9 @@ static void createImage(VkPhysicalDevice phys, VkDevice device,
 static void allocateImages(Av1rEncoder& enc)
 {
     // DPB образы (строки 360-396 примера)
+    VkDeviceSize dpbBytes = 0;
     for (uint32_t i = 0; i < Av1rEncoder::DPB_COUNT; i++) {
-        createImage(enc.physDevice, enc.device,
+        dpbBytes += createImage(enc.physDevice, enc.device,
                     enc.width, enc.height,
                     enc.dpbFormat,
                     VK_IMAGE_USAGE_VIDEO_ENCODE_DPB_BIT_KHR,
@@ -476,19 +660,21 @@ static void allocateImages(Av1rEncoder& enc)
         vci.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
         vkCreateImageView(enc.device, &vci, nullptr, &enc.dpbImageViews[i]);
     }
+    enc.dpbMem.set(AV1R_MEM_DEVICE, "dpb images", dpbBytes);
 
     // Src образ NV12 (строки 399-461 примера, без compute шейдера)
     // В AV1R данные NV12 приходят от ffmpeg, загружаем напрямую через staging
     // Concurrent sharing between transfer queue (upload) and encode queue (read)
     uint32_t srcQueueFamilies[2] = { enc.transferQFam, enc.encodeQFam };
     uint32_t srcQfCount = (enc.transferQFam != enc.encodeQFam) ? 2u : 1u;
-    createImage(enc.physDevice, enc.device,
+    const VkDeviceSize srcBytes = createImage(enc.physDevice, enc.device,
                 enc.width, enc.height,
                 enc.srcFormat,
                 VK_IMAGE_USAGE_VIDEO_ENCODE_SRC_BIT_KHR | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
                 &enc.videoProfileList,
                 enc.srcImage, enc.srcMemory,
                 srcQueueFamilies, srcQfCount);
+    enc.srcMem.set(AV1R_MEM_DEVICE, "source image", srcBytes);
 
     VkImageViewCreateInfo vci{};
     vci.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -524,6 +710,7 @@ static void allocateBitstreamBuffer(Av1rEncoder& enc)
     ai.memoryTypeIndex = mt;
     vkAllocateMemory(enc.device, &ai, nullptr, &enc.bitstreamMemory);
     vkBindBufferMemory(enc.device, enc.bitstreamBuf, enc.bitstreamMemory, 0);
+    enc.bitstreamMem.set(AV1R_MEM_DEVICE, "bitstream buffer", mr.size);
     vkMapMemory(enc.device, enc.bitstreamMemory, 0, VK_WHOLE_SIZE, 0, &enc.bitstreamPtr);
 }
 
@@ -571,9 +758,15 @@ static void initRateControl(Av1rEncoder& enc, VkCommandBuffer cmd)
 
     // AV1 rate control info (аналог VkVideoEncodeH264RateControlInfoKHR)
     enc.av1RateControlInfo.sType          = VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_RATE_CONTROL_INFO_KHR;
-    enc.av1RateControlInfo.flags          = VK_VIDEO_ENCODE_AV1_RATE_CONTROL_REGULAR_GOP_BIT_KHR;
-    enc.av1RateControlInfo.gopFrameCount  = enc.fps * 10;
-    enc.av1RateControlInfo.keyFramePeriod = enc.fps * 10;
+    // Key frames ставит decideKeyFrame (keyint); GOP внутри периода — как
+    // предпочитает драйвер для выбранного quality level
+    const uint32_t keyPeriod = enc.keyintMax > 0 ? enc.keyintMax : enc.fps * 10;
+    enc.av1RateControlInfo.flags          = VK_VIDEO_ENCODE_AV1_RATE_CONTROL_REGULAR_GOP_BIT_KHR |
+                                            enc.preferredRcFlags;
+    enc.av1RateControlInfo.gopFrameCount  =
+        enc.preferredGopFrameCount > 0 && enc.preferredGopFrameCount < keyPeriod
+            ? enc.preferredGopFrameCount : keyPeriod;
+    enc.av1RateControlInfo.keyFramePeriod = keyPeriod;
     enc.av1RateControlInfo.temporalLayerCount = 1;
 
     enc.rateControlInfo.sType               = VK_STRUCTURE_TYPE_VIDEO_ENCODE_RATE_CONTROL_INFO_KHR;
@@ -593,11 +786,16 @@ static void initRateControl(Av1rEncoder& enc, VkCommandBuffer cmd)
         enc.rateControlInfo.layerCount = 0;
     }
 
+    // Quality level must match the one the session parameters were created with
+    VkVideoEncodeQualityLevelInfoKHR qualityLevelInfo = enc.qualityLevelInfo;
+    qualityLevelInfo.pNext = &enc.rateControlInfo;
+
     VkVideoCodingControlInfoKHR controlInfo{};
     controlInfo.sType = VK_STRUCTURE_TYPE_VIDEO_CODING_CONTROL_INFO_KHR;
-    controlInfo.pNext = &enc.rateControlInfo;
+    controlInfo.pNext = &qualityLevelInfo;
     controlInfo.flags = VK_VIDEO_CODING_CONTROL_RESET_BIT_KHR |
-                        VK_VIDEO_CODING_CONTROL_ENCODE_RATE_CONTROL_BIT_KHR;
+                        VK_VIDEO_CODING_CONTROL_ENCODE_RATE_CONTROL_BIT_KHR |
+                        VK_VIDEO_CODING_CONTROL_ENCODE_QUALITY_LEVEL_BIT_KHR;
 
     VkVideoEndCodingInfoKHR endInfo{};
     endInfo.sType = VK_STRUCTURE_TYPE_VIDEO_END_CODING_INFO_KHR;
@@ -633,17 +831,13 @@ static void transitionDpbImagesInitial(Av1rEncoder& enc, VkCommandBuffer cmd)
 }
 
 // ============================================================================
-// uploadNV12Frame: CPU NV12 → GPU src image через staging buffer
-// Заменяет RGB→YCbCr compute shader из примера (у нас данные уже NV12 от ffmpeg)
+// uploadNV12Frame: NV12 buffer (staging или выход compute shader) → GPU src image
+// Буфер уже заполнен: memcpy/CPU-конвертация в staging либо Av1rGpuConverter
 // ============================================================================
 static void uploadNV12Frame(Av1rEncoder& enc,
                              VkCommandBuffer cmd,
-                             const uint8_t* nv12,
-                             VkBuffer stagingBuf, void* stagingPtr)
+                             VkBuffer nv12Buf)
 {
-    size_t frameBytes = enc.width * enc.height * 3 / 2;
-    memcpy(stagingPtr, nv12, frameBytes);
-
     // Transition src image UNDEFINED → TRANSFER_DST
     VkImageMemoryBarrier2 toTransfer{};
     toTransfer.sType         = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
@@ -666,7 +860,7 @@ static void uploadNV12Frame(Av1rEncoder& enc,
     yRegion.bufferRowLength   = enc.width;
     yRegion.imageSubresource  = {VK_IMAGE_ASPECT_PLANE_0_BIT, 0, 0, 1};
     yRegion.imageExtent       = {enc.width, enc.height, 1};
-    vkCmdCopyBufferToImage(cmd, stagingBuf, enc.srcImage,
+    vkCmdCopyBufferToImage(cmd, nv12Buf, enc.srcImage,
                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &yRegion);
 
     // Copy UV plane
@@ -675,7 +869,7 @@ static void uploadNV12Frame(Av1rEncoder& enc,
     uvRegion.bufferRowLength  = enc.width / 2;
     uvRegion.imageSubresource = {VK_IMAGE_ASPECT_PLANE_1_BIT, 0, 0, 1};
     uvRegion.imageExtent      = {enc.width / 2, enc.height / 2, 1};
-    vkCmdCopyBufferToImage(cmd, stagingBuf, enc.srcImage,
+    vkCmdCopyBufferToImage(cmd, nv12Buf, enc.srcImage,
                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &uvRegion);
 
     // Transition src image TRANSFER_DST → VIDEO_ENCODE_SRC (строки 786-806 примера)
@@ -701,10 +895,8 @@ static void uploadNV12Frame(Av1rEncoder& enc,
 // ============================================================================
 static void encodeOneFrame(Av1rEncoder& enc, VkCommandBuffer cmd)
 {
-    // Keyframe every 10 seconds (fps-dependent)
-    const uint32_t GOP_LENGTH   = enc.fps * 10;
-    const uint32_t gopIdx       = enc.frameCount % GOP_LENGTH;
-    const bool     isKeyFrame   = (gopIdx == 0);
+    // Решение key/inter принимается заранее (decideKeyFrame)
+    const bool     isKeyFrame   = enc.keyFrame;
     const uint32_t querySlotId  = 0;
 
     vkCmdResetQueryPool(cmd, enc.queryPool, querySlotId, 1);
@@ -717,8 +909,8 @@ static void encodeOneFrame(Av1rEncoder& enc, VkCommandBuffer cmd)
         curSlot = 0;
         refSlot = 0;
     } else {
-        curSlot = enc.frameCount & 1u;     // 0, 1, 0, 1, ...
-        refSlot = curSlot ^ 1u;            // 1, 0, 1, 0, ...
+        refSlot = enc.lastSlot;            // последний закодированный кадр
+        curSlot = refSlot ^ 1u;            // другой image
     }
 
     // Picture resources для DPB images
@@ -751,14 +943,13 @@ static void encodeOneFrame(Av1rEncoder& enc, VkCommandBuffer cmd)
     setupSlot.slotIndex        = static_cast<int32_t>(curSlot);
     setupSlot.pPictureResource = &curPicRes;
 
-    // Reference info — предыдущий кадр из DPB refSlot (inter only)
-    // frame_type must match what was actually stored: frame 0 = KEY, rest = INTER
-    const uint32_t prevGopIdx = (enc.frameCount - 1) % (enc.fps * 10);
+    // Reference info — последний закодированный кадр из DPB refSlot (inter only)
+    // frame_type must match what was actually stored
     StdVideoEncodeAV1ReferenceInfo stdRefInfo{};
     memset(&stdRefInfo, 0, sizeof(stdRefInfo));
-    stdRefInfo.frame_type = (prevGopIdx == 0) ? STD_VIDEO_AV1_FRAME_TYPE_KEY
-                                               : STD_VIDEO_AV1_FRAME_TYPE_INTER;
-    stdRefInfo.OrderHint  = static_cast<uint8_t>((enc.frameCount - 1) & 0xFF);
+    stdRefInfo.frame_type = enc.lastWasKey ? STD_VIDEO_AV1_FRAME_TYPE_KEY
+                                           : STD_VIDEO_AV1_FRAME_TYPE_INTER;
+    stdRefInfo.OrderHint  = enc.lastOrderHint;
 
     VkVideoEncodeAV1DpbSlotInfoKHR refDpbInfo{};
     refDpbInfo.sType             = VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_DPB_SLOT_INFO_KHR;
@@ -818,13 +1009,20 @@ static void encodeOneFrame(Av1rEncoder& enc, VkCommandBuffer cmd)
 
     // --- Sub-structures required by StdVideoEncodeAV1PictureInfo ---
 
-    // Tile info: single tile covering the whole frame
+    // Tile info: layout выбран в selectTileLayout
     StdVideoAV1TileInfo tileInfo{};
     memset(&tileInfo, 0, sizeof(tileInfo));
-    tileInfo.flags.uniform_tile_spacing_flag = 1;
-    tileInfo.TileCols = 1;
-    tileInfo.TileRows = 1;
-    // pMiColStarts/pMiRowStarts not needed with uniform spacing and 1 tile
+    tileInfo.flags.uniform_tile_spacing_flag = enc.tiles.uniform ? 1 : 0;
+    tileInfo.TileCols = static_cast<uint8_t>(enc.tiles.cols);
+    tileInfo.TileRows = static_cast<uint8_t>(enc.tiles.rows);
+    tileInfo.context_update_tile_id  = 0;
+    tileInfo.tile_size_bytes_minus_1 = 3;
+    if (!enc.tiles.uniform) {
+        tileInfo.pMiColStarts       = enc.tiles.miColStarts.data();
+        tileInfo.pMiRowStarts       = enc.tiles.miRowStarts.data();
+        tileInfo.pWidthInSbsMinus1  = enc.tiles.widthInSbsMinus1.data();
+        tileInfo.pHeightInSbsMinus1 = enc.tiles.heightInSbsMinus1.data();
+    }
 
     // Quantization
     StdVideoAV1Quantization quantization{};
@@ -881,9 +1079,9 @@ static void encodeOneFrame(Av1rEncoder& enc, VkCommandBuffer cmd)
     // ref_order_hint: order_hint stored in each of the 8 virtual slots
     // After keyframe at slot curSlot: that slot has current order_hint
     // After inter at slot curSlot: that slot has current order_hint
-    // The refSlot has the previous frame's order_hint
+    // The refSlot has the last encoded frame's order_hint
     if (!isKeyFrame) {
-        stdPicInfo.ref_order_hint[refSlot] = static_cast<uint8_t>((enc.frameCount - 1) & 0xFF);
+        stdPicInfo.ref_order_hint[refSlot] = enc.lastOrderHint;
         stdPicInfo.ref_order_hint[curSlot] = 0;  // not yet written
     }
 
@@ -909,9 +1107,11 @@ static void encodeOneFrame(Av1rEncoder& enc, VkCommandBuffer cmd)
     av1PicInfo.constantQIndex     = qIndex;
     av1PicInfo.pStdPictureInfo    = &stdPicInfo;
 
-    // Reference name slot indices: для inter все 7 ref names → refSlot
+    // Reference name slot indices: для inter ref names → refSlot; только те,
+    // что драйвер предпочитает для single reference (все 7, если маски нет)
     for (uint32_t r = 0; r < VK_MAX_VIDEO_AV1_REFERENCES_PER_FRAME_KHR; r++) {
-        av1PicInfo.referenceNameSlotIndices[r] = isKeyFrame
+        const bool use = enc.singleRefNameMask == 0 || (enc.singleRefNameMask >> r) & 1u;
+        av1PicInfo.referenceNameSlotIndices[r] = isKeyFrame || !use
             ? -1
             : static_cast<int32_t>(refSlot);
     }
@@ -945,6 +1145,28 @@ static void encodeOneFrame(Av1rEncoder& enc, VkCommandBuffer cmd)
     VkVideoEndCodingInfoKHR endInfo{};
     endInfo.sType = VK_STRUCTURE_TYPE_VIDEO_END_CODING_INFO_KHR;
     av1r_vk_video_funcs().CmdEndVideoCoding(cmd, &endInfo);
+
+    enc.lastSlot      = curSlot;
+    enc.lastOrderHint = static_cast<uint8_t>(enc.frameCount & 0xFF);
+    enc.lastWasKey    = isKeyFrame;
+}
+
+// ============================================================================
+// Static frame: повтор последнего закодированного кадра без encode.
+// Frame header OBU с show_existing_frame = 1 (AV1 spec 5.9.1):
+//   obu_header: type = OBU_FRAME_HEADER (3), has_size_field = 1  → 0x1A
+//   obu_size = 1
+//   show_existing_frame(1) = 1, frame_to_show_map_idx(3), trailing bits 1000
+// Без decoder_model_info и frame_id_numbers (см. seqHeader) других полей нет.
+// Показывать можно только showable кадр, т.е. не key frame.
+// ============================================================================
+static void showExistingFrame(const Av1rEncoder& enc, std::vector<uint8_t>& out)
+{
+    const uint8_t obu[3] = {
+        0x1A, 0x01,
+        static_cast<uint8_t>(0x80 | ((enc.lastSlot & 0x7u) << 4) | 0x08)
+    };
+    out.insert(out.end(), obu, obu + 3);
 }
 
 // ============================================================================
@@ -975,6 +1197,14 @@ static size_t getOutputPacket(Av1rEncoder& enc, std::vector<uint8_t>& out)
 // ============================================================================
 // Cleanup
 // ============================================================================
+static void releaseMemCharges(Av1rEncoder& enc)
+{
+    enc.sessionMem.release();
+    enc.dpbMem.release();
+    enc.srcMem.release();
+    enc.bitstreamMem.release();
+}
+
 static void destroyEncoder(Av1rEncoder& enc)
 {
     if (enc.bitstreamPtr)
@@ -1003,6 +1233,7 @@ static void destroyEncoder(Av1rEncoder& enc)
         av1r_vk_video_funcs().DestroyVideoSession(enc.device, enc.videoSession, nullptr);
     for (auto& m : enc.sessionMemory)
         vkFreeMemory(enc.device, m, nullptr);
+    releaseMemCharges(enc);
 
     if (enc.interQueueSemaphore != VK_NULL_HANDLE)
         vkDestroySemaphore(enc.device, enc.interQueueSemaphore, nullptr);
@@ -1023,16 +1254,155 @@ static void destroyEncoder(Av1rEncoder& enc)
 struct Av1rStreamEncoder {
     Av1rEncoder enc{};
     Av1rBuffer  staging{};
-    size_t      frameBytes = 0;
+    size_t      frameBytes = 0;     // входной кадр (srcFmt), не NV12
     bool        ready = false;
+
+    // Входной формат: не-NV12 конвертируется compute shader'ом на transfer
+    // queue, либо на CPU прямо в staging (нет COMPUTE / shader не собран)
+    Av1rPixFmt       srcFmt = AV1R_PIX_NV12;
+    uint32_t         winLo = 0, winHi = 65535;
+    Av1rGpuConverter conv;
+
+    // Static frame detection (static_threshold < 0 — выключено)
+    double               staticThreshold = -1.0;
+    std::vector<uint8_t> lastEncoded;   // NV12 последнего закодированного кадра
+    uint32_t             skipRun = 0;
+
+    // Static / scene-cut анализ идёт по 8-bit NV12 (порог в единицах NV12
+    // sample): gray16 и rgb24 конвертируются сюда на CPU, NV12 и I420 —
+    // как есть (те же samples, luma первой плоскостью)
+    std::vector<uint8_t> analysis;
+    size_t               analysisBytes = 0;
+
+    // Keyframe placement: max/min GOP (кадры) + scene-cut detector
+    uint32_t          keyintMax = 0;
+    uint32_t          keyintMin = 0;
+    double            sceneCut  = 0.0;
+    Av1rSceneDetector scene;
+
+    // GPU timestamps (gpuTiming): TS_* слоты, transfer и encode cmd buffers
+    bool        gpuTiming  = false;
+    VkQueryPool tsPool     = VK_NULL_HANDLE;
+    uint64_t    tsMaskXfer = 0;   // timestampValidBits каждой queue family
+    uint64_t    tsMaskEnc  = 0;
+
+    // Host copy of the last encoded frame (static detection), analysis frame
+    Av1rMemCharge lastEncodedMem, analysisMem;
+
+    // Учёт памяти не должен пережить encoder, даже если init бросил исключение
+    ~Av1rStreamEncoder();
 };
 
+// Timestamp slots. Timestamps are compared only within one queue.
+enum : uint32_t {
+    TS_XFER_BEGIN = 0, TS_XFER_CONVERTED, TS_XFER_END,   // transfer queue
+    TS_ENC_BEGIN, TS_ENC_END,                            // encode queue
+    TS_COUNT
+};
+
+// Длинные серии show_existing_frame ограничены: order_hint 8 бит, и
+// расстояние до reference должно оставаться < 128 (get_relative_dist)
+static const uint32_t MAX_STATIC_RUN = 64;
+
+// ============================================================================
+// Keyframe placement
+// Key frame: первый кадр, GOP достиг keyintMax, или scene cut (резкая смена
+// thumbnail luma относительно предыдущего входного кадра) не раньше keyintMin.
+// Scene detector видит каждый входной кадр, включая static/skipped.
+// ============================================================================
+static bool decideKeyFrame(Av1rStreamEncoder& se, const uint8_t* frame)
+{
+    Av1rEncoder& enc = se.enc;
+    bool cut = false;
+    if (se.sceneCut > 0) {
+        se.scene.push(frame);   // luma плоскость NV12 / I420 кадра анализа
+        cut = se.scene.is_cut(se.sceneCut);
+    }
+    if (enc.stats.keyframes.empty()) return true;
+
+    const uint32_t sinceKey = enc.frameCount - enc.lastKeyIndex;
+    if (sinceKey >= se.keyintMax) return true;
+    if (cut && sinceKey >= se.keyintMin) {
+        enc.stats.sceneCuts++;
+        return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// GPU timestamps: пул на TS_COUNT запросов; очередь без timestampValidBits
+// просто не пишет свои слоты (NaN в R), encode при этом не ломается
+// ============================================================================
+static void createTimestampPool(Av1rStreamEncoder& se)
+{
+    Av1rEncoder& enc = se.enc;
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(enc.physDevice, &count, nullptr);
+    std::vector<VkQueueFamilyProperties> props(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(enc.physDevice, &count, props.data());
+    auto validMask = [&](uint32_t fam) -> uint64_t {
+        if (fam >= count) return 0;
+        const uint32_t bits = props[fam].timestampValidBits;
+        return bits == 0 ? 0 : bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    };
+    se.tsMaskXfer = validMask(enc.transferQFam);
+    se.tsMaskEnc  = validMask(enc.encodeQFam);
+
+    VkPhysicalDeviceProperties dp{};
+    vkGetPhysicalDeviceProperties(enc.physDevice, &dp);
+    if (dp.limits.timestampPeriod <= 0.0f) se.tsMaskXfer = se.tsMaskEnc = 0;
+    if (se.tsMaskXfer == 0 && se.tsMaskEnc == 0) return;
+
+    VkQueryPoolCreateInfo qpci{};
+    qpci.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    qpci.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    qpci.queryCount = TS_COUNT;
+    if (vkCreateQueryPool(enc.device, &qpci, nullptr, &se.tsPool) != VK_SUCCESS) {
+        se.tsPool = VK_NULL_HANDLE;
+        se.tsMaskXfer = se.tsMaskEnc = 0;
+        return;
+    }
+    enc.stats.timingTransfer    = se.tsMaskXfer != 0;
+    enc.stats.timingEncode      = se.tsMaskEnc  != 0;
+    enc.stats.timestampPeriodNs = dp.limits.timestampPeriod;
+}
+
+static void writeTimestamp(Av1rStreamEncoder& se, VkCommandBuffer cmd,
+                           VkPipelineStageFlagBits stage, uint32_t slot)
+{
+    const bool xfer = slot < TS_ENC_BEGIN;
+    if (se.tsPool == VK_NULL_HANDLE || (xfer ? se.tsMaskXfer : se.tsMaskEnc) == 0) return;
+    vkCmdWriteTimestamp(cmd, stage, se.tsPool, slot);
+}
+
+static void resetTimestamps(Av1rStreamEncoder& se, VkCommandBuffer cmd, bool xfer)
+{
+    if (se.tsPool == VK_NULL_HANDLE || (xfer ? se.tsMaskXfer : se.tsMaskEnc) == 0) return;
+    if (xfer) vkCmdResetQueryPool(cmd, se.tsPool, TS_XFER_BEGIN, TS_ENC_BEGIN - TS_XFER_BEGIN);
+    else      vkCmdResetQueryPool(cmd, se.tsPool, TS_ENC_BEGIN, TS_COUNT - TS_ENC_BEGIN);
+}
+
+// Разность двух слотов в ms; NaN если очередь не пишет timestamps
+static double timestampDeltaMs(const Av1rStreamEncoder& se, uint32_t first, uint32_t n,
+                               uint64_t mask, uint32_t from, uint32_t to)
+{
+    if (se.tsPool == VK_NULL_HANDLE || mask == 0) return std::nan("");
+    uint64_t ts[TS_COUNT] = {};
+    if (vkGetQueryPoolResults(se.enc.device, se.tsPool, first, n,
+                              sizeof(uint64_t) * n, ts + first, sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+        return std::nan("");
+    const uint64_t d = ((ts[to] & mask) - (ts[from] & mask)) & mask;
+    return static_cast<double>(d) * se.enc.stats.timestampPeriodNs * 1e-6;
+}
+
 // Initialize streaming encoder (call once before encoding frames)
 void av1r_vulkan_encode_init(
-    Av1rVulkanCtx&       ctx,
-    Av1rStreamEncoder&   se,
-    int width, int height, int fps, int crf)
+    Av1rVulkanCtx&          ctx,
+    Av1rStreamEncoder&      se,
+    const Av1rEncodeConfig& cfg)
 {
+    const int width = cfg.width, height = cfg.height, fps = cfg.fps, crf = cfg.crf;
     if (!ctx.initialized)
         throw std::runtime_error("Vulkan context not initialized");
 
@@ -1048,6 +1418,22 @@ void av1r_vulkan_encode_init(
     se.enc.height         = static_cast<uint32_t>(height & ~1);
     se.enc.fps            = static_cast<uint32_t>(fps);
     se.enc.crf            = static_cast<uint32_t>(crf);
+    se.enc.preset         = static_cast<uint32_t>(cfg.preset);
+    se.enc.maxTiles       = cfg.maxTiles > 0 ? static_cast<uint32_t>(cfg.maxTiles) : 0u;
+    se.staticThreshold    = cfg.staticThreshold;
+    // GOP: по умолчанию max = 10 s, min = 1 s
+    se.keyintMax          = cfg.keyintMax > 0 ? static_cast<uint32_t>(cfg.keyintMax)
+                                              : static_cast<uint32_t>(fps) * 10u;
+    se.keyintMin          = cfg.keyintMin > 0 ? static_cast<uint32_t>(cfg.keyintMin)
+                                              : static_cast<uint32_t>(fps);
+    if (se.keyintMin > se.keyintMax) se.keyintMin = se.keyintMax;
+    se.enc.keyintMax      = se.keyintMax;
+    se.sceneCut           = cfg.sceneCut;
+    se.srcFmt             = static_cast<Av1rPixFmt>(cfg.srcFormat);
+    se.winLo              = cfg.windowLo;
+    se.winHi              = cfg.windowHi;
+    se.scene.reset(width, height);
+    se.enc.caps           = &av1r_vulkan_caps(ctx.instance, ctx.physDevice);
 
     createVideoSession(se.enc, crf);
     allocateVideoSessionMemory(se.enc);
@@ -1062,12 +1448,33 @@ void av1r_vulkan_encode_init(
     se.enc.encodeFence         = av1r_create_fence(se.enc.device);
     se.enc.transferFence       = av1r_create_fence(se.enc.device);
     se.enc.interQueueSemaphore = av1r_create_semaphore_binary(se.enc.device);
-
-    se.frameBytes = static_cast<size_t>(width * height * 3 / 2);
-    se.staging = av1r_buffer_create(
-        se.enc.physDevice, se.enc.device, se.frameBytes,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    se.gpuTiming = cfg.gpuTiming;
+    if (se.gpuTiming) createTimestampPool(se);
+
+    se.frameBytes    = av1r_pix_fmt_frame_bytes(se.srcFmt, width, height);
+    se.analysisBytes = av1r_pix_fmt_frame_bytes(AV1R_PIX_NV12, width, height);
+    if ((se.srcFmt == AV1R_PIX_GRAY16 || se.srcFmt == AV1R_PIX_RGB24) &&
+        (se.staticThreshold >= 0 || se.sceneCut > 0)) {
+        se.analysis.resize(se.analysisBytes);
+        se.analysisMem.set(AV1R_MEM_HOST, "analysis frame", se.analysis.capacity());
+    }
+    if (se.srcFmt != AV1R_PIX_NV12) {
+        try {
+            se.conv.init(se.enc.physDevice, se.enc.device, se.enc.transferQFam,
+                         se.srcFmt, width, height, se.winLo, se.winHi);
+            se.enc.stats.convert = "gpu";
+        } catch (const std::exception&) {
+            se.enc.stats.convert = "cpu";   // та же формула, в staging на CPU
+        }
+    }
+    if (!se.conv.ready()) {
+        se.staging = av1r_buffer_create(
+            se.enc.physDevice, se.enc.device,
+            av1r_pix_fmt_frame_bytes(AV1R_PIX_NV12, width, height),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            0, "staging");
+    }
 
     // Rate control + DPB layout init
     {
@@ -1092,19 +1499,81 @@ void av1r_vulkan_encode_init(
     se.ready = true;
 }
 
-// Encode one NV12 frame, append encoded packet to out_packet
+// Encode one frame (srcFmt layout), append encoded packet to out_packet
 void av1r_vulkan_encode_frame(
     Av1rStreamEncoder&    se,
-    const uint8_t*        frame_nv12,
+    const uint8_t*        frame,
     int                   frame_index,
     std::vector<uint8_t>& out_packet)
 {
     se.enc.frameCount = static_cast<uint32_t>(frame_index);
 
-    // --- Step 1: Upload NV12 on transfer queue ---
+    // 8-bit кадр для static / scene-cut анализа (см. Av1rStreamEncoder::analysis)
+    const uint8_t* nv12 = frame;
+    double analysisMs = 0.0;
+    if (!se.analysis.empty()) {
+        AV1R_TRACE_SPAN("convert (analysis)", "convert");
+        const auto t0 = std::chrono::steady_clock::now();
+        av1r_convert_to_nv12_cpu(se.srcFmt, frame, se.analysis.data(),
+                                 static_cast<int>(se.enc.width), static_cast<int>(se.enc.height),
+                                 se.winLo, se.winHi);
+        analysisMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t0).count();
+        nv12 = se.analysis.data();
+    }
+
+    se.enc.keyFrame = decideKeyFrame(se, nv12);
+    if (se.enc.keyFrame) {
+        se.enc.lastKeyIndex = se.enc.frameCount;
+        se.enc.stats.keyframes.push_back(se.enc.frameCount);
+    }
+
+    // --- Step 0: static/duplicate frame → show_existing_frame, no upload/encode ---
+    if (se.staticThreshold >= 0 && !se.lastEncoded.empty() &&
+        !se.enc.keyFrame && !se.enc.lastWasKey &&
+        se.skipRun < MAX_STATIC_RUN &&
+        av1r_frame_is_static(nv12, se.lastEncoded.data(), se.analysisBytes,
+                             se.staticThreshold)) {
+        AV1R_TRACE_SPAN("show_existing_frame", "encode");
+        out_packet.clear();
+        showExistingFrame(se.enc, out_packet);
+        se.skipRun++;
+        se.enc.stats.skippedFrames++;
+        return;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point tFrame = Clock::now();
+    double cpuConvertMs = 0.0;
+
+    // --- Step 1: Convert (compute) + upload NV12 on transfer queue ---
     VkCommandBuffer xferCmd = av1r_alloc_command_buffer(se.enc.device, se.enc.transferCommandPool);
     av1r_begin_command_buffer(xferCmd);
-    uploadNV12Frame(se.enc, xferCmd, frame_nv12, se.staging.buffer, se.staging.ptr);
+    resetTimestamps(se, xferCmd, true);
+    writeTimestamp(se, xferCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, TS_XFER_BEGIN);
+    if (se.conv.ready()) {
+        memcpy(se.conv.input(), frame, se.frameBytes);
+        se.conv.record(xferCmd);
+        writeTimestamp(se, xferCmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, TS_XFER_CONVERTED);
+        uploadNV12Frame(se.enc, xferCmd, se.conv.nv12_buffer());
+    } else if (nv12 != frame) {
+        // уже сконвертирован для анализа
+        AV1R_TRACE_SPAN("copy to staging", "convert");
+        memcpy(se.staging.ptr, nv12, se.analysisBytes);
+        cpuConvertMs = analysisMs +
+            std::chrono::duration<double, std::milli>(Clock::now() - tFrame).count();
+        writeTimestamp(se, xferCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, TS_XFER_CONVERTED);
+        uploadNV12Frame(se.enc, xferCmd, se.staging.buffer);
+    } else {
+        AV1R_TRACE_SPAN(se.srcFmt == AV1R_PIX_NV12 ? "copy to staging" : "convert (cpu)", "convert");
+        av1r_convert_to_nv12_cpu(se.srcFmt, frame, static_cast<uint8_t*>(se.staging.ptr),
+                                 static_cast<int>(se.enc.width), static_cast<int>(se.enc.height),
+                                 se.winLo, se.winHi);
+        cpuConvertMs = std::chrono::duration<double, std::milli>(Clock::now() - tFrame).count();
+        writeTimestamp(se, xferCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, TS_XFER_CONVERTED);
+        uploadNV12Frame(se.enc, xferCmd, se.staging.buffer);
+    }
+    writeTimestamp(se, xferCmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, TS_XFER_END);
     av1r_end_command_buffer(xferCmd);
 
     // Submit transfer, signal semaphore when done
@@ -1115,14 +1584,19 @@ void av1r_vulkan_encode_frame(
     xferSi.signalSemaphoreCount = 1;
     xferSi.pSignalSemaphores    = &se.enc.interQueueSemaphore;
     av1r_reset_fence(se.enc.device, se.enc.transferFence);
+    int64_t tTrace = av1r_trace_now_us();
     VkResult xferRes = vkQueueSubmit(se.enc.transferQueue, 1, &xferSi, se.enc.transferFence);
+    av1r_trace_span("submit transfer", "vulkan", tTrace, av1r_trace_now_us() - tTrace);
     if (xferRes != VK_SUCCESS)
         throw std::runtime_error("vkQueueSubmit (transfer) failed: " + std::to_string(xferRes));
 
     // --- Step 2: Encode on encode queue, wait for transfer semaphore ---
     VkCommandBuffer encCmd = av1r_alloc_command_buffer(se.enc.device, se.enc.encodeCommandPool);
     av1r_begin_command_buffer(encCmd);
+    resetTimestamps(se, encCmd, false);
+    writeTimestamp(se, encCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, TS_ENC_BEGIN);
     encodeOneFrame(se.enc, encCmd);
+    writeTimestamp(se, encCmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, TS_ENC_END);
     av1r_end_command_buffer(encCmd);
 
     VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
@@ -1134,13 +1608,19 @@ void av1r_vulkan_encode_frame(
     encSi.commandBufferCount   = 1;
     encSi.pCommandBuffers      = &encCmd;
     av1r_reset_fence(se.enc.device, se.enc.encodeFence);
+    tTrace = av1r_trace_now_us();
     VkResult encRes = vkQueueSubmit(se.enc.encodeQueue, 1, &encSi, se.enc.encodeFence);
+    av1r_trace_span("submit encode", "vulkan", tTrace, av1r_trace_now_us() - tTrace);
     if (encRes != VK_SUCCESS)
         throw std::runtime_error("vkQueueSubmit (encode) failed: " + std::to_string(encRes));
 
     // Wait for both to finish
+    tTrace = av1r_trace_now_us();
     av1r_wait_fence(se.enc.device, se.enc.transferFence);
     av1r_wait_fence(se.enc.device, se.enc.encodeFence);
+    av1r_trace_span("wait fences", "vulkan", tTrace, av1r_trace_now_us() - tTrace);
+    const Clock::time_point tReadback = Clock::now();
+    tTrace = av1r_trace_now_us();
 
     out_packet.clear();
     // Prepend sequence header OBU before first frame
@@ -1151,7 +1631,35 @@ void av1r_vulkan_encode_frame(
         se.enc.seqHeaderPending = false;
     }
     getOutputPacket(se.enc, out_packet);
+    av1r_trace_span("readback", "vulkan", tTrace, av1r_trace_now_us() - tTrace);
+
+    if (se.gpuTiming) {
+        const Clock::time_point tEnd = Clock::now();
+        Av1rFrameTiming t;
+        t.frame      = se.enc.frameCount;
+        t.readbackMs = std::chrono::duration<double, std::milli>(tEnd - tReadback).count();
+        t.convertMs  = se.conv.ready()
+            ? timestampDeltaMs(se, TS_XFER_BEGIN, 3, se.tsMaskXfer, TS_XFER_BEGIN, TS_XFER_CONVERTED)
+            : cpuConvertMs;
+        t.uploadMs   = timestampDeltaMs(se, TS_XFER_BEGIN, 3, se.tsMaskXfer,
+                                        TS_XFER_CONVERTED, TS_XFER_END);
+        t.encodeMs   = timestampDeltaMs(se, TS_ENC_BEGIN, 2, se.tsMaskEnc,
+                                        TS_ENC_BEGIN, TS_ENC_END);
+        // Остаток wall time: submit, semaphore transfer → encode, fence wait.
+        // Без timestamps на очереди сюда попадает и её GPU время.
+        double covered = t.readbackMs;
+        for (double ms : { t.convertMs, t.uploadMs, t.encodeMs })
+            if (!std::isnan(ms)) covered += ms;
+        const double wall = std::chrono::duration<double, std::milli>(tEnd - tFrame).count();
+        t.syncMs = wall > covered ? wall - covered : 0.0;
+        se.enc.stats.timings.push_back(t);
+    }
 
+    if (se.staticThreshold >= 0) {
+        se.lastEncoded.assign(nv12, nv12 + se.analysisBytes);
+        se.lastEncodedMem.set(AV1R_MEM_HOST, "static reference", se.lastEncoded.capacity());
+        se.skipRun = 0;
+    }
 
     vkFreeCommandBuffers(se.enc.device, se.enc.transferCommandPool, 1, &xferCmd);
     vkFreeCommandBuffers(se.enc.device, se.enc.encodeCommandPool, 1, &encCmd);
@@ -1159,22 +1667,39 @@ void av1r_vulkan_encode_frame(
 
 // Cleanup streaming encoder
 void av1r_vulkan_encode_finish(Av1rStreamEncoder& se) {
+    se.conv.destroy();
+    if (se.tsPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(se.enc.device, se.tsPool, nullptr);
+        se.tsPool = VK_NULL_HANDLE;
+    }
     av1r_buffer_destroy(se.enc.device, se.staging);
     destroyEncoder(se.enc);
+    se.lastEncodedMem.release();
     se.ready = false;
 }
 
+Av1rStreamEncoder::~Av1rStreamEncoder() {
+    releaseMemCharges(enc);
+    staging.mem.release();
+    lastEncodedMem.release();
+    analysisMem.release();
+}
+
 // Opaque API (used from av1r_bindings.cpp via av1r_stream_encoder.h)
 Av1rStreamEncoder* av1r_vulkan_stream_new() { return new Av1rStreamEncoder{}; }
 
 void av1r_vulkan_stream_init(Av1rVulkanCtx& ctx, Av1rStreamEncoder* se,
-                              int w, int h, int fps, int crf) {
-    av1r_vulkan_encode_init(ctx, *se, w, h, fps, crf);
+                              const Av1rEncodeConfig& cfg) {
+    AV1R_TRACE_SPAN("encoder init", "vulkan");
+    av1r_vulkan_encode_init(ctx, *se, cfg);
 }
 void av1r_vulkan_stream_encode(Av1rStreamEncoder* se, const uint8_t* frame,
                                 int idx, std::vector<uint8_t>& pkt) {
     av1r_vulkan_encode_frame(*se, frame, idx, pkt);
 }
+const Av1rEncodeStats& av1r_vulkan_stream_stats(const Av1rStreamEncoder* se) {
+    return se->enc.stats;
+}
 void av1r_vulkan_stream_finish(Av1rStreamEncoder* se) {
     av1r_vulkan_encode_finish(*se);
 }
@@ -0,0 +1,114 @@
+// XXH64 и выборочный отпечаток файла (см. av1r_hash.h).
+
+#include "av1r_hash.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+const uint64_t P1 = 11400714785074694791ULL;
+const uint64_t P2 = 14029467366897019727ULL;
+const uint64_t P3 =  1609587929392839161ULL;
+const uint64_t P4 =  9650029242287828579ULL;
+const uint64_t P5 =  2870177450012600261ULL;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+// Little-endian loads regardless of host order
+inline uint64_t read64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+inline uint32_t read32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * P2;
+    return rotl(acc, 31) * P1;
+}
+inline uint64_t merge(uint64_t acc, uint64_t val) {
+    acc ^= xxh_round(0, val);
+    return acc * P1 + P4;
+}
+
+} // namespace
+
+uint64_t av1r_xxh64(const void* data, size_t n, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + n;
+    uint64_t h;
+    if (n >= 32) {
+        uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = xxh_round(v1, read64(p));      p += 8;
+            v2 = xxh_round(v2, read64(p));      p += 8;
+            v3 = xxh_round(v3, read64(p));      p += 8;
+            v4 = xxh_round(v4, read64(p));      p += 8;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(h, v1);
+        h = merge(h, v2);
+        h = merge(h, v3);
+        h = merge(h, v4);
+    } else {
+        h = seed + P5;
+    }
+    h += static_cast<uint64_t>(n);
+    for (; p + 8 <= end; p += 8) h = rotl(h ^ xxh_round(0, read64(p)), 27) * P1 + P4;
+    if (p + 4 <= end) {
+        h = rotl(h ^ (static_cast<uint64_t>(read32(p)) * P1), 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p < end; p++) h = rotl(h ^ (*p * P5), 11) * P1;
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+bool av1r_file_fingerprint(const std::string& path, size_t sample, uint64_t& hash,
+                           uint64_t& size) {
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    if (!f) return false;
+    const std::streamoff len = f.tellg();
+    if (len < 0) return false;
+    size = static_cast<uint64_t>(len);
+
+    // size (8 bytes, LE) + samples; the size makes truncation visible even
+    // when the samples happen to match
+    std::vector<uint8_t> buf(8);
+    for (int i = 0; i < 8; i++) buf[i] = static_cast<uint8_t>(size >> (8 * i));
+    auto take = [&](uint64_t off, size_t n) {
+        const size_t at = buf.size();
+        buf.resize(at + n);
+        f.seekg(static_cast<std::streamoff>(off));
+        f.read(reinterpret_cast<char*>(buf.data() + at), static_cast<std::streamsize>(n));
+        return f.gcount() == static_cast<std::streamsize>(n);
+    };
+    bool ok;
+    if (sample == 0 || size <= 3 * static_cast<uint64_t>(sample)) {
+        ok = take(0, static_cast<size_t>(size));
+    } else {
+        ok = take(0, sample) &&
+             take((size - sample) / 2, sample) &&
+             take(size - sample, sample);
+    }
+    if (!ok) return false;
+    hash = av1r_xxh64(buf.data(), buf.size(), 0);
+    return true;
+}
+
+std::string av1r_hash_hex(uint64_t h) {
+    char s[17];
+    std::snprintf(s, sizeof(s), "%016llx", static_cast<unsigned long long>(h));
+    return s;
+}
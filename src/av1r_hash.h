@@ -0,0 +1,26 @@
+// Fast file fingerprints for the convert_folder() manifest (R/manifest.R):
+// XXH64 (xxHash, 64-bit) and a sampled file hash that reads at most three
+// blocks per file, so planning a large tree costs one stat() and a few
+// small reads per file instead of reading every video.
+
+#ifndef AV1R_HASH_H
+#define AV1R_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// XXH64 of `n` bytes; identical to the reference XXH64(data, n, seed)
+uint64_t av1r_xxh64(const void* data, size_t n, uint64_t seed = 0);
+
+// XXH64 over the file size and `sample` bytes each from the start, the
+// middle and the end (the whole file when it is at most 3 * sample bytes).
+// Catches truncation and rewrites; not a full-content checksum.
+// Returns false if the file cannot be read.
+bool av1r_file_fingerprint(const std::string& path, size_t sample, uint64_t& hash,
+                           uint64_t& size);
+
+// 16-digit lowercase hex
+std::string av1r_hash_hex(uint64_t h);
+
+#endif
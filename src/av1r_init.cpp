@@ -15,6 +15,9 @@
 
 VkInstance av1r_create_instance()
 {
+    // Loader или встроенный stub-драйвер (AV1R_VULKAN_STUB), см. av1r_vk_dispatch.h
+    av1r_vk_select_driver();
+
     VkApplicationInfo appInfo{};
     appInfo.sType            = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pApplicationName = "AV1R";
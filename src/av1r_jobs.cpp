@@ -0,0 +1,212 @@
+// Bounded command pool (см. av1r_jobs.h).
+// Потоки-воркеры берут задачи из общей очереди (класс 0 — с головы,
+// остальные — с хвоста); каждый воркер получает свою строку в трассе
+// ("<name> worker N").
+
+#include "av1r_jobs.h"
+#include "av1r_trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+#ifndef _WIN32
+#  include <csignal>
+#  include <fcntl.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+#ifndef _WIN32
+// Pipe whose ends are not inherited by the children other workers fork at
+// the same time (an inherited write end keeps our reader from seeing EOF)
+static int cloexec_pipe(int fds[2]) {
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+    return ::pipe2(fds, O_CLOEXEC);
+#else
+    if (::pipe(fds) != 0) return -1;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+#endif
+}
+#endif
+
+Av1rJobPool::Av1rJobPool(const std::vector<std::vector<std::string>>& cmds,
+                         const std::vector<std::string>& names)
+    : names_(names) {
+    const size_t n = cmds.empty() ? 0 : cmds[0].size();
+    jobs_.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        jobs_.emplace_back(new Av1rJob());
+        for (const std::vector<std::string>& c : cmds)
+            jobs_.back()->cmds.push_back(i < c.size() ? c[i] : std::string());
+        queue_.push_back(i);
+    }
+}
+
+Av1rJobPool::~Av1rJobPool() {
+    cancel();
+    join();
+}
+
+void Av1rJobPool::start(const std::vector<int>& workers) {
+    t0_ = std::chrono::steady_clock::now();
+    std::vector<int> n(workers);
+    int total = 0;
+    for (int& w : n) {
+        w = std::max(0, std::min(w, static_cast<int>(jobs_.size())));
+        total += w;
+    }
+    active_.store(total);
+    int slot = 0;
+    for (size_t c = 0; c < n.size(); c++)
+        for (int w = 0; w < n[c]; w++)
+            threads_.emplace_back(&Av1rJobPool::worker, this, slot++, static_cast<int>(c));
+}
+
+void Av1rJobPool::kill(int sig) {
+    cancel();
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(pidMu_);
+    killSig_.store(sig);
+    for (const auto& j : jobs_) {
+        const long pid = j->pid.load();
+        if (pid > 0) ::kill(-static_cast<pid_t>(pid), sig);
+    }
+#else
+    (void)sig;
+#endif
+}
+
+void Av1rJobPool::join() {
+    for (std::thread& t : threads_) if (t.joinable()) t.join();
+    threads_.clear();
+}
+
+int Av1rJobPool::frames() const {
+    int n = 0;
+    for (const auto& j : jobs_) n += j->frames.load(std::memory_order_relaxed);
+    return n;
+}
+
+uint64_t Av1rJobPool::bytes() const {
+    uint64_t n = 0;
+    for (const auto& j : jobs_) n += j->bytes.load(std::memory_order_relaxed);
+    return n;
+}
+
+void Av1rJobPool::worker(int slot, int cls) {
+    for (;;) {
+        if (cancel_.load()) break;
+        const long i = take(cls);
+        if (i < 0) break;
+        run(*jobs_[static_cast<size_t>(i)], slot, cls);
+    }
+    active_.fetch_sub(1);
+}
+
+long Av1rJobPool::take(int cls) {
+    std::lock_guard<std::mutex> lock(mu_);
+    const size_t c = static_cast<size_t>(cls);
+    auto runnable = [&](size_t i) { return c < jobs_[i]->cmds.size() && !jobs_[i]->cmds[c].empty(); };
+    // Класс 0 берёт с головы очереди, остальные — с хвоста
+    if (cls == 0) {
+        for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+            if (!runnable(*it)) continue;
+            const size_t i = *it;
+            queue_.erase(it);
+            return static_cast<long>(i);
+        }
+    } else {
+        for (auto it = queue_.rbegin(); it != queue_.rend(); ++it) {
+            if (!runnable(*it)) continue;
+            const size_t i = *it;
+            queue_.erase(std::next(it).base());
+            return static_cast<long>(i);
+        }
+    }
+    return -1;
+}
+
+void Av1rJobPool::run(Av1rJob& job, int slot, int cls) {
+    typedef std::chrono::steady_clock Clock;
+    const std::string& name = names_.empty() ? std::string("job")
+                            : names_[std::min(static_cast<size_t>(cls), names_.size() - 1)];
+    const std::string track = name + " worker " + std::to_string(slot + 1);
+    Av1rTraceSpan span(name.c_str(), "process", av1r_trace_child(track.c_str()));
+    job.worker   = slot;
+    job.cls      = cls;
+    job.startSec = std::chrono::duration<double>(Clock::now() - t0_).count();
+    job.started.store(true);
+
+    FILE* pipe = nullptr;
+#ifdef _WIN32
+    pipe = popen(job.cmds[static_cast<size_t>(cls)].c_str(), "r");
+#else
+    // sh -c in a new process group, stdout to us; between fork and exec
+    // only async-signal-safe calls. dup2 clears close-on-exec on fd 1 only.
+    pid_t pid = -1;
+    int fds[2];
+    if (cloexec_pipe(fds) == 0) {
+        pid = fork();
+        if (pid == 0) {
+            setpgid(0, 0);
+            dup2(fds[1], 1);
+            close(fds[0]);
+            close(fds[1]);
+            execl("/bin/sh", "sh", "-c", job.cmds[static_cast<size_t>(cls)].c_str(),
+                  static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        close(fds[1]);
+        if (pid < 0) close(fds[0]);
+        else pipe = fdopen(fds[0], "r");
+    }
+    if (pid > 0) {
+        setpgid(pid, pid);   // no race with kill() before the child's own setpgid
+        std::lock_guard<std::mutex> lock(pidMu_);
+        job.pid.store(pid);
+        // kill() ran between take() and fork(): the job goes down too
+        if (const int sig = killSig_.load()) ::kill(-pid, sig);
+    }
+#endif
+    if (!pipe) {
+        job.status = 127;
+    } else {
+        // -progress pipe:1: блоки key=value, "progress=continue|end"
+        char line[512];
+        while (std::fgets(line, sizeof(line), pipe)) {
+            if (std::strncmp(line, "frame=", 6) == 0) {
+                job.frames.store(std::atoi(line + 6), std::memory_order_relaxed);
+            } else if (std::strncmp(line, "total_size=", 11) == 0) {
+                const long long b = std::atoll(line + 11);
+                if (b > 0) job.bytes.store(static_cast<uint64_t>(b), std::memory_order_relaxed);
+            }
+        }
+#ifdef _WIN32
+        job.status = pclose(pipe);
+#else
+        std::fclose(pipe);
+        // Wait for the exit without reaping: until waitpid() the pid stays a
+        // zombie that cannot be reused, so kill() may still signal it
+        siginfo_t info;
+        while (waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOWAIT) < 0 &&
+               errno == EINTR) {}
+        {
+            std::lock_guard<std::mutex> lock(pidMu_);
+            job.pid.store(0);
+        }
+        int st = 0;
+        while (waitpid(pid, &st, 0) < 0 && errno == EINTR) {}
+        job.status = WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+#endif
+    }
+    job.endSec = std::chrono::duration<double>(Clock::now() - t0_).count();
+    span.args("\"status\":" + std::to_string(job.status) +
+              ",\"frames\":" + std::to_string(job.frames.load()));
+    job.done.store(true);
+}
@@ -0,0 +1,91 @@
+// Bounded pool of external commands, at most `workers` at a time
+// (R_av1r_run_jobs): one ffmpeg per chunk in the chunked CPU encode
+// (R/chunked.R), one Rscript per file in convert_folder(jobs =) (R/batch.R).
+//
+// Each command runs under /bin/sh in its own process group (popen() on
+// Windows); its stdout is read as ffmpeg `-progress pipe:1` key=value
+// lines (the batch workers print the same frame=/total_size= keys), so the
+// caller can poll frames and bytes of all running jobs from the R thread.
+// kill() signals the process groups, which takes down a job's ffmpeg
+// children with it.
+//
+// Workers come in classes (hybrid batch: class 0 = the Vulkan worker,
+// class 1 = CPU workers), and a job has one command per class, empty where
+// that class cannot run it. All classes share one queue in the given
+// order: class 0 takes the first job it can run, the other classes the
+// last one, so the R side puts the jobs that gain most from the GPU first.
+// With a single class that is plain in-order dispatch (longest first).
+
+#ifndef AV1R_JOBS_H
+#define AV1R_JOBS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Av1rJob {
+    std::vector<std::string> cmds;   // per worker class; "" = not for that class
+    std::atomic<int>      frames{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<bool>     started{false};
+    std::atomic<bool>     done{false};
+    std::atomic<long>     pid{0};    // process group while running (not on Windows)
+    int    status   = -1;    // exit code; -1 = not started (cancelled)
+    int    worker   = -1;    // 0-based worker slot that ran it
+    int    cls      = -1;    // class of that worker
+    double startSec = 0.0;   // since Av1rJobPool::start()
+    double endSec   = 0.0;
+};
+
+class Av1rJobPool {
+public:
+    // cmds[class][job]; names[class]: trace span of a job and prefix of
+    // the worker tracks
+    Av1rJobPool(const std::vector<std::vector<std::string>>& cmds,
+                const std::vector<std::string>& names);
+    ~Av1rJobPool();
+    Av1rJobPool(const Av1rJobPool&) = delete;
+    Av1rJobPool& operator=(const Av1rJobPool&) = delete;
+
+    // workers[class]; slots are numbered across classes
+    void start(const std::vector<int>& workers);
+    // True once every started job has finished and no job is left
+    bool finished() const { return active_.load() == 0; }
+    // No new jobs are started; running ones finish
+    void cancel() { cancel_.store(true); }
+    // cancel() and send `sig` (SIGTERM, SIGKILL) to the running jobs; on
+    // Windows the same as cancel()
+    void kill(int sig);
+    void join();
+
+    size_t size() const { return jobs_.size(); }
+    const Av1rJob& job(size_t i) const { return *jobs_[i]; }
+    int      frames() const;
+    uint64_t bytes() const;
+private:
+    void worker(int slot, int cls);
+    // Next job for a worker of class `cls`, or -1 when none is left
+    long take(int cls);
+    void run(Av1rJob& job, int slot, int cls);
+
+    std::vector<std::unique_ptr<Av1rJob>> jobs_;
+    std::vector<std::string> names_;
+    std::vector<std::thread> threads_;
+    std::mutex               mu_;
+    std::deque<size_t>       queue_;
+    std::atomic<int>         active_{0};
+    std::atomic<bool>        cancel_{false};
+    std::atomic<int>         killSig_{0};
+    // Serialises kill() with publishing and clearing job pids, so a signal
+    // never reaches a reaped (possibly reused) pid
+    std::mutex               pidMu_;
+    std::chrono::steady_clock::time_point t0_;
+};
+
+#endif
@@ -140,6 +140,37 @@ VkDevice av1r_create_logical_device(VkPhysicalDevice phys,
     return device;
 }
 
+// Compute-only device (no video extensions): used by the GPU conversion
+// benchmark on drivers without an encode queue (e.g. lavapipe in CI).
+// Queue family is picked the same way as the encoder's transfer queue.
+VkDevice av1r_create_compute_device(VkPhysicalDevice phys, uint32_t* qfamily_out)
+{
+    uint32_t family = find_transfer_queue_family(phys);
+    if (family == UINT32_MAX) {
+        throw std::runtime_error("No TRANSFER queue family on this GPU");
+    }
+    if (qfamily_out) *qfamily_out = family;
+
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo qci{};
+    qci.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    qci.queueFamilyIndex = family;
+    qci.queueCount       = 1;
+    qci.pQueuePriorities = &priority;
+
+    VkDeviceCreateInfo dci{};
+    dci.sType                = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    dci.queueCreateInfoCount = 1;
+    dci.pQueueCreateInfos    = &qci;
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkResult res = vkCreateDevice(phys, &dci, nullptr, &device);
+    if (res != VK_SUCCESS) {
+        throw std::runtime_error("vkCreateDevice failed: " + std::to_string(res));
+    }
+    return device;
+}
+
 void av1r_destroy_logical_device(VkDevice device)
 {
     if (device != VK_NULL_HANDLE) {
@@ -158,7 +189,8 @@ Av1rBuffer av1r_buffer_create(VkPhysicalDevice      phys,
                                size_t                size,
                                VkBufferUsageFlags    usage,
                                VkMemoryPropertyFlags req_flags,
-                               VkMemoryPropertyFlags fallback_flags)
+                               VkMemoryPropertyFlags fallback_flags,
+                               const char*           mem_category)
 {
     Av1rBuffer buf{};
     buf.device = device;
@@ -206,6 +238,7 @@ Av1rBuffer av1r_buffer_create(VkPhysicalDevice      phys,
     }
 
     vkBindBufferMemory(device, buf.buffer, buf.device_memory, 0);
+    buf.mem.set(AV1R_MEM_DEVICE, mem_category, mem_req.size);
 
     // Map if host-visible (ggmlR строка 2484-2486)
     if (buf.memory_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
@@ -225,6 +258,7 @@ void av1r_buffer_destroy(VkDevice device, Av1rBuffer& buf)
         vkFreeMemory(device, buf.device_memory, nullptr);
         buf.device_memory = VK_NULL_HANDLE;
     }
+    buf.mem.release();
     if (buf.buffer != VK_NULL_HANDLE) {
         vkDestroyBuffer(device, buf.buffer, nullptr);
         buf.buffer = VK_NULL_HANDLE;
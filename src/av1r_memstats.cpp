@@ -0,0 +1,86 @@
+// Memory accounting (см. av1r_memstats.h).
+
+#include "av1r_memstats.h"
+
+#include <algorithm>
+#include <cstring>
+
+void Av1rMemAccount::add(Av1rMemDomain domain, const char* category, int64_t delta) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = std::find_if(cats_.begin(), cats_.end(), [&](const Av1rMemUsage& u) {
+        return u.domain == domain && u.category == category;
+    });
+    if (it == cats_.end()) {
+        cats_.push_back({category, domain, 0, 0});
+        it = cats_.end() - 1;
+    }
+    // Освобождение больше учтённого — ошибка учёта, но не повод уходить в минус
+    auto apply = [delta](uint64_t& v) {
+        v = delta < 0 && static_cast<uint64_t>(-delta) > v ? 0 : v + delta;
+    };
+    apply(it->current);
+    it->peak = std::max(it->peak, it->current);
+    apply(current_[domain]);
+    peak_[domain] = std::max(peak_[domain], current_[domain]);
+}
+
+std::vector<Av1rMemUsage> Av1rMemAccount::usage() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return cats_;
+}
+
+uint64_t Av1rMemAccount::current(Av1rMemDomain domain) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return current_[domain];
+}
+
+uint64_t Av1rMemAccount::peak(Av1rMemDomain domain) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return peak_[domain];
+}
+
+void Av1rMemAccount::reset_peaks() {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (Av1rMemUsage& u : cats_) u.peak = u.current;
+    peak_[0] = current_[0];
+    peak_[1] = current_[1];
+}
+
+Av1rMemAccount& av1r_mem_process() {
+    static Av1rMemAccount acct;
+    return acct;
+}
+
+namespace {
+thread_local Av1rMemAccountPtr t_encodeAccount;
+}
+
+Av1rMemAccountPtr av1r_mem_encode() { return t_encodeAccount; }
+
+Av1rMemScope::Av1rMemScope(const Av1rMemAccountPtr& acct) : prev_(t_encodeAccount) {
+    t_encodeAccount = acct;
+}
+
+Av1rMemScope::~Av1rMemScope() { t_encodeAccount = prev_; }
+
+void Av1rMemCharge::set(Av1rMemDomain d, const char* cat, uint64_t newBytes) {
+    if (bytes != 0 && (d != domain || std::strcmp(cat, category) != 0)) release();
+    if (bytes == 0) {
+        encode   = av1r_mem_encode();
+        category = cat;
+        domain   = d;
+    }
+    const int64_t delta = static_cast<int64_t>(newBytes) - static_cast<int64_t>(bytes);
+    if (delta == 0) return;
+    av1r_mem_process().add(domain, category, delta);
+    if (encode) encode->add(domain, category, delta);
+    bytes = newBytes;
+}
+
+void Av1rMemCharge::release() {
+    if (bytes == 0) return;
+    av1r_mem_process().add(domain, category, -static_cast<int64_t>(bytes));
+    if (encode) encode->add(domain, category, -static_cast<int64_t>(bytes));
+    bytes = 0;
+    encode.reset();
+}
@@ -0,0 +1,81 @@
+// Host and device memory accounting (per encode and per process).
+//
+// Device = Vulkan allocations (vkAllocateMemory: session memory, DPB and
+// source images, bitstream and staging buffers); host = heap buffers of the
+// frame pipeline (frame and packet buffers, denoise reference, static-frame
+// reference) plus what the R side reports (the magick TIFF stack).
+//
+// Charges go to the account installed on the calling thread by
+// Av1rMemScope (one per encode) and always to the process account, so
+// av1r_memory() sees every live encode. Each category keeps current and
+// peak bytes; per-domain totals keep their own peak, which is the number a
+// batch scheduler needs (the sum of category peaks overstates it).
+
+#ifndef AV1R_MEMSTATS_H
+#define AV1R_MEMSTATS_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum Av1rMemDomain { AV1R_MEM_HOST = 0, AV1R_MEM_DEVICE = 1 };
+
+struct Av1rMemUsage {
+    std::string   category;
+    Av1rMemDomain domain;
+    uint64_t      current;
+    uint64_t      peak;
+};
+
+class Av1rMemAccount {
+public:
+    // delta > 0: allocation, < 0: release
+    void add(Av1rMemDomain domain, const char* category, int64_t delta);
+    std::vector<Av1rMemUsage> usage() const;
+    uint64_t current(Av1rMemDomain domain) const;
+    uint64_t peak(Av1rMemDomain domain) const;
+    // Peaks restart from the current usage
+    void reset_peaks();
+private:
+    mutable std::mutex mu_;
+    std::vector<Av1rMemUsage> cats_;
+    uint64_t current_[2] = {0, 0};
+    uint64_t peak_[2]    = {0, 0};
+};
+
+typedef std::shared_ptr<Av1rMemAccount> Av1rMemAccountPtr;
+
+Av1rMemAccount& av1r_mem_process();
+// Account of the encode running on this thread, null outside an encode
+Av1rMemAccountPtr av1r_mem_encode();
+
+// Installs `acct` as this thread's encode account for the scope's lifetime.
+// Charges hold a reference, so an Rf_error longjmp past the scope leaves
+// nothing dangling (the next scope replaces the stale account).
+class Av1rMemScope {
+public:
+    explicit Av1rMemScope(const Av1rMemAccountPtr& acct);
+    ~Av1rMemScope();
+    Av1rMemScope(const Av1rMemScope&) = delete;
+    Av1rMemScope& operator=(const Av1rMemScope&) = delete;
+private:
+    Av1rMemAccountPtr prev_;
+};
+
+// One tracked allocation: remembers where it was charged so the release
+// goes to the same accounts. set() replaces the previous size (resizable
+// host vectors); release() is idempotent. No destructor: it lives in
+// copyable handles (Av1rBuffer), the owner releases explicitly.
+struct Av1rMemCharge {
+    Av1rMemAccountPtr encode;
+    const char*     category = nullptr;
+    Av1rMemDomain   domain   = AV1R_MEM_HOST;
+    uint64_t        bytes    = 0;
+
+    void set(Av1rMemDomain d, const char* cat, uint64_t newBytes);
+    void release();
+};
+
+#endif
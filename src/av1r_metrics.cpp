@@ -0,0 +1,506 @@
+// Native SSIM/PSNR (см. av1r_metrics.h). Формулы и константы как в
+// libavfilter vf_ssim.c / vf_psnr.c (8 bit), чтобы значения совпадали с
+// ffmpeg -lavfi ssim / psnr.
+// AVX2 для block sums и SSE — через target attribute и проверку CPU при
+// первом вызове, иначе скалярный вариант.
+
+#include "av1r_metrics.h"
+#include "av1r_decode.h"
+#include "av1r_trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#  include <immintrin.h>
+#  define AV1R_METRICS_AVX2 1
+#endif
+
+namespace {
+
+// Sums over a 4x4 block: a, b, a^2 + b^2, a*b
+struct BlockSums { int64_t s1, s2, ss, s12; };
+
+void block_row_scalar(const uint8_t* a, int aStride, const uint8_t* b, int bStride,
+                      BlockSums* out, int blocks) {
+    for (int z = 0; z < blocks; z++, a += 4, b += 4) {
+        BlockSums s = { 0, 0, 0, 0 };
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++) {
+                const int va = a[x + y * aStride], vb = b[x + y * bStride];
+                s.s1  += va;
+                s.s2  += vb;
+                s.ss  += va * va + vb * vb;
+                s.s12 += va * vb;
+            }
+        }
+        out[z] = s;
+    }
+}
+
+// Sum of squared differences of one row
+uint64_t sse_row_scalar(const uint8_t* a, const uint8_t* b, int n) {
+    uint64_t s = 0;
+    for (int i = 0; i < n; i++) {
+        const int d = a[i] - b[i];
+        s += static_cast<uint64_t>(d * d);
+    }
+    return s;
+}
+
+#if defined(AV1R_METRICS_AVX2)
+// Four blocks (16 pixels) per step: 16-bit pixels, pair sums by madd, then
+// hadd within each 128-bit lane gives blocks z, z+1 (low) and z+2, z+3 (high)
+__attribute__((target("avx2")))
+void block_row_avx2(const uint8_t* a, int aStride, const uint8_t* b, int bStride,
+                    BlockSums* out, int blocks) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    int z = 0;
+    for (; z + 4 <= blocks; z += 4, a += 16, b += 16) {
+        __m256i s1 = _mm256_setzero_si256(), s2 = _mm256_setzero_si256();
+        __m256i ss = _mm256_setzero_si256(), s12 = _mm256_setzero_si256();
+        for (int y = 0; y < 4; y++) {
+            const __m256i va = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + y * aStride)));
+            const __m256i vb = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + y * bStride)));
+            s1  = _mm256_add_epi16(s1, va);     // <= 4 * 255, без переполнения
+            s2  = _mm256_add_epi16(s2, vb);
+            ss  = _mm256_add_epi32(ss, _mm256_add_epi32(_mm256_madd_epi16(va, va),
+                                                        _mm256_madd_epi16(vb, vb)));
+            s12 = _mm256_add_epi32(s12, _mm256_madd_epi16(va, vb));
+        }
+        const __m256i h12 = _mm256_hadd_epi32(_mm256_madd_epi16(s1, ones),
+                                              _mm256_madd_epi16(s2, ones));
+        const __m256i hsq = _mm256_hadd_epi32(ss, s12);
+        alignas(32) int32_t t12[8], tsq[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(t12), h12);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(tsq), hsq);
+        for (int k = 0; k < 4; k++) {
+            const int i = (k >> 1) * 4 + (k & 1);
+            out[z + k] = { t12[i], t12[i + 2], tsq[i], tsq[i + 2] };
+        }
+    }
+    block_row_scalar(a, aStride, b, bStride, out + z, blocks - z);
+}
+
+// 16 pixels per step; 32-bit lanes gain at most 2 * 255^2 per step, so rows
+// up to ~500k pixels cannot overflow
+__attribute__((target("avx2")))
+uint64_t sse_row_avx2(const uint8_t* a, const uint8_t* b, int n) {
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i d = _mm256_sub_epi16(
+            _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))),
+            _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(d, d));
+    }
+    alignas(32) uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    uint64_t s = 0;
+    for (uint32_t v : lanes) s += v;
+    return s + sse_row_scalar(a + i, b + i, n - i);
+}
+#endif
+
+struct Kernels {
+    void     (*block_row)(const uint8_t*, int, const uint8_t*, int, BlockSums*, int);
+    uint64_t (*sse_row)(const uint8_t*, const uint8_t*, int);
+    const char* name;
+};
+
+const Kernels& kernels() {
+    static const Kernels k = []() -> Kernels {
+#if defined(AV1R_METRICS_AVX2)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return { block_row_avx2, sse_row_avx2, "avx2" };
+#endif
+        return { block_row_scalar, sse_row_scalar, "scalar" };
+    }();
+    return k;
+}
+
+// SSIM of one 8x8 window from the sums of its four 4x4 blocks, split into
+// luminance and contrast-structure terms (ssim = l * cs)
+void window_ssim(int64_t s1, int64_t s2, int64_t ss, int64_t s12, double& l, double& cs) {
+    static const int64_t c1 = static_cast<int64_t>(.01 * .01 * 255 * 255 * 64 + .5);
+    static const int64_t c2 = static_cast<int64_t>(.03 * .03 * 255 * 255 * 64 * 63 + .5);
+    const int64_t vars  = ss * 64 - s1 * s1 - s2 * s2;
+    const int64_t covar = s12 * 64 - s1 * s2;
+    l  = static_cast<double>(2 * s1 * s2 + c1) / static_cast<double>(s1 * s1 + s2 * s2 + c1);
+    cs = static_cast<double>(2 * covar + c2) / static_cast<double>(vars + c2);
+}
+
+// Sums over window rows [y0, y1) of a plane (window row y covers block rows
+// y and y + 1)
+struct WindowSums { double ssim = 0, cs = 0; int64_t count = 0; };
+
+WindowSums ssim_rows(const uint8_t* a, int aStride, const uint8_t* b, int bStride,
+                     int width, int y0, int y1) {
+    WindowSums res;
+    const int bw = width / 4;
+    if (bw < 2 || y0 >= y1) return res;
+    const Kernels& k = kernels();
+    // Two rows of block sums: windows are 2x2 blocks, overlapping by one
+    std::vector<BlockSums> rows(2 * static_cast<size_t>(bw));
+    BlockSums* prev = rows.data();
+    BlockSums* cur  = rows.data() + bw;
+    k.block_row(a + 4 * y0 * aStride, aStride, b + 4 * y0 * bStride, bStride, prev, bw);
+    for (int y = y0 + 1; y <= y1; y++) {
+        k.block_row(a + 4 * y * aStride, aStride, b + 4 * y * bStride, bStride, cur, bw);
+        for (int x = 0; x < bw - 1; x++) {
+            double l, cs;
+            window_ssim(prev[x].s1  + prev[x + 1].s1  + cur[x].s1  + cur[x + 1].s1,
+                        prev[x].s2  + prev[x + 1].s2  + cur[x].s2  + cur[x + 1].s2,
+                        prev[x].ss  + prev[x + 1].ss  + cur[x].ss  + cur[x + 1].ss,
+                        prev[x].s12 + prev[x + 1].s12 + cur[x].s12 + cur[x + 1].s12, l, cs);
+            res.ssim += l * cs;
+            res.cs   += cs;
+        }
+        std::swap(prev, cur);
+    }
+    res.count = static_cast<int64_t>(y1 - y0) * (bw - 1);
+    return res;
+}
+
+uint64_t sse_rows(const uint8_t* a, int aStride, const uint8_t* b, int bStride,
+                  int width, int y0, int y1) {
+    const Kernels& k = kernels();
+    uint64_t s = 0;
+    for (int y = y0; y < y1; y++) s += k.sse_row(a + y * aStride, b + y * bStride, width);
+    return s;
+}
+
+double psnr_db(double mse) {
+    return mse > 0 ? 10.0 * std::log10(255.0 * 255.0 / mse)
+                   : std::numeric_limits<double>::infinity();
+}
+
+// ----------------------------------------------------------------------------
+// MS-SSIM (luma): scale 1 contrast-structure comes from the row bands, this
+// does scales 2..5 on 2x2-averaged planes. Fewer scales for small frames,
+// weights renormalized over the scales used.
+// ----------------------------------------------------------------------------
+
+const double MS_WEIGHTS[5] = { 0.0448, 0.2856, 0.3001, 0.2363, 0.1333 };
+
+void downscale2(const uint8_t* src, int stride, int w, int h, std::vector<uint8_t>& dst) {
+    const int dw = w / 2, dh = h / 2;
+    dst.resize(static_cast<size_t>(dw) * dh);
+    for (int y = 0; y < dh; y++) {
+        const uint8_t* r0 = src + 2 * y * stride;
+        const uint8_t* r1 = r0 + stride;
+        uint8_t* out = dst.data() + static_cast<size_t>(y) * dw;
+        for (int x = 0; x < dw; x++)
+            out[x] = static_cast<uint8_t>((r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1] + 2) >> 2);
+    }
+}
+
+int msssim_scales(int w, int h) {
+    int n = 1;
+    while (n < 5 && (w >> n) >= 8 && (h >> n) >= 8) n++;
+    return n;
+}
+
+double msssim_weight(int scale, int scales) {
+    double wsum = 0;
+    for (int i = 0; i < scales; i++) wsum += MS_WEIGHTS[i];
+    return MS_WEIGHTS[scale] / wsum;
+}
+
+// Product over scales 2..n of cs^w, ssim^w for the last one
+double msssim_tail(const uint8_t* a, const uint8_t* b, int w, int h) {
+    const int n = msssim_scales(w, h);
+    double ms = 1.0;
+    std::vector<uint8_t> ca, cb, na, nb;
+    const uint8_t* pa = a;
+    const uint8_t* pb = b;
+    int pw = w, ph = h, stride = w;
+    for (int i = 1; i < n; i++) {
+        downscale2(pa, stride, pw, ph, na);
+        downscale2(pb, stride, pw, ph, nb);
+        ca.swap(na);
+        cb.swap(nb);
+        pa = ca.data();
+        pb = cb.data();
+        pw /= 2;
+        ph /= 2;
+        stride = pw;
+        const WindowSums s = ssim_rows(pa, stride, pb, stride, pw, 0, ph / 4 - 1);
+        const double v = s.count > 0 ? (i == n - 1 ? s.ssim : s.cs) / s.count : 1.0;
+        ms *= std::pow(std::max(0.0, v), msssim_weight(i, n));
+    }
+    return ms;
+}
+
+// ----------------------------------------------------------------------------
+// One frame: each thread scores a band of rows in Y, U and V; MS-SSIM
+// scales 2..5 run on one more thread
+// ----------------------------------------------------------------------------
+
+struct BandSums { WindowSums win[3]; uint64_t sse[3] = { 0, 0, 0 }; };
+
+// `mse` receives the per-plane mean squared error (Y, U, V)
+Av1rFrameScore score_frame(const uint8_t* a, const uint8_t* b, int w, int h,
+                           int threads, bool msssim, double mse[3]) {
+    const int cw = w / 2, ch = h / 2;
+    const size_t luma = static_cast<size_t>(w) * h, chroma = static_cast<size_t>(cw) * ch;
+    const uint8_t* pa[3] = { a, a + luma, a + luma + chroma };
+    const uint8_t* pb[3] = { b, b + luma, b + luma + chroma };
+    const int pw[3] = { w, cw, cw }, ph[3] = { h, ch, ch };
+
+    const int bands = std::max(1, std::min(threads, h / 32));
+    std::vector<BandSums> sums(static_cast<size_t>(bands));
+    auto band = [&](int t) {
+        BandSums& s = sums[static_cast<size_t>(t)];
+        for (int p = 0; p < 3; p++) {
+            const int wr = std::max(0, ph[p] / 4 - 1);   // window rows
+            s.win[p] = ssim_rows(pa[p], pw[p], pb[p], pw[p], pw[p],
+                                 wr * t / bands, wr * (t + 1) / bands);
+            s.sse[p] = sse_rows(pa[p], pw[p], pb[p], pw[p], pw[p],
+                                ph[p] * t / bands, ph[p] * (t + 1) / bands);
+        }
+    };
+
+    // MS-SSIM scales 2..5 need only the frames; scale 1 is combined below
+    double msTail = 1.0;
+    std::vector<std::thread> pool;
+    if (msssim) pool.emplace_back([&]() { msTail = msssim_tail(a, b, w, h); });
+    for (int t = 1; t < bands; t++) pool.emplace_back(band, t);
+    band(0);
+    for (auto& th : pool) th.join();
+
+    Av1rFrameScore f;
+    const double n[3] = { static_cast<double>(luma), static_cast<double>(chroma),
+                          static_cast<double>(chroma) };
+    double sseAll = 0, csY = 0;
+    for (int p = 0; p < 3; p++) {
+        WindowSums win;
+        uint64_t sse = 0;
+        for (const BandSums& s : sums) {
+            win.ssim  += s.win[p].ssim;
+            win.cs    += s.win[p].cs;
+            win.count += s.win[p].count;
+            sse       += s.sse[p];
+        }
+        f.ssim[p] = win.count > 0 ? win.ssim / win.count : 1.0;
+        mse[p]    = static_cast<double>(sse) / n[p];
+        f.psnr[p] = psnr_db(mse[p]);
+        sseAll   += static_cast<double>(sse);
+        if (p == 0) csY = win.count > 0 ? win.cs / win.count : 1.0;
+    }
+    const double total = n[0] + n[1] + n[2];
+    f.ssim[AV1R_METRIC_ALL] = (f.ssim[0] * n[0] + (f.ssim[1] + f.ssim[2]) * n[1]) / total;
+    f.psnr[AV1R_METRIC_ALL] = psnr_db(sseAll / total);
+    f.msssim = std::numeric_limits<double>::quiet_NaN();
+    if (msssim) {
+        const int scales = msssim_scales(w, h);
+        f.msssim = scales == 1 ? f.ssim[0]
+                               : msTail * std::pow(std::max(0.0, csY), msssim_weight(0, scales));
+    }
+    return f;
+}
+
+// libav, else the ffmpeg pipe (as the Vulkan and SVT-AV1 encode loops do)
+std::unique_ptr<Av1rFrameSource> open_source(const Av1rMetricsConfig& cfg, const std::string& input) {
+    Av1rDecodeConfig d;
+    d.input     = input;
+    d.width     = cfg.width;
+    d.height    = cfg.height;
+    d.fps       = cfg.fps;
+    d.maxFrames = cfg.maxFrames;
+    d.format    = AV1R_PIX_I420;
+    std::unique_ptr<Av1rFrameSource> src;
+    try {
+        src = av1r_libav_source(d);
+    } catch (const std::exception&) {
+        src.reset();
+    }
+    if (!src) src = av1r_pipe_source(d);
+    return src;
+}
+
+} // namespace
+
+double av1r_ssim_plane(const uint8_t* a, int aStride, const uint8_t* b, int bStride,
+                       int width, int height) {
+    const int bw = width / 4, bh = height / 4;
+    if (bw < 2 || bh < 2) return 1.0;
+    const WindowSums s = ssim_rows(a, aStride, b, bStride, width, 0, bh - 1);
+    return s.ssim / s.count;
+}
+
+const char* av1r_metrics_kernel() { return kernels().name; }
+
+// ============================================================================
+// YUV4MPEG2 reader
+// ============================================================================
+
+Av1rY4mReader::~Av1rY4mReader() {
+    if (f_) std::fclose(f_);
+}
+
+void Av1rY4mReader::open(const std::string& path) {
+    f_ = std::fopen(path.c_str(), "rb");
+    if (!f_) throw std::runtime_error("cannot open " + path);
+    std::string header;
+    for (int c; (c = std::fgetc(f_)) != EOF && c != '\n';) header += static_cast<char>(c);
+    if (header.compare(0, 10, "YUV4MPEG2 ") != 0)
+        throw std::runtime_error(path + ": not a YUV4MPEG2 file");
+    // Space-separated tags: W<width> H<height> C<colorspace> ...
+    size_t pos = 9;
+    while (pos < header.size()) {
+        const size_t end = header.find(' ', pos + 1);
+        const std::string tag = header.substr(pos + 1, end == std::string::npos
+                                                       ? std::string::npos : end - pos - 1);
+        if (!tag.empty() && tag[0] == 'W') width_  = std::atoi(tag.c_str() + 1);
+        if (!tag.empty() && tag[0] == 'H') height_ = std::atoi(tag.c_str() + 1);
+        if (!tag.empty() && tag[0] == 'C' && tag.compare(0, 4, "C420") != 0)
+            throw std::runtime_error(path + ": " + tag + " is not 8-bit 4:2:0");
+        if (end == std::string::npos) break;
+        pos = end;
+    }
+    if (width_ <= 0 || height_ <= 0) throw std::runtime_error(path + ": no frame size");
+}
+
+size_t Av1rY4mReader::frame_bytes() const {
+    const size_t cw = (width_ + 1) / 2, ch = (height_ + 1) / 2;
+    return static_cast<size_t>(width_) * height_ + 2 * cw * ch;
+}
+
+bool Av1rY4mReader::read(std::vector<uint8_t>& i420) {
+    // "FRAME" plus optional parameters up to the newline
+    char tag[5];
+    if (std::fread(tag, 1, 5, f_) != 5 || std::memcmp(tag, "FRAME", 5) != 0) return false;
+    for (int c; (c = std::fgetc(f_)) != '\n';) if (c == EOF) return false;
+    i420.resize(frame_bytes());
+    return std::fread(i420.data(), 1, i420.size(), f_) == i420.size();
+}
+
+// ============================================================================
+// SSIM of two Y4M files
+// ============================================================================
+
+Av1rSsimResult av1r_ssim_y4m(const std::string& ref, const std::string& dist) {
+    AV1R_TRACE_SPAN("ssim", "metrics");
+    Av1rY4mReader ra, rb;
+    ra.open(ref);
+    rb.open(dist);
+    if (ra.width() != rb.width() || ra.height() != rb.height())
+        throw std::runtime_error("frame size differs: " + std::to_string(ra.width()) + "x" +
+                                 std::to_string(ra.height()) + " vs " +
+                                 std::to_string(rb.width()) + "x" + std::to_string(rb.height()));
+    const int w = ra.width(), h = ra.height();
+    const int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    const size_t luma = static_cast<size_t>(w) * h, chroma = static_cast<size_t>(cw) * ch;
+    const double total = static_cast<double>(luma + 2 * chroma);
+
+    Av1rSsimResult res;
+    std::vector<uint8_t> fa, fb;
+    while (ra.read(fa) && rb.read(fb)) {
+        const double y = av1r_ssim_plane(fa.data(), w, fb.data(), w, w, h);
+        const double u = av1r_ssim_plane(fa.data() + luma, cw, fb.data() + luma, cw, cw, ch);
+        const double v = av1r_ssim_plane(fa.data() + luma + chroma, cw,
+                                         fb.data() + luma + chroma, cw, cw, ch);
+        res.y += y;
+        res.u += u;
+        res.v += v;
+        res.all += (y * luma + (u + v) * chroma) / total;
+        res.frames++;
+    }
+    if (res.frames > 0) {
+        res.y   /= res.frames;
+        res.u   /= res.frames;
+        res.v   /= res.frames;
+        res.all /= res.frames;
+    }
+    return res;
+}
+
+// ============================================================================
+// Two videos: decode both (ahead, on a second thread) and score every
+// stride-th frame
+// ============================================================================
+
+Av1rMetricsResult av1r_measure(const Av1rMetricsConfig& cfg, const Av1rMetricsProgress& progress) {
+    AV1R_TRACE_SPAN("measure", "metrics");
+    if (cfg.width < 8 || cfg.height < 8 || (cfg.width & 1) || (cfg.height & 1))
+        throw std::runtime_error("invalid frame size " + std::to_string(cfg.width) + "x" +
+                                 std::to_string(cfg.height));
+    std::unique_ptr<Av1rFrameSource> ref  = open_source(cfg, cfg.ref);
+    std::unique_ptr<Av1rFrameSource> dist = open_source(cfg, cfg.dist);
+
+    int threads = cfg.threads > 0 ? cfg.threads
+                                  : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, 16));
+    const int stride = std::max(1, cfg.stride);
+    const size_t bytes = av1r_pix_fmt_frame_bytes(AV1R_PIX_I420, cfg.width, cfg.height);
+
+    // Double buffer: frame n is scored while n + 1 is decoded
+    std::vector<uint8_t> bufA[2] = { std::vector<uint8_t>(bytes), std::vector<uint8_t>(bytes) };
+    std::vector<uint8_t> bufB[2] = { std::vector<uint8_t>(bytes), std::vector<uint8_t>(bytes) };
+    auto fetch = [&](int slot) {
+        bool okA = false;
+        std::thread t([&]() { okA = ref->read(bufA[slot].data()); });
+        const bool okB = dist->read(bufB[slot].data());
+        t.join();
+        return okA && okB;
+    };
+
+    Av1rMetricsResult res;
+    res.decoder = ref->name();
+    double mse[4] = { 0, 0, 0, 0 };
+    const double n[3] = { static_cast<double>(cfg.width) * cfg.height,
+                          static_cast<double>(cfg.width / 2) * (cfg.height / 2),
+                          static_cast<double>(cfg.width / 2) * (cfg.height / 2) };
+    bool stopped = false;
+    int slot = 0;
+    bool have = fetch(slot);
+    while (have) {
+        bool haveNext = false;
+        std::thread ahead([&, slot]() { haveNext = fetch(slot ^ 1); });
+        if (res.decoded % stride == 0) {
+            double fmse[3];
+            Av1rFrameScore f = score_frame(bufA[slot].data(), bufB[slot].data(),
+                                           cfg.width, cfg.height, threads, cfg.msssim, fmse);
+            f.index = res.decoded;
+            for (int p = 0; p < 3; p++) {
+                res.ssim[p] += f.ssim[p];
+                mse[p]      += fmse[p];
+            }
+            res.ssim[AV1R_METRIC_ALL] += f.ssim[AV1R_METRIC_ALL];
+            if (cfg.msssim) res.msssim += f.msssim;
+            res.frames.push_back(f);
+        }
+        res.decoded++;
+        ahead.join();
+        if (progress && !progress(res.decoded)) {
+            stopped = true;
+            break;
+        }
+        have = haveNext;
+        slot ^= 1;
+    }
+    if (stopped) throw std::runtime_error("interrupted");
+    const std::string err = !ref->error().empty() ? ref->error() : dist->error();
+    if (!err.empty()) throw std::runtime_error(err);
+    if (res.frames.empty()) throw std::runtime_error("no frames decoded");
+
+    const double k = static_cast<double>(res.frames.size());
+    for (int p = 0; p < 4; p++) res.ssim[p] /= k;
+    for (int p = 0; p < 3; p++) {
+        mse[p] /= k;
+        res.psnr[p] = psnr_db(mse[p]);
+    }
+    mse[AV1R_METRIC_ALL] = (mse[0] * n[0] + (mse[1] + mse[2]) * n[1]) / (n[0] + n[1] + n[2]);
+    res.psnr[AV1R_METRIC_ALL] = psnr_db(mse[AV1R_METRIC_ALL]);
+    res.msssim = cfg.msssim ? res.msssim / k : std::numeric_limits<double>::quiet_NaN();
+    return res;
+}
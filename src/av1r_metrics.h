@@ -0,0 +1,105 @@
+// Native quality metrics for AV1R: SSIM between two 8-bit I420 streams,
+// computed as ffmpeg's ssim filter does (4x4 block sums, 8x8 windows with
+// a step of 4, planes weighted by their sample count for "All"), so the
+// numbers match the `-lavfi ssim` values the QP search was tuned on.
+// PSNR as ffmpeg's psnr filter (peak 255, "All" from the pooled MSE) and
+// optionally luma MS-SSIM (5 scales, Wang et al. weights).
+//
+// Used by the quality probe (R/quality.R): the sampled source segments
+// are decoded once to Y4M and every candidate encode is compared to them
+// without another ffmpeg SSIM pass. measure_quality() / measure_ssim()
+// decode both videos through the frame sources (av1r_decode.h) and score
+// the frames here, split into row bands across threads; the block sums
+// use AVX2 when the CPU has it.
+
+#ifndef AV1R_METRICS_H
+#define AV1R_METRICS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// SSIM of one 8-bit plane (mean over the 8x8 windows); 1.0 for planes
+// smaller than 8x8
+double av1r_ssim_plane(const uint8_t* a, int aStride, const uint8_t* b, int bStride,
+                       int width, int height);
+
+// Reader of 8-bit 4:2:0 YUV4MPEG2 files (ffmpeg -f yuv4mpegpipe)
+class Av1rY4mReader {
+public:
+    Av1rY4mReader() = default;
+    ~Av1rY4mReader();
+    Av1rY4mReader(const Av1rY4mReader&) = delete;
+    Av1rY4mReader& operator=(const Av1rY4mReader&) = delete;
+
+    // Throws std::runtime_error for unreadable files and other layouts
+    void open(const std::string& path);
+    // Next frame into `i420` (resized to frame_bytes()); false at the end
+    bool read(std::vector<uint8_t>& i420);
+    int width()  const { return width_; }
+    int height() const { return height_; }
+    size_t frame_bytes() const;
+private:
+    FILE* f_ = nullptr;
+    int width_ = 0, height_ = 0;
+};
+
+struct Av1rSsimResult {
+    double all = 0.0, y = 0.0, u = 0.0, v = 0.0;   // means over the frames
+    int    frames = 0;
+};
+
+// SSIM of `dist` against `ref`, frame by frame over the shorter stream.
+// Throws if a file cannot be read or the frame sizes differ.
+Av1rSsimResult av1r_ssim_y4m(const std::string& ref, const std::string& dist);
+
+// ============================================================================
+// Full-stream metrics: two videos decoded in-process (or ffmpeg pipe)
+// ============================================================================
+
+struct Av1rMetricsConfig {
+    std::string ref, dist;         // files or printf patterns
+    int  width     = 0;            // even; both streams decoded (scaled) to it
+    int  height    = 0;
+    int  fps       = 25;           // frame rate of image sequences
+    int  maxFrames = 0;            // 0 = all
+    int  stride    = 1;            // score every stride-th frame
+    int  threads   = 0;            // row bands, 0 = all cores
+    bool msssim    = false;        // luma MS-SSIM per frame
+};
+
+// Planes in score arrays: Y, U, V, All
+enum { AV1R_METRIC_Y = 0, AV1R_METRIC_U, AV1R_METRIC_V, AV1R_METRIC_ALL };
+
+struct Av1rFrameScore {
+    int    index = 0;              // 0-based frame number
+    double ssim[4] = { 0, 0, 0, 0 };
+    double psnr[4] = { 0, 0, 0, 0 };   // dB, +Inf for identical planes
+    double msssim  = 0;            // NaN unless requested
+};
+
+struct Av1rMetricsResult {
+    std::vector<Av1rFrameScore> frames;   // scored frames only
+    double ssim[4] = { 0, 0, 0, 0 };      // means over the scored frames
+    double psnr[4] = { 0, 0, 0, 0 };      // from the mean MSE
+    double msssim  = 0;
+    int    decoded = 0;                   // frames read from both streams
+    std::string decoder;                  // "libav" or "pipe" (reference)
+};
+
+// Called on the calling thread after every decoded frame with the count so
+// far; returning false stops the measurement (interrupt)
+typedef std::function<bool(int)> Av1rMetricsProgress;
+
+// Scores `dist` against `ref` over the shorter stream. Throws
+// std::runtime_error when an input cannot be opened or decoded, or when
+// `progress` stopped it ("interrupted").
+Av1rMetricsResult av1r_measure(const Av1rMetricsConfig& cfg,
+                               const Av1rMetricsProgress& progress = Av1rMetricsProgress());
+
+// Block-sum kernel in use: "avx2" or "scalar"
+const char* av1r_metrics_kernel();
+
+#endif
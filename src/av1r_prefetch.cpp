@@ -0,0 +1,138 @@
+// Фоновая подгрузка входных файлов пакета в page cache (см. av1r_prefetch.h).
+
+#include "av1r_prefetch.h"
+#include "av1r_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#endif
+
+namespace {
+
+const size_t CHUNK = 1u << 20;
+
+uint64_t file_size(FILE* f) {
+#ifdef _WIN32
+    if (_fseeki64(f, 0, SEEK_END) != 0) return 0;
+    const int64_t n = _ftelli64(f);
+    _fseeki64(f, 0, SEEK_SET);
+#else
+    if (fseeko(f, 0, SEEK_END) != 0) return 0;
+    const int64_t n = static_cast<int64_t>(ftello(f));
+    fseeko(f, 0, SEEK_SET);
+#endif
+    return n > 0 ? static_cast<uint64_t>(n) : 0;
+}
+
+} // namespace
+
+Av1rPrefetcher::Av1rPrefetcher(const std::vector<std::string>& paths, int depthHead,
+                               int depthTail, uint64_t budget)
+    : paths_(paths), held_(paths.size(), 0), opened_(paths.size(), 0),
+      depthHead_(static_cast<size_t>(std::max(depthHead, 0))),
+      depthTail_(static_cast<size_t>(std::max(depthTail, 0))), budget_(budget) {
+    if (depthHead_ + depthTail_ == 0) depthHead_ = 1;
+    thread_ = std::thread(&Av1rPrefetcher::run, this);
+}
+
+Av1rPrefetcher::~Av1rPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void Av1rPrefetcher::opened(size_t i, bool tail) {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (i >= opened_.size() || opened_[i]) return;
+        opened_[i] = 1;
+        (tail ? nTail_ : nHead_)++;
+        outstanding_ -= held_[i];
+        held_[i] = 0;
+    }
+    cv_.notify_all();
+}
+
+bool Av1rPrefetcher::cancelled(size_t i) {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stop_ || opened_[i];
+}
+
+void Av1rPrefetcher::run() {
+    const uint32_t track = av1r_trace_on() ? av1r_trace_track("prefetch") : 0;
+    std::vector<char> buf(CHUNK);
+    // files [head, tail) are not visited yet
+    size_t head = 0, tail = paths_.size();
+    bool fromTail = true;
+    while (head < tail) {
+        size_t i;
+        {   // the next files of whichever window has room
+            std::unique_lock<std::mutex> lk(mu_);
+            const auto headDue = [&] {
+                return opened_[head] || head < nHead_ + depthHead_;
+            };
+            const auto tailDue = [&] {
+                return opened_[tail - 1] ||
+                       (depthTail_ > 0 && paths_.size() - tail < nTail_ + depthTail_);
+            };
+            cv_.wait(lk, [&] { return stop_ || headDue() || tailDue(); });
+            if (stop_) return;
+            const bool h = headDue(), t = tailDue();
+            fromTail = h && t ? !fromTail : t;
+            i = fromTail ? --tail : head++;
+            if (opened_[i]) continue;
+        }
+        fetch(i, buf, track);
+    }
+}
+
+// Reads file i into the page cache unless it is opened first
+void Av1rPrefetcher::fetch(size_t i, std::vector<char>& buf, uint32_t track) {
+    FILE* f = std::fopen(paths_[i].c_str(), "rb");
+    if (!f) return;
+    const uint64_t want = std::min(file_size(f), budget_);
+    {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [&] { return stop_ || opened_[i] || outstanding_ + want <= budget_; });
+        if (stop_ || opened_[i]) {
+            lk.unlock();
+            std::fclose(f);
+            return;
+        }
+        outstanding_ += want;
+        held_[i] = want;
+    }
+    Av1rTraceSpan span("prefetch", "io", track);
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(fileno(f), 0, static_cast<off_t>(want), POSIX_FADV_WILLNEED);
+#endif
+    uint64_t done = 0;
+    while (done < want && !cancelled(i)) {
+        const size_t n = std::fread(buf.data(), 1,
+                                    static_cast<size_t>(std::min<uint64_t>(CHUNK, want - done)), f);
+        if (n == 0) break;
+        done += n;
+    }
+    std::fclose(f);
+    files_++;
+    bytes_ += done;
+}
+
+double av1r_first_byte_sec(const std::string& path, size_t bytes) {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point t0 = Clock::now();
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return -1.0;
+    std::vector<char> buf(bytes);
+    const size_t n = std::fread(buf.data(), 1, bytes, f);
+    std::fclose(f);
+    if (n == 0 && bytes > 0) return -1.0;
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
@@ -0,0 +1,69 @@
+// Read-ahead of upcoming batch inputs (convert_folder(prefetch =)).
+//
+// Inputs on network storage have a high first-byte latency, and each
+// encode would otherwise pay it when its file comes up. A background
+// thread walks the batch order and pulls the next `depth` files into the
+// page cache: posix_fadvise(WILLNEED) where available, then a plain
+// sequential read, which is what actually fetches the data on NFS/SMB/FUSE
+// mounts. Bytes prefetched for files the encoder has not opened yet stay
+// under `budget`; a file larger than the budget gets only its head.
+//
+// A hybrid batch is consumed from both ends (Av1rJobPool: the first worker
+// class from the front, the others from the back), so there are two
+// windows: `depthHead` files after the last one opened from the front and
+// `depthTail` before the last one opened from the back. When both have
+// room the thread alternates between them.
+
+#ifndef AV1R_PREFETCH_H
+#define AV1R_PREFETCH_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Av1rPrefetcher {
+public:
+    // `paths` in the order the batch opens them from the front
+    Av1rPrefetcher(const std::vector<std::string>& paths, int depthHead, int depthTail,
+                   uint64_t budget);
+    ~Av1rPrefetcher();
+    Av1rPrefetcher(const Av1rPrefetcher&) = delete;
+    Av1rPrefetcher& operator=(const Av1rPrefetcher&) = delete;
+
+    // File i (0-based) was opened by an encoder taking jobs from the front
+    // (or the back, `tail`): its bytes leave the budget and that window
+    // moves on; an unfinished prefetch of it stops
+    void opened(size_t i, bool tail = false);
+    int      files() const { return files_.load(); }   // prefetched so far
+    uint64_t bytes() const { return bytes_.load(); }
+private:
+    void run();
+    bool cancelled(size_t i);
+    void fetch(size_t i, std::vector<char>& buf, uint32_t track);
+
+    std::vector<std::string> paths_;
+    std::vector<uint64_t>    held_;      // prefetched, not yet opened
+    std::vector<char>        opened_;
+    size_t   nHead_       = 0;   // opened from the front / the back
+    size_t   nTail_       = 0;
+    size_t   depthHead_;
+    size_t   depthTail_;
+    uint64_t budget_;
+    uint64_t outstanding_ = 0;
+    bool     stop_        = false;
+    std::mutex              mu_;
+    std::condition_variable cv_;
+    std::atomic<int>        files_{0};
+    std::atomic<uint64_t>   bytes_{0};
+    std::thread             thread_;
+};
+
+// Seconds to open `path` and read its first `bytes` bytes: the wait an
+// encoder has before its first frame; -1 if the file cannot be read
+double av1r_first_byte_sec(const std::string& path, size_t bytes = 65536);
+
+#endif
@@ -0,0 +1,836 @@
+// Native container probe (см. av1r_probe.h).
+// Читаются только заголовки: для MP4 — таблицы сэмплов moov, для MKV —
+// элементы до первого Cluster плюс то, на что указывает SeekHead, для AVI —
+// hdrl и idx1, для TIFF — цепочка IFD.
+
+#include "av1r_probe.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+// ============================================================================
+// File access and byte order
+// ============================================================================
+
+class ProbeFile {
+public:
+    explicit ProbeFile(const char* path) : f_(std::fopen(path, "rb")) {
+        if (f_ && seek(0, SEEK_END)) {
+#ifdef _WIN32
+            const int64_t n = _ftelli64(f_);
+#else
+            const int64_t n = static_cast<int64_t>(ftello(f_));
+#endif
+            size_ = n > 0 ? static_cast<uint64_t>(n) : 0;
+        }
+    }
+    ~ProbeFile() { if (f_) std::fclose(f_); }
+    ProbeFile(const ProbeFile&) = delete;
+    ProbeFile& operator=(const ProbeFile&) = delete;
+
+    uint64_t size() const { return size_; }
+
+    bool read(uint64_t off, void* buf, size_t n) {
+        if (!f_ || off > size_ || n > size_ - off) return false;
+        return seek(static_cast<int64_t>(off), SEEK_SET) && std::fread(buf, 1, n, f_) == n;
+    }
+    // Up to `n` bytes at `off` (fewer at the end of the file)
+    std::vector<uint8_t> bytes(uint64_t off, uint64_t n) {
+        if (off >= size_) return std::vector<uint8_t>();
+        std::vector<uint8_t> b(static_cast<size_t>(std::min(n, size_ - off)));
+        if (!b.empty() && !read(off, b.data(), b.size())) b.clear();
+        return b;
+    }
+private:
+    bool seek(int64_t off, int whence) {
+#ifdef _WIN32
+        return _fseeki64(f_, off, whence) == 0;
+#else
+        return fseeko(f_, static_cast<off_t>(off), whence) == 0;
+#endif
+    }
+
+    FILE*    f_;
+    uint64_t size_ = 0;
+};
+
+// Sample tables and indexes are read whole; larger ones are not plausible
+const uint64_t MAX_TABLE = 256u << 20;
+
+inline uint32_t be16(const uint8_t* p) { return (uint32_t(p[0]) << 8) | p[1]; }
+inline uint32_t be32(const uint8_t* p) { return (be16(p) << 16) | be16(p + 2); }
+inline uint64_t be64(const uint8_t* p) { return (uint64_t(be32(p)) << 32) | be32(p + 4); }
+inline uint32_t le16(const uint8_t* p) { return (uint32_t(p[1]) << 8) | p[0]; }
+inline uint32_t le32(const uint8_t* p) { return (le16(p + 2) << 16) | le16(p); }
+inline uint64_t le64(const uint8_t* p) { return (uint64_t(le32(p + 4)) << 32) | le32(p); }
+
+constexpr uint32_t fourcc(const char* s) {
+    return (uint32_t(uint8_t(s[0])) << 24) | (uint32_t(uint8_t(s[1])) << 16) |
+           (uint32_t(uint8_t(s[2])) << 8)  |  uint32_t(uint8_t(s[3]));
+}
+
+int64_t gcd64(int64_t a, int64_t b) {
+    while (b != 0) { const int64_t t = a % b; a = b; b = t; }
+    return a < 0 ? -a : a;
+}
+
+void set_rate(Av1rProbeInfo& info, int64_t num, int64_t den) {
+    if (num <= 0 || den <= 0) return;
+    const int64_t g = gcd64(num, den);
+    info.fpsNum = num / g;
+    info.fpsDen = den / g;
+}
+
+// Rate from a frame duration in seconds (Matroska DefaultDuration is in
+// whole nanoseconds): snaps to n/1 and NTSC n*1000/1001, as ffprobe does
+void set_rate_from_period(Av1rProbeInfo& info, double sec) {
+    if (!(sec > 0)) return;
+    const double f = 1.0 / sec;
+    const double n = std::round(f);
+    if (n > 0 && std::fabs(f - n) < 1e-5 * f) return set_rate(info, int64_t(n), 1);
+    const double m = std::round(f * 1.001);
+    if (m > 0 && std::fabs(f - m * 1000.0 / 1001.0) < 1e-5 * f)
+        return set_rate(info, int64_t(m) * 1000, 1001);
+    set_rate(info, int64_t(std::llround(f * 1000.0)), 1000);
+}
+
+// "yuv420p", "yuv420p10le", "gray12le", ... (chroma: 0 = 4:0:0 .. 3 = 4:4:4)
+std::string yuv_pix_fmt(int chroma, int depth) {
+    static const char* base[] = { "gray", "yuv420p", "yuv422p", "yuv444p" };
+    if (chroma < 0 || chroma > 3 || depth < 8 || depth > 16) return "";
+    std::string s = base[chroma];
+    if (depth > 8) s += std::to_string(depth) + "le";
+    return s;
+}
+
+// ============================================================================
+// Codec configuration records -> pix_fmt
+// ============================================================================
+
+class BitReader {
+public:
+    BitReader(const uint8_t* p, size_t n) : p_(p), n_(n) {}
+    bool ok() const { return ok_; }
+    uint32_t bit() {
+        if (pos_ >= n_ * 8) { ok_ = false; return 0; }
+        const uint32_t b = (p_[pos_ >> 3] >> (7 - (pos_ & 7))) & 1u;
+        pos_++;
+        return b;
+    }
+    uint32_t bits(int k) { uint32_t v = 0; while (k-- > 0) v = (v << 1) | bit(); return v; }
+    uint32_t ue() {
+        int zeros = 0;
+        while (ok_ && bit() == 0) if (++zeros > 31) { ok_ = false; return 0; }
+        return ((1u << zeros) - 1u) + bits(zeros);
+    }
+private:
+    const uint8_t* p_;
+    size_t n_;
+    size_t pos_ = 0;
+    bool   ok_  = true;
+};
+
+// H.264 SPS (after the NAL header byte): chroma_format_idc and bit depth,
+// present only in the high profiles
+std::string h264_sps_pix_fmt(const uint8_t* nal, size_t n) {
+    std::vector<uint8_t> rbsp;
+    rbsp.reserve(n);
+    for (size_t i = 1; i < n; i++) {   // снять emulation prevention (00 00 03)
+        if (nal[i] == 3 && rbsp.size() >= 2 && rbsp[rbsp.size() - 1] == 0 && rbsp[rbsp.size() - 2] == 0)
+            continue;
+        rbsp.push_back(nal[i]);
+    }
+    BitReader br(rbsp.data(), rbsp.size());
+    const uint32_t profile = br.bits(8);
+    br.bits(16);               // constraint flags, level_idc
+    br.ue();                   // seq_parameter_set_id
+    int chroma = 1, depth = 8;
+    static const uint32_t high[] = { 100, 110, 122, 244, 44, 83, 86, 118, 128, 138, 139, 134, 135 };
+    if (std::find(std::begin(high), std::end(high), profile) != std::end(high)) {
+        chroma = static_cast<int>(br.ue());
+        if (chroma == 3) br.bit();   // separate_colour_plane_flag
+        depth = 8 + static_cast<int>(br.ue());
+    }
+    return br.ok() ? yuv_pix_fmt(chroma, depth) : std::string();
+}
+
+// avcC: ..., numOfSequenceParameterSets (low 5 bits), spsLength, SPS
+std::string avcc_pix_fmt(const uint8_t* p, size_t n) {
+    if (n < 8 || (p[5] & 0x1f) == 0) return "";
+    const size_t len = be16(p + 6);
+    if (len < 4 || 8 + len > n) return "";
+    return h264_sps_pix_fmt(p + 8, len);
+}
+
+// hvcC: chromaFormat at byte 16, bitDepthLumaMinus8 at byte 17
+std::string hvcc_pix_fmt(const uint8_t* p, size_t n) {
+    if (n < 23) return "";
+    return yuv_pix_fmt(p[16] & 3, 8 + (p[17] & 7));
+}
+
+// av1C: high_bitdepth, twelve_bit, monochrome, chroma_subsampling_x/y
+std::string av1c_pix_fmt(const uint8_t* p, size_t n) {
+    if (n < 4) return "";
+    const int depth = (p[2] & 0x40) ? ((p[2] & 0x20) ? 12 : 10) : 8;
+    if (p[2] & 0x10) return yuv_pix_fmt(0, depth);
+    const bool sx = (p[2] & 0x08) != 0, sy = (p[2] & 0x04) != 0;
+    return yuv_pix_fmt(sx && sy ? 1 : sx ? 2 : 3, depth);
+}
+
+// ============================================================================
+// MP4 / MOV (ISO BMFF)
+// ============================================================================
+
+struct Box {
+    uint64_t off  = 0;   // box start
+    uint64_t data = 0;   // payload start
+    uint64_t end  = 0;
+    uint32_t type = 0;
+};
+
+bool box_at(ProbeFile& f, uint64_t off, uint64_t end, Box& b) {
+    uint8_t h[16];
+    if (end < 8 || off > end - 8 || !f.read(off, h, 8)) return false;
+    uint64_t size = be32(h), hdr = 8;
+    if (size == 1) {
+        if (off > end - 16 || !f.read(off + 8, h + 8, 8)) return false;
+        size = be64(h + 8);
+        hdr = 16;
+    } else if (size == 0) {
+        size = end - off;   // до конца файла/родителя
+    }
+    if (size < hdr || size > end - off) return false;
+    b.off = off; b.data = off + hdr; b.end = off + size; b.type = be32(h + 4);
+    return true;
+}
+
+bool find_box(ProbeFile& f, uint64_t off, uint64_t end, uint32_t type, Box& out) {
+    Box b;
+    while (box_at(f, off, end, b)) {
+        if (b.type == type) { out = b; return true; }
+        off = b.end;
+    }
+    return false;
+}
+
+bool find_path(ProbeFile& f, const Box& parent, std::initializer_list<const char*> path, Box& out) {
+    Box cur = parent;
+    for (const char* t : path)
+        if (!find_box(f, cur.data, cur.end, fourcc(t), cur)) return false;
+    out = cur;
+    return true;
+}
+
+const char* mov_codec(uint32_t fmt) {
+    switch (fmt) {
+    case fourcc("avc1"): case fourcc("avc3"): return "h264";
+    case fourcc("hvc1"): case fourcc("hev1"): return "hevc";
+    case fourcc("av01"): return "av1";
+    case fourcc("vp09"): return "vp9";
+    case fourcc("vp08"): return "vp8";
+    case fourcc("mp4v"): return "mpeg4";
+    case fourcc("jpeg"): case fourcc("mjpa"): case fourcc("mjpb"): return "mjpeg";
+    case fourcc("apch"): case fourcc("apcn"): case fourcc("apcs"): case fourcc("apco"):
+    case fourcc("ap4h"): case fourcc("ap4x"): return "prores";
+    case fourcc("raw "): return "rawvideo";
+    case fourcc("png "): return "png";
+    case fourcc("FFV1"): return "ffv1";
+    default: return nullptr;
+    }
+}
+
+bool probe_mov(ProbeFile& f, Av1rProbeInfo& info) {
+    Box top;
+    if (!box_at(f, 0, f.size(), top)) return false;
+    static const uint32_t first[] = { fourcc("ftyp"), fourcc("moov"), fourcc("mdat"),
+                                      fourcc("wide"), fourcc("free"), fourcc("skip") };
+    if (std::find(std::begin(first), std::end(first), top.type) == std::end(first)) return false;
+    info.container = "mov";
+
+    Box moov;
+    if (!find_box(f, 0, f.size(), fourcc("moov"), moov)) return true;   // MP4, но без moov
+
+    for (uint64_t off = moov.data; ; ) {
+        Box trak;
+        if (!box_at(f, off, moov.end, trak)) break;
+        off = trak.end;
+        if (trak.type != fourcc("trak")) continue;
+
+        Box hdlr, mdhd, stbl, stsd;
+        if (!find_path(f, trak, { "mdia", "hdlr" }, hdlr)) continue;
+        uint8_t h[12];
+        if (!f.read(hdlr.data, h, 12) || be32(h + 8) != fourcc("vide")) continue;
+        if (!find_path(f, trak, { "mdia", "mdhd" }, mdhd) ||
+            !find_path(f, trak, { "mdia", "minf", "stbl" }, stbl) ||
+            !find_box(f, stbl.data, stbl.end, fourcc("stsd"), stsd)) continue;
+
+        // mdhd: version 0 — 32-битные времена, version 1 — 64-битные
+        const std::vector<uint8_t> md = f.bytes(mdhd.data, 32);
+        if (md.size() < 24) continue;
+        const bool v1 = md[0] == 1;
+        if (v1 && md.size() < 32) continue;
+        const uint32_t timescale = v1 ? be32(&md[20]) : be32(&md[12]);
+        const uint64_t mdDuration = v1 ? be64(&md[24]) : be32(&md[16]);
+
+        // First sample entry: VisualSampleEntry, child boxes after 78 bytes
+        const std::vector<uint8_t> sd = f.bytes(stsd.data, std::min<uint64_t>(stsd.end - stsd.data, 1u << 16));
+        if (sd.size() < 8 + 8 + 78 || be32(&sd[4]) == 0) continue;
+        const uint8_t* e = &sd[8];
+        const size_t esize = std::min<size_t>(be32(e), sd.size() - 8);
+        if (esize < 8 + 78) continue;
+        const uint32_t fmt = be32(e + 4);
+        info.width  = static_cast<int>(be16(e + 32));
+        info.height = static_cast<int>(be16(e + 34));
+        const char* codec = mov_codec(fmt);
+        if (codec) {
+            info.codec = codec;
+        } else {
+            const char cc[5] = { char(e[4]), char(e[5]), char(e[6]), char(e[7]), 0 };
+            info.codec = cc;
+        }
+        for (size_t c = 86; c + 8 <= esize; ) {
+            const size_t csize = be32(e + c);
+            if (csize < 8 || c + csize > esize) break;
+            const uint32_t ctype = be32(e + c + 4);
+            if (ctype == fourcc("avcC"))      info.pixFmt = avcc_pix_fmt(e + c + 8, csize - 8);
+            else if (ctype == fourcc("hvcC")) info.pixFmt = hvcc_pix_fmt(e + c + 8, csize - 8);
+            else if (ctype == fourcc("av1C")) info.pixFmt = av1c_pix_fmt(e + c + 8, csize - 8);
+            c += csize;
+        }
+
+        // stts: (sample_count, sample_delta) runs; rate from the longest run
+        Box stts;
+        uint64_t ticks = 0;
+        if (find_box(f, stbl.data, stbl.end, fourcc("stts"), stts) &&
+            stts.end - stts.data <= MAX_TABLE) {
+            const std::vector<uint8_t> t = f.bytes(stts.data, stts.end - stts.data);
+            if (t.size() >= 8) {
+                const uint64_t n = std::min<uint64_t>(be32(&t[4]), (t.size() - 8) / 8);
+                uint64_t frames = 0, best = 0, delta = 0;
+                for (uint64_t i = 0; i < n; i++) {
+                    const uint32_t cnt = be32(&t[8 + i * 8]), d = be32(&t[12 + i * 8]);
+                    frames += cnt;
+                    ticks  += uint64_t(cnt) * d;
+                    if (cnt > best && d > 0) { best = cnt; delta = d; }
+                }
+                if (frames > 0) info.frames = static_cast<int64_t>(frames);
+                if (delta > 0) set_rate(info, timescale, static_cast<int64_t>(delta));
+            }
+        }
+        const uint64_t duration = mdDuration > 0 ? mdDuration : ticks;
+        if (timescale > 0 && duration > 0)
+            info.durationUs = static_cast<int64_t>(double(duration) * 1e6 / timescale);
+
+        // stsz: total stream bytes -> average bitrate, as ffprobe reports it
+        Box stsz;
+        if (info.durationUs > 0 && find_box(f, stbl.data, stbl.end, fourcc("stsz"), stsz) &&
+            stsz.end - stsz.data <= MAX_TABLE) {
+            const std::vector<uint8_t> s = f.bytes(stsz.data, stsz.end - stsz.data);
+            if (s.size() >= 12) {
+                const uint64_t fixed = be32(&s[4]), n = be32(&s[8]);
+                uint64_t total = fixed * n;
+                if (fixed == 0)
+                    for (uint64_t i = 0; i < n && 12 + i * 4 + 4 <= s.size(); i++)
+                        total += be32(&s[12 + i * 4]);
+                if (total > 0) info.bitrate = double(total) * 8e6 / double(info.durationUs);
+            }
+        }
+        return true;
+    }
+    return true;
+}
+
+// ============================================================================
+// Matroska / WebM (EBML)
+// ============================================================================
+
+const uint64_t EBML_UNKNOWN = ~uint64_t(0);
+
+struct Element {
+    uint32_t id   = 0;
+    uint64_t data = 0;
+    uint64_t size = 0;   // EBML_UNKNOWN: до конца родителя
+    uint64_t end  = 0;
+};
+
+// Variable-length integer at p[0..n): length in `len`; ids keep the marker
+// bit, sizes drop it (all ones = unknown size)
+bool ebml_vint(const uint8_t* p, size_t n, bool is_id, uint64_t& val, int& len) {
+    if (n == 0 || p[0] == 0) return false;
+    len = 1;
+    while (!(p[0] & (0x80 >> (len - 1)))) len++;
+    if (static_cast<size_t>(len) > n || (is_id && len > 4)) return false;
+    val = is_id ? p[0] : (p[0] & (0xff >> len));
+    bool ones = val == uint64_t(0xff >> len);
+    for (int i = 1; i < len; i++) {
+        val = (val << 8) | p[i];
+        ones = ones && p[i] == 0xff;
+    }
+    if (!is_id && ones) val = EBML_UNKNOWN;
+    return true;
+}
+
+bool element_at(ProbeFile& f, uint64_t off, uint64_t end, Element& el) {
+    if (off >= end) return false;
+    const std::vector<uint8_t> h = f.bytes(off, std::min<uint64_t>(12, end - off));
+    uint64_t id = 0, size = 0;
+    int il = 0, sl = 0;
+    if (!ebml_vint(h.data(), h.size(), true, id, il) ||
+        !ebml_vint(h.data() + il, h.size() - il, false, size, sl)) return false;
+    el.id   = static_cast<uint32_t>(id);
+    el.data = off + il + sl;
+    el.size = size;
+    if (size == EBML_UNKNOWN) el.end = end;
+    else if (size > end - el.data) return false;
+    else el.end = el.data + size;
+    return true;
+}
+
+uint64_t ebml_uint(ProbeFile& f, const Element& el) {
+    if (el.size == 0 || el.size > 8) return 0;
+    uint8_t b[8];
+    if (!f.read(el.data, b, static_cast<size_t>(el.size))) return 0;
+    uint64_t v = 0;
+    for (uint64_t i = 0; i < el.size; i++) v = (v << 8) | b[i];
+    return v;
+}
+
+double ebml_float(ProbeFile& f, const Element& el) {
+    uint8_t b[8];
+    if ((el.size != 4 && el.size != 8) || !f.read(el.data, b, static_cast<size_t>(el.size))) return 0;
+    if (el.size == 4) {
+        const uint32_t u = be32(b);
+        float x;
+        std::memcpy(&x, &u, 4);
+        return x;
+    }
+    const uint64_t u = be64(b);
+    double x;
+    std::memcpy(&x, &u, 8);
+    return x;
+}
+
+std::string ebml_string(ProbeFile& f, const Element& el) {
+    if (el.size > 4096) return "";
+    const std::vector<uint8_t> b = f.bytes(el.data, el.size);
+    std::string s(b.begin(), b.end());
+    return s.substr(0, s.find('\0'));
+}
+
+// Children of [off, end); fn(child) returns false to stop
+template <typename Fn>
+void ebml_children(ProbeFile& f, uint64_t off, uint64_t end, Fn fn) {
+    Element el;
+    while (element_at(f, off, end, el)) {
+        if (!fn(el) || el.size == EBML_UNKNOWN) break;
+        off = el.end;
+    }
+}
+
+// "HH:MM:SS.nnnnnnnnn" (DURATION tag) -> seconds
+double tag_duration(const std::string& s) {
+    int h = 0, m = 0;
+    double sec = 0;
+    if (std::sscanf(s.c_str(), "%d:%d:%lf", &h, &m, &sec) != 3) return 0;
+    return h * 3600.0 + m * 60.0 + sec;
+}
+
+const char* mkv_codec(const std::string& id) {
+    static const struct { const char* id; const char* codec; } map[] = {
+        { "V_MPEG4/ISO/AVC", "h264" }, { "V_MPEGH/ISO/HEVC", "hevc" }, { "V_AV1", "av1" },
+        { "V_VP9", "vp9" }, { "V_VP8", "vp8" }, { "V_MJPEG", "mjpeg" },
+        { "V_MPEG4/ISO/ASP", "mpeg4" }, { "V_MPEG2", "mpeg2video" }, { "V_PRORES", "prores" },
+        { "V_FFV1", "ffv1" }, { "V_UNCOMPRESSED", "rawvideo" },
+    };
+    for (const auto& m : map) if (id == m.id) return m.codec;
+    return nullptr;
+}
+
+const char* avi_codec(uint32_t fcc);
+
+bool probe_matroska(ProbeFile& f, Av1rProbeInfo& info) {
+    Element hdr, seg;
+    if (!element_at(f, 0, f.size(), hdr) || hdr.id != 0x1A45DFA3) return false;
+    info.container = "matroska";
+    if (!element_at(f, hdr.end, f.size(), seg) || seg.id != 0x18538067) return true;
+
+    uint64_t scale = 1000000;      // TimestampScale, ns
+    double   segDuration = 0;      // в единицах TimestampScale
+    uint64_t trackUid = 0, defaultDuration = 0;
+    bool     haveTrack = false;
+    std::string codecId;
+    std::vector<uint8_t> priv;
+    int64_t  tagFrames = -1;
+    double   tagBps = -1, tagDuration = 0;
+    uint64_t seekInfo = 0, seekTracks = 0, seekTags = 0;   // 0 = не найдено
+    bool     sawInfo = false, sawTracks = false, sawTags = false;
+
+    auto parse_info = [&](const Element& el) {
+        sawInfo = true;
+        ebml_children(f, el.data, el.end, [&](const Element& c) {
+            if (c.id == 0x2AD7B1)      scale = ebml_uint(f, c);
+            else if (c.id == 0x4489)   segDuration = ebml_float(f, c);
+            return true;
+        });
+    };
+    auto parse_tracks = [&](const Element& el) {
+        sawTracks = true;
+        ebml_children(f, el.data, el.end, [&](const Element& te) {
+            if (te.id != 0xAE) return true;
+            uint64_t type = 0, uid = 0, dd = 0, w = 0, h = 0;
+            std::string id;
+            std::vector<uint8_t> cp;
+            ebml_children(f, te.data, te.end, [&](const Element& c) {
+                switch (c.id) {
+                case 0x83:     type = ebml_uint(f, c); break;
+                case 0x73C5:   uid  = ebml_uint(f, c); break;
+                case 0x86:     id   = ebml_string(f, c); break;
+                case 0x23E383: dd   = ebml_uint(f, c); break;
+                case 0x63A2:   if (c.size <= (1u << 20)) cp = f.bytes(c.data, c.size); break;
+                case 0xE0:
+                    ebml_children(f, c.data, c.end, [&](const Element& v) {
+                        if (v.id == 0xB0)      w = ebml_uint(f, v);
+                        else if (v.id == 0xBA) h = ebml_uint(f, v);
+                        return true;
+                    });
+                    break;
+                }
+                return true;
+            });
+            if (type != 1) return true;
+            haveTrack = true;
+            trackUid = uid; defaultDuration = dd; codecId = id; priv = cp;
+            info.width  = static_cast<int>(w);
+            info.height = static_cast<int>(h);
+            return false;   // первая видеодорожка
+        });
+    };
+    auto parse_tags = [&](const Element& el) {
+        sawTags = true;
+        ebml_children(f, el.data, el.end, [&](const Element& tag) {
+            if (tag.id != 0x7373) return true;
+            bool forTrack = true;   // без Targets/TagTrackUID — для всех дорожек
+            std::vector<std::pair<std::string, std::string>> simple;
+            ebml_children(f, tag.data, tag.end, [&](const Element& c) {
+                if (c.id == 0x63C0) {
+                    ebml_children(f, c.data, c.end, [&](const Element& t) {
+                        if (t.id == 0x63C5) forTrack = ebml_uint(f, t) == trackUid;
+                        return true;
+                    });
+                } else if (c.id == 0x67C8) {
+                    std::string name, value;
+                    ebml_children(f, c.data, c.end, [&](const Element& s) {
+                        if (s.id == 0x45A3)      name  = ebml_string(f, s);
+                        else if (s.id == 0x4487) value = ebml_string(f, s);
+                        return true;
+                    });
+                    simple.emplace_back(name, value);
+                }
+                return true;
+            });
+            if (!forTrack) return true;
+            for (const auto& nv : simple) {
+                if (nv.first == "NUMBER_OF_FRAMES")  tagFrames   = std::atoll(nv.second.c_str());
+                else if (nv.first == "BPS")          tagBps      = std::atof(nv.second.c_str());
+                else if (nv.first == "DURATION")     tagDuration = tag_duration(nv.second);
+            }
+            return true;
+        });
+    };
+
+    // Linear walk up to the first Cluster, then whatever SeekHead points at
+    ebml_children(f, seg.data, seg.end, [&](const Element& el) {
+        switch (el.id) {
+        case 0x1549A966: parse_info(el); break;
+        case 0x1654AE6B: parse_tracks(el); break;
+        case 0x1254C367: if (haveTrack) parse_tags(el); break;
+        case 0x114D9B74:
+            ebml_children(f, el.data, el.end, [&](const Element& s) {
+                if (s.id != 0x4DBB) return true;
+                uint64_t id = 0, pos = 0;
+                ebml_children(f, s.data, s.end, [&](const Element& c) {
+                    if (c.id == 0x53AB)      id  = ebml_uint(f, c);
+                    else if (c.id == 0x53AC) pos = ebml_uint(f, c);
+                    return true;
+                });
+                if (id == 0x1549A966)      seekInfo   = seg.data + pos;
+                else if (id == 0x1654AE6B) seekTracks = seg.data + pos;
+                else if (id == 0x1254C367) seekTags   = seg.data + pos;
+                return true;
+            });
+            break;
+        case 0x1F43B675: return false;
+        }
+        return true;
+    });
+    Element el;
+    if (!sawInfo && seekInfo && element_at(f, seekInfo, seg.end, el) && el.id == 0x1549A966)
+        parse_info(el);
+    if (!sawTracks && seekTracks && element_at(f, seekTracks, seg.end, el) && el.id == 0x1654AE6B)
+        parse_tracks(el);
+    if (!haveTrack) return true;
+    if (!sawTags && seekTags && element_at(f, seekTags, seg.end, el) && el.id == 0x1254C367)
+        parse_tags(el);
+
+    // Codec, and the pixel format from CodecPrivate
+    const char* codec = mkv_codec(codecId);
+    if (codecId == "V_MS/VFW/FOURCC" && priv.size() >= 20) {
+        const uint32_t fcc = be32(&priv[16]);
+        codec = avi_codec(fcc);
+        if (!codec) {
+            const char cc[5] = { char(priv[16]), char(priv[17]), char(priv[18]), char(priv[19]), 0 };
+            info.codec = cc;
+        }
+    }
+    if (codec) info.codec = codec;
+    else if (info.codec.empty()) info.codec = codecId;
+    if (!priv.empty()) {
+        if (info.codec == "h264")      info.pixFmt = avcc_pix_fmt(priv.data(), priv.size());
+        else if (info.codec == "hevc") info.pixFmt = hvcc_pix_fmt(priv.data(), priv.size());
+        else if (info.codec == "av1")  info.pixFmt = av1c_pix_fmt(priv.data(), priv.size());
+    }
+
+    const double durSec = segDuration > 0 ? segDuration * double(scale) / 1e9 : tagDuration;
+    if (durSec > 0) info.durationUs = static_cast<int64_t>(durSec * 1e6);
+    if (defaultDuration > 0) set_rate_from_period(info, double(defaultDuration) / 1e9);
+    // Matroska stores no frame count; mkvmerge writes NUMBER_OF_FRAMES
+    if (tagFrames > 0) {
+        info.frames = tagFrames;
+    } else if (durSec > 0 && info.fpsNum > 0) {
+        info.frames = std::llround(durSec * double(info.fpsNum) / double(info.fpsDen));
+    }
+    if (tagBps > 0) info.bitrate = tagBps;
+    return true;
+}
+
+// ============================================================================
+// AVI (RIFF, OpenDML)
+// ============================================================================
+
+const char* avi_codec(uint32_t fcc) {
+    switch (fcc) {
+    case fourcc("MJPG"): case fourcc("mjpg"): case fourcc("AVRn"): case fourcc("dmb1"): return "mjpeg";
+    case fourcc("H264"): case fourcc("h264"): case fourcc("X264"): case fourcc("x264"):
+    case fourcc("avc1"): return "h264";
+    case fourcc("HEVC"): case fourcc("H265"): case fourcc("hev1"): case fourcc("hvc1"): return "hevc";
+    case fourcc("XVID"): case fourcc("xvid"): case fourcc("DIVX"): case fourcc("DX50"):
+    case fourcc("FMP4"): case fourcc("MP4V"): return "mpeg4";
+    case fourcc("AV01"): return "av1";
+    case fourcc("FFV1"): return "ffv1";
+    case 0: case fourcc("DIB "): return "rawvideo";
+    default: return nullptr;
+    }
+}
+
+bool probe_avi(ProbeFile& f, Av1rProbeInfo& info) {
+    uint8_t h[12];
+    if (!f.read(0, h, 12) || be32(h) != fourcc("RIFF") ||
+        (be32(h + 8) != fourcc("AVI ") && be32(h + 8) != fourcc("AVIX"))) return false;
+    info.container = "avi";
+    const uint64_t end = std::min<uint64_t>(f.size(), uint64_t(le32(h + 4)) + 8);
+
+    // Chunks of [off, end): fn(id, list type or 0, data offset, size)
+    auto chunks = [&](uint64_t off, uint64_t stop, auto&& fn) {
+        uint8_t c[12];
+        while (off + 8 <= stop && f.read(off, c, 8)) {
+            const uint32_t id = be32(c);
+            const uint64_t size = le32(c + 4);
+            uint32_t list = 0;
+            if (id == fourcc("LIST") && size >= 4 && f.read(off + 8, c + 8, 4)) list = be32(c + 8);
+            if (!fn(id, list, off + 8, size)) break;
+            off += 8 + size + (size & 1);
+        }
+    };
+
+    int stream = -1, vstream = -1;
+    uint32_t compression = 0, rate = 0, scale = 0;
+    uint16_t bitcount = 0;
+    int64_t  length = -1, odmlFrames = -1;
+    uint64_t moviData = 0, moviSize = 0;
+    int64_t  idxBytes = -1;
+
+    chunks(12, end, [&](uint32_t id, uint32_t list, uint64_t data, uint64_t size) {
+        if (list == fourcc("hdrl")) {
+            chunks(data + 4, data + size, [&](uint32_t, uint32_t l, uint64_t d, uint64_t s) {
+                if (l == fourcc("odml")) {
+                    chunks(d + 4, d + s, [&](uint32_t cid, uint32_t, uint64_t cd, uint64_t cs) {
+                        uint8_t b[4];
+                        if (cid == fourcc("dmlh") && cs >= 4 && f.read(cd, b, 4)) odmlFrames = le32(b);
+                        return true;
+                    });
+                }
+                if (l != fourcc("strl")) return true;
+                stream++;
+                if (vstream >= 0) return true;
+                std::vector<uint8_t> strh, strf;
+                chunks(d + 4, d + s, [&](uint32_t cid, uint32_t, uint64_t cd, uint64_t cs) {
+                    if (cid == fourcc("strh")) strh = f.bytes(cd, std::min<uint64_t>(cs, 64));
+                    else if (cid == fourcc("strf")) strf = f.bytes(cd, std::min<uint64_t>(cs, 64));
+                    return true;
+                });
+                if (strh.size() < 36 || be32(&strh[0]) != fourcc("vids") || strf.size() < 20)
+                    return true;
+                vstream = stream;
+                scale  = le32(&strh[20]);
+                rate   = le32(&strh[24]);
+                length = le32(&strh[32]);
+                info.width  = static_cast<int>(le32(&strf[4]));
+                const int32_t ht = static_cast<int32_t>(le32(&strf[8]));
+                info.height = ht < 0 ? -ht : ht;   // < 0: top-down DIB
+                bitcount    = static_cast<uint16_t>(le16(&strf[14]));
+                compression = be32(&strf[16]);
+                return true;
+            });
+        } else if (list == fourcc("movi")) {
+            moviData = data + 4;
+            moviSize = size >= 4 ? size - 4 : 0;
+        } else if (id == fourcc("idx1") && vstream >= 0 && vstream < 100 && size <= MAX_TABLE) {
+            // Entries: ckid, flags, offset, size; video chunks are "NNdc"/"NNdb"
+            const std::vector<uint8_t> idx = f.bytes(data, size);
+            const char d0 = char('0' + vstream / 10), d1 = char('0' + vstream % 10);
+            idxBytes = 0;
+            for (size_t i = 0; i + 16 <= idx.size(); i += 16)
+                if (idx[i] == d0 && idx[i + 1] == d1 && idx[i + 2] == 'd' &&
+                    (idx[i + 3] == 'c' || idx[i + 3] == 'b'))
+                    idxBytes += le32(&idx[i + 12]);
+        }
+        return true;
+    });
+    if (vstream < 0) return true;
+
+    const char* codec = avi_codec(compression);
+    if (codec) {
+        info.codec = codec;
+    } else {
+        const char cc[5] = { char(compression >> 24), char(compression >> 16),
+                             char(compression >> 8), char(compression), 0 };
+        info.codec = cc;
+    }
+    if (info.codec == "rawvideo")
+        info.pixFmt = bitcount == 24 ? "bgr24" : bitcount == 32 ? "bgra" : "";
+    set_rate(info, rate, scale);
+    // OpenDML: strh counts only the first RIFF; dmlh has the total
+    const int64_t frames = odmlFrames > 0 ? odmlFrames : length;
+    if (frames > 0) info.frames = frames;
+    if (info.frames > 0 && info.fpsNum > 0) {
+        info.durationUs = static_cast<int64_t>(double(info.frames) * info.fpsDen / info.fpsNum * 1e6);
+        // Without idx1 (OpenDML indexes): the movi list minus the chunk headers
+        const double bytes = idxBytes >= 0 ? double(idxBytes)
+            : moviData > 0 ? double(moviSize) - 8.0 * double(info.frames) : -1;
+        if (bytes > 0 && info.durationUs > 0) info.bitrate = bytes * 8e6 / double(info.durationUs);
+    }
+    return true;
+}
+
+// ============================================================================
+// TIFF (classic and BigTIFF)
+// ============================================================================
+
+bool probe_tiff(ProbeFile& f, Av1rProbeInfo& info) {
+    uint8_t h[16];
+    if (!f.read(0, h, 8)) return false;
+    const bool le = h[0] == 'I' && h[1] == 'I';
+    if (!le && !(h[0] == 'M' && h[1] == 'M')) return false;
+    auto u16 = [le](const uint8_t* p) { return le ? le16(p) : be16(p); };
+    auto u32 = [le](const uint8_t* p) { return le ? le32(p) : be32(p); };
+    auto u64 = [le](const uint8_t* p) { return le ? le64(p) : be64(p); };
+    const uint32_t version = u16(h + 2);
+    const bool big = version == 43;
+    if (version != 42 && !big) return false;
+    uint64_t ifd;
+    if (big) {
+        if (!f.read(0, h, 16)) return false;
+        ifd = u64(h + 8);
+    } else {
+        ifd = u32(h + 4);
+    }
+    info.container = "tiff";
+    info.codec     = "tiff";
+
+    const size_t countSize = big ? 8 : 2, entrySize = big ? 20 : 12, nextSize = big ? 8 : 4;
+    const size_t valueSize = big ? 8 : 4;
+    // First value of an entry: inline when it fits, else at the offset
+    auto value = [&](const uint8_t* e) -> uint64_t {
+        const uint32_t type = u16(e + 2);
+        const size_t width = type == 3 ? 2 : type == 4 ? 4 : type == 16 ? 8 : 0;
+        if (width == 0) return 0;
+        const uint64_t count = big ? u64(e + 4) : u32(e + 4);
+        const uint8_t* v = e + (big ? 12 : 8);
+        uint8_t buf[8];
+        if (count * width > valueSize) {
+            if (!f.read(big ? u64(v) : u32(v), buf, width)) return 0;
+            v = buf;
+        }
+        return width == 2 ? u16(v) : width == 4 ? u32(v) : u64(v);
+    };
+
+    int64_t pages = 0, imagejImages = -1;
+    uint32_t spp = 1, bits = 8;
+    std::unordered_set<uint64_t> seen;
+    while (ifd != 0 && ifd < f.size() && seen.insert(ifd).second) {
+        uint8_t c[8];
+        if (!f.read(ifd, c, countSize)) break;
+        const uint64_t n = big ? u64(c) : u16(c);
+        if (pages == 0) {
+            // Size, format and the ImageJ description from the first page only
+            const std::vector<uint8_t> es = f.bytes(ifd + countSize, n * entrySize);
+            for (size_t i = 0; i + entrySize <= es.size(); i += entrySize) {
+                const uint8_t* e = &es[i];
+                switch (u16(e)) {
+                case 256: info.width  = static_cast<int>(value(e)); break;
+                case 257: info.height = static_cast<int>(value(e)); break;
+                case 258: bits = static_cast<uint32_t>(value(e)); break;
+                case 277: spp  = static_cast<uint32_t>(value(e)); break;
+                case 270: {
+                    const uint64_t count = big ? u64(e + 4) : u32(e + 4);
+                    if (count <= valueSize || count > 65536) break;
+                    const uint8_t* v = e + (big ? 12 : 8);
+                    const std::vector<uint8_t> d = f.bytes(big ? u64(v) : u32(v), count);
+                    const std::string desc(d.begin(), d.end());
+                    const size_t at = desc.find("images=");
+                    if (desc.compare(0, 7, "ImageJ=") == 0 && at != std::string::npos)
+                        imagejImages = std::atoll(desc.c_str() + at + 7);
+                    break;
+                }
+                }
+            }
+        }
+        pages++;
+        uint8_t nx[8];
+        if (!f.read(ifd + countSize + n * entrySize, nx, nextSize)) break;
+        ifd = big ? u64(nx) : u32(nx);
+    }
+    if (pages == 0) return true;
+
+    // ImageJ stacks over 4 GB keep only the first IFD
+    info.frames = pages == 1 && imagejImages > 1 ? imagejImages : pages;
+    set_rate(info, 25, 1);   // как -framerate 25 в ffmpeg-вызовах
+    info.durationUs = info.frames * 1000000 / 25;
+    const char* suffix = le ? "le" : "be";
+    if (spp == 1)
+        info.pixFmt = bits == 8 ? "gray" : bits == 16 ? std::string("gray16") + suffix : "";
+    else if (spp == 3)
+        info.pixFmt = bits == 8 ? "rgb24" : bits == 16 ? std::string("rgb48") + suffix : "";
+    else if (spp == 4)
+        info.pixFmt = bits == 8 ? "rgba" : bits == 16 ? std::string("rgba64") + suffix : "";
+    return true;
+}
+
+} // namespace
+
+bool av1r_probe_file(const char* path, Av1rProbeInfo& info) {
+    ProbeFile f(path);
+    if (f.size() < 16) return false;
+    info = Av1rProbeInfo();
+    const bool known = probe_tiff(f, info) || probe_matroska(f, info) ||
+                       probe_avi(f, info) || probe_mov(f, info);
+    return known && info.width > 0 && info.height > 0;
+}
@@ -0,0 +1,40 @@
+// Native container probe (R_av1r_probe): first video stream parameters
+// read straight from the container headers, no ffprobe process.
+//
+//   MP4/MOV   moov/trak: mdhd timescale, stsd sample entry (size, codec,
+//             avcC/hvcC/av1C for the pixel format), stts (frames, rate),
+//             stsz (stream bytes -> bitrate)
+//   Matroska  Info/Tracks/Tags (reached through SeekHead when they follow
+//   / WebM    the clusters): DefaultDuration, NUMBER_OF_FRAMES, BPS
+//   AVI       hdrl: strh/strf of the first vids stream, odml dmlh frame
+//             count, idx1 for the stream bytes
+//   TIFF      IFD chain (one page per frame, BigTIFF too; ImageJ stacks
+//             with a single IFD from "images="), 25 fps like the encoders
+//
+// Anything else (image sequences, MPEG-TS, fragmented MP4 without sample
+// tables, ...) is reported as unknown, and the R side asks ffprobe.
+
+#ifndef AV1R_PROBE_H
+#define AV1R_PROBE_H
+
+#include <cstdint>
+#include <string>
+
+struct Av1rProbeInfo {
+    std::string container;        // "mov", "matroska", "avi", "tiff"
+    std::string codec;            // ffmpeg codec name (h264, hevc, av1, mjpeg, ...)
+    std::string pixFmt;           // ffmpeg pix_fmt; "" when not in the headers
+    int         width      = 0;
+    int         height     = 0;
+    int64_t     fpsNum     = 0;   // exact frame rate fpsNum/fpsDen; 0 = unknown
+    int64_t     fpsDen     = 0;
+    int64_t     frames     = -1;  // -1 = unknown
+    int64_t     durationUs = -1;
+    double      bitrate    = -1;  // video stream, bits/s; < 0 = unknown
+};
+
+// True when `path` is in a supported container and has a video stream
+// with a known size; `info` is filled as far as the headers allow
+bool av1r_probe_file(const char* path, Av1rProbeInfo& info);
+
+#endif
@@ -0,0 +1,61 @@
+// Progress meter for the native encode loops (см. av1r_progress.h).
+
+#include "av1r_progress.h"
+
+#include <algorithm>
+
+void Av1rProgressMeter::reset(int totalFrames, double intervalSec, int fps) {
+    start_ = lastFrame_ = lastReport_ = Clock::now();
+    interval_ = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(std::max(intervalSec, 0.0)));
+    nextReport_ = start_ + interval_;
+    total_  = std::max(totalFrames, 0);
+    fps_    = fps;
+    frames_ = framesAtReport_ = 0;
+    bytes_  = 0;
+    maxGapSec_ = 0.0;
+}
+
+bool Av1rProgressMeter::frame_done(uint64_t packetBytes) {
+    const Clock::time_point now = Clock::now();
+    const double gap = std::chrono::duration<double>(now - lastFrame_).count();
+    if (gap > maxGapSec_) maxGapSec_ = gap;
+    lastFrame_ = now;
+    frames_++;
+    bytes_ += packetBytes;
+    return now >= nextReport_;
+}
+
+Av1rProgress Av1rProgressMeter::report(bool done) {
+    const Clock::time_point now = Clock::now();
+    Av1rProgress p;
+    p.frames      = frames_;
+    p.totalFrames = total_;
+    p.elapsedSec  = std::chrono::duration<double>(now - start_).count();
+    p.bytes       = bytes_;
+    p.done        = done;
+
+    // Скорость за последний интервал: реагирует на замедление, в отличие от среднего
+    const double since = std::chrono::duration<double>(now - lastReport_).count();
+    if (done)
+        p.fps = p.elapsedSec > 0.0 ? frames_ / p.elapsedSec : 0.0;
+    else
+        p.fps = since > 0.0 ? (frames_ - framesAtReport_) / since : 0.0;
+    if (frames_ > 0 && fps_ > 0)
+        p.bitrateKbps = static_cast<double>(bytes_) * 8.0 * fps_ / frames_ / 1000.0;
+    if (done)
+        p.etaSec = 0.0;
+    else if (total_ > 0 && p.fps > 0.0)
+        p.etaSec = std::max(total_ - frames_, 0) / p.fps;
+
+    // Also counts the wait since the last frame (relevant for reports not
+    // triggered by a frame, e.g. polling from another thread)
+    p.stallSec = std::max(maxGapSec_, std::chrono::duration<double>(now - lastFrame_).count());
+    p.stalled  = !done && p.stallSec >= AV1R_PROGRESS_STALL_SEC;
+
+    lastReport_ = now;
+    nextReport_ = now + interval_;
+    framesAtReport_ = frames_;
+    maxGapSec_ = 0.0;
+    return p;
+}
@@ -0,0 +1,48 @@
+// Encode progress records for av1r_options(progress =, progress_interval =).
+// The meter is fed once per encoded frame and says when a report is due;
+// between reports a frame costs one steady_clock read and a few adds, so
+// the callback rate, not the frame rate, bounds the reporting overhead.
+
+#ifndef AV1R_PROGRESS_H
+#define AV1R_PROGRESS_H
+
+#include <chrono>
+#include <cstdint>
+
+struct Av1rProgress {
+    int      frames      = 0;
+    int      totalFrames = 0;      // 0 = unknown (no ETA)
+    double   elapsedSec  = 0.0;
+    double   fps         = 0.0;    // since the previous report; overall when done
+    uint64_t bytes       = 0;
+    double   bitrateKbps = 0.0;    // at the stream frame rate
+    double   etaSec      = -1.0;   // < 0 = unknown
+    double   stallSec    = 0.0;    // longest wait for a frame since the previous report
+    bool     stalled     = false;  // stallSec >= AV1R_PROGRESS_STALL_SEC
+    bool     done        = false;
+};
+
+// A frame gap this long marks the encode as stalled (slow network input,
+// ffmpeg blocked on a device, GPU hang)
+#define AV1R_PROGRESS_STALL_SEC 10.0
+
+class Av1rProgressMeter {
+public:
+    // intervalSec <= 0: report after every frame; fps = stream rate for bitrate
+    void reset(int totalFrames, double intervalSec, int fps);
+    // Called after each encoded frame; true when a report is due
+    bool frame_done(uint64_t packetBytes);
+    // A report is due (for callers that poll instead of feeding frames)
+    bool due() const { return Clock::now() >= nextReport_; }
+    // Record for the current state; starts the next reporting interval
+    Av1rProgress report(bool done);
+private:
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start_, lastFrame_, lastReport_, nextReport_;
+    Clock::duration   interval_{};
+    int      total_ = 0, fps_ = 0, frames_ = 0, framesAtReport_ = 0;
+    uint64_t bytes_ = 0;
+    double   maxGapSec_ = 0.0;
+};
+
+#endif
@@ -12,11 +12,62 @@
 struct Av1rVulkanCtx;
 struct Av1rStreamEncoder;
 
+// Encode parameters (from av1r_options() on the R side)
+struct Av1rEncodeConfig {
+    int width  = 0;
+    int height = 0;
+    int fps    = 25;
+    int crf    = 28;
+    int preset = 8;    // 0 (slowest/best) .. 13 (fastest) → Vulkan quality level
+    double staticThreshold = -1.0;  // mean |diff| per sample to repeat the last frame, <0 = off
+    int keyintMax = 0;              // max frames between keyframes, 0 = 10 s
+    int keyintMin = 0;              // min frames before a scene-cut keyframe, 0 = 1 s
+    double sceneCut = 0.0;          // scene-cut threshold (0..1 thumbnail diff), 0 = off
+    int maxTiles = 0;               // cap on tile cols*rows, 0 = auto from frame size
+    uint32_t srcFormat = 0;         // Av1rPixFmt of the frames passed to encode (0 = NV12)
+    uint32_t windowLo = 0;          // gray16 window mapped to Y 16..235
+    uint32_t windowHi = 65535;
+    bool gpuTiming = false;         // timestamp queries around upload/encode
+};
+
+// Per-frame stage timings (ms) with gpuTiming; NaN where the queue has no
+// timestamp support. convert = compute shader, or CPU conversion/copy into
+// staging; upload/encode = GPU; readback = host bitstream + feedback read;
+// sync = frame wall time not covered by the stages (submission, semaphore
+// handoff between the transfer and encode queues, fence waits)
+struct Av1rFrameTiming {
+    uint32_t frame = 0;
+    double convertMs  = 0.0;
+    double uploadMs   = 0.0;
+    double encodeMs   = 0.0;
+    double readbackMs = 0.0;
+    double syncMs     = 0.0;
+};
+
+// What the encoder actually did (returned to R as per-encode stats)
+struct Av1rEncodeStats {
+    uint32_t qualityLevel     = 0;  // VkVideoEncodeQualityLevelInfoKHR::qualityLevel applied
+    uint32_t maxQualityLevels = 0;  // levels exposed by the driver (0 = query failed)
+    uint32_t skippedFrames    = 0;  // static frames emitted as show_existing_frame
+    uint32_t sceneCuts        = 0;  // keyframes placed by the scene-cut detector
+    std::vector<uint32_t> keyframes;  // frame indices coded as keyframes
+    uint32_t tileCols         = 1;  // AV1 tile layout used for every frame
+    uint32_t tileRows         = 1;
+    bool     tileUniform      = true;
+    const char* convert       = "none";  // NV12 conversion: "none" (NV12 input), "gpu", "cpu"
+    // gpuTiming: timestamps available on the transfer / encode queue
+    bool     timingTransfer   = false;
+    bool     timingEncode     = false;
+    double   timestampPeriodNs = 0.0;
+    std::vector<Av1rFrameTiming> timings;  // encoded frames only (not skipped)
+};
+
 Av1rStreamEncoder* av1r_vulkan_stream_new();
 void av1r_vulkan_stream_init(Av1rVulkanCtx& ctx, Av1rStreamEncoder* se,
-                              int width, int height, int fps, int crf);
-void av1r_vulkan_stream_encode(Av1rStreamEncoder* se, const uint8_t* frame_nv12,
+                              const Av1rEncodeConfig& cfg);
+void av1r_vulkan_stream_encode(Av1rStreamEncoder* se, const uint8_t* frame,
                                 int frame_index, std::vector<uint8_t>& out_packet);
+const Av1rEncodeStats& av1r_vulkan_stream_stats(const Av1rStreamEncoder* se);
 void av1r_vulkan_stream_finish(Av1rStreamEncoder* se);
 void av1r_vulkan_stream_delete(Av1rStreamEncoder* se);
 
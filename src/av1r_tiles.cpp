@@ -0,0 +1,107 @@
+// AV1 tile layout: число тайлов из размера кадра + лимиты AV1/драйвера,
+// uniform spacing когда это возможно, иначе явные границы (MiColStarts).
+
+#include "av1r_tiles.h"
+
+#include <algorithm>
+
+static const uint32_t SB_SIZE        = 64;               // use_128x128_superblock = 0
+static const uint32_t MI_PER_SB      = SB_SIZE / 4;
+static const uint32_t MAX_TILE_WIDTH = 4096;             // AV1 spec
+static const uint32_t MAX_TILE_AREA  = 4096 * 2304;
+static const uint32_t MAX_TILE_COLS  = 64;
+static const uint32_t MAX_TILE_ROWS  = 64;
+static const uint32_t AUTO_TILE_SIZE = 1024;             // auto: ~1024x1024 на тайл
+
+static uint32_t ceil_div(uint32_t a, uint32_t b) { return (a + b - 1) / b; }
+
+static uint32_t ceil_log2(uint32_t n) {
+    uint32_t k = 0;
+    while ((1u << k) < n) k++;
+    return k;
+}
+
+// Sizes in SB of `count` tiles over `sbs` superblocks.
+// Uniform: AV1 tile_info() размеры (все = ceil(sbs / 2^log2), последний — остаток);
+// иначе почти равные размеры.
+static bool split(uint32_t sbs, uint32_t count, std::vector<uint32_t>& sizes) {
+    sizes.clear();
+    const uint32_t log2 = ceil_log2(count);
+    const uint32_t uni  = (sbs + (1u << log2) - 1) >> log2;
+    if (ceil_div(sbs, uni) == count) {
+        for (uint32_t start = 0; start < sbs; start += uni)
+            sizes.push_back(std::min(uni, sbs - start));
+        return true;
+    }
+    for (uint32_t i = 0; i < count; i++)
+        sizes.push_back(sbs / count + (i < sbs % count ? 1u : 0u));
+    return false;
+}
+
+Av1rTileLayout av1r_tile_layout(uint32_t width, uint32_t height, uint32_t max_tiles,
+                                const Av1rTileLimits& limits) {
+    const uint32_t sbCols = ceil_div(width,  SB_SIZE);
+    const uint32_t sbRows = ceil_div(height, SB_SIZE);
+
+    // Auto: степени двойки — uniform spacing, самый короткий tile_info()
+    uint32_t cols = 1u << (ceil_log2(ceil_div(width,  AUTO_TILE_SIZE) + 1) - 1);
+    uint32_t rows = 1u << (ceil_log2(ceil_div(height, AUTO_TILE_SIZE) + 1) - 1);
+    if (max_tiles > 0) {
+        while (cols * rows > max_tiles) {
+            if (rows > 1 && rows >= cols) rows--;
+            else cols--;
+        }
+    }
+
+    // Upper bounds: AV1, driver, min tile size, one SB per tile
+    uint32_t maxCols = std::min(MAX_TILE_COLS, sbCols);
+    uint32_t maxRows = std::min(MAX_TILE_ROWS, sbRows);
+    if (limits.maxCols)   maxCols = std::min(maxCols, limits.maxCols);
+    if (limits.maxRows)   maxRows = std::min(maxRows, limits.maxRows);
+    if (limits.minWidth)  maxCols = std::min(maxCols, std::max(1u, width  / limits.minWidth));
+    if (limits.minHeight) maxRows = std::min(maxRows, std::max(1u, height / limits.minHeight));
+    cols = std::max(1u, std::min(cols, maxCols));
+    rows = std::max(1u, std::min(rows, maxRows));
+
+    // Lower bounds: tile width/height/area limits override the user cap
+    uint32_t maxW = MAX_TILE_WIDTH;
+    if (limits.maxWidth) maxW = std::min(maxW, limits.maxWidth);
+    cols = std::min(std::max(cols, ceil_div(width, maxW)), maxCols);
+    if (limits.maxHeight) rows = std::min(std::max(rows, ceil_div(height, limits.maxHeight)), maxRows);
+    const uint32_t tileW = ceil_div(sbCols, cols) * SB_SIZE;
+    rows = std::min(std::max(rows, ceil_div(tileW * std::min(height, sbRows * SB_SIZE), MAX_TILE_AREA)),
+                    maxRows);
+
+    Av1rTileLayout L;
+    L.cols = cols;
+    L.rows = rows;
+
+    std::vector<uint32_t> w, h;
+    const bool uniCols = split(sbCols, cols, w);
+    const bool uniRows = split(sbRows, rows, h);
+    L.uniform = uniCols && uniRows;
+    if (!L.uniform) {
+        // Non-uniform spacing codes every tile explicitly — use even sizes
+        // in both directions rather than mixing implicit and explicit ones
+        w.clear(); h.clear();
+        for (uint32_t i = 0; i < cols; i++) w.push_back(sbCols / cols + (i < sbCols % cols ? 1u : 0u));
+        for (uint32_t i = 0; i < rows; i++) h.push_back(sbRows / rows + (i < sbRows % rows ? 1u : 0u));
+    }
+
+    uint32_t mi = 0;
+    for (uint32_t s : w) {
+        L.miColStarts.push_back(static_cast<uint16_t>(mi));
+        L.widthInSbsMinus1.push_back(static_cast<uint16_t>(s - 1));
+        mi += s * MI_PER_SB;
+    }
+    // Последняя граница — MiCols (spec tile_info), не кратна SB
+    L.miColStarts.push_back(static_cast<uint16_t>(std::min(mi, 2 * ((width + 7) >> 3))));
+    mi = 0;
+    for (uint32_t s : h) {
+        L.miRowStarts.push_back(static_cast<uint16_t>(mi));
+        L.heightInSbsMinus1.push_back(static_cast<uint16_t>(s - 1));
+        mi += s * MI_PER_SB;
+    }
+    L.miRowStarts.push_back(static_cast<uint16_t>(std::min(mi, 2 * ((height + 7) >> 3))));
+    return L;
+}
@@ -0,0 +1,36 @@
+// AV1 tile layout for the Vulkan encoder (no Vulkan dependency).
+// Tiles let viewers/analysis tools decode one frame on several threads.
+
+#ifndef AV1R_TILES_H
+#define AV1R_TILES_H
+
+#include <cstdint>
+#include <vector>
+
+// Driver limits (VkVideoEncodeAV1CapabilitiesKHR); 0 = no limit reported
+struct Av1rTileLimits {
+    uint32_t maxCols   = 0;
+    uint32_t maxRows   = 0;
+    uint32_t minWidth  = 0;   // samples
+    uint32_t minHeight = 0;
+    uint32_t maxWidth  = 0;
+    uint32_t maxHeight = 0;
+};
+
+struct Av1rTileLayout {
+    uint32_t cols    = 1;
+    uint32_t rows    = 1;
+    bool     uniform = true;   // uniform_tile_spacing_flag
+    // Tile boundaries in MI units (4x4), cols+1 / rows+1 entries,
+    // and tile sizes in superblocks (minus 1), cols / rows entries
+    std::vector<uint16_t> miColStarts, miRowStarts;
+    std::vector<uint16_t> widthInSbsMinus1, heightInSbsMinus1;
+};
+
+// Layout for a width x height frame with 64x64 superblocks.
+// max_tiles caps cols*rows (0 = auto: tiles of about 1024x1024 samples);
+// AV1 (MAX_TILE_WIDTH, MAX_TILE_AREA) and driver limits take precedence.
+Av1rTileLayout av1r_tile_layout(uint32_t width, uint32_t height, uint32_t max_tiles,
+                                const Av1rTileLimits& limits);
+
+#endif
@@ -0,0 +1,185 @@
+// Chrome trace JSON writer for AV1R pipeline spans (см. av1r_trace.h).
+// Формат: {"traceEvents":[...]} с "X"-событиями (ts/dur в мкс) и "M"-метаданными
+// process_name / thread_name для именованных дорожек.
+
+#include "av1r_trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#  include <process.h>
+#  define av1r_getpid _getpid
+#else
+#  include <unistd.h>
+#  define av1r_getpid getpid
+#endif
+
+std::atomic<bool> g_av1r_trace_on{false};
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Track { int64_t pid; uint32_t tid; std::string name; bool process; };
+struct Event {
+    std::string name, args, cat;
+    int64_t ts, dur, pid;
+    uint32_t tid;
+};
+
+std::mutex            g_mu;
+std::string           g_path;
+Clock::time_point     g_t0;
+int64_t               g_pid = 0;
+uint32_t              g_mainTid = 0;
+std::vector<Track>    g_tracks;            // index + 1 = track id
+std::map<std::string, uint32_t> g_trackIds;
+std::vector<Event>    g_events;
+std::atomic<uint32_t> g_nextTid{1};
+
+// Real threads: small stable ids in order of first span
+uint32_t thread_tid() {
+    thread_local uint32_t tid = g_nextTid.fetch_add(1);
+    return tid;
+}
+
+uint32_t find_or_add_track(const char* name, bool process) {
+    if (!av1r_trace_on()) return 0;
+    std::lock_guard<std::mutex> lock(g_mu);
+    const std::string key = (process ? "p:" : "t:") + std::string(name);
+    auto it = g_trackIds.find(key);
+    if (it != g_trackIds.end()) return it->second;
+    Track t;
+    t.name = name;
+    t.process = process;
+    if (process) {
+        // Дочерний процесс: своя строка в UI; pid не реальный (popen его не даёт)
+        uint32_t nChildren = 0;
+        for (const Track& x : g_tracks) nChildren += x.process ? 1u : 0u;
+        t.pid = g_pid * 100 + 1 + nChildren;
+        t.tid = 1;
+    } else {
+        t.pid = g_pid;
+        t.tid = 1000 + static_cast<uint32_t>(g_tracks.size());
+    }
+    g_tracks.push_back(t);
+    const uint32_t id = static_cast<uint32_t>(g_tracks.size());
+    g_trackIds[key] = id;
+    return id;
+}
+
+void json_string(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+void metadata(std::string& out, const char* what, int64_t pid, uint32_t tid,
+              const std::string& name) {
+    out += "{\"name\":\"";
+    out += what;
+    out += "\",\"ph\":\"M\",\"pid\":" + std::to_string(pid) +
+           ",\"tid\":" + std::to_string(tid) + ",\"args\":{\"name\":";
+    json_string(out, name);
+    out += "}},\n";
+}
+
+} // namespace
+
+bool av1r_trace_start(const char* path) {
+    std::lock_guard<std::mutex> lock(g_mu);
+    if (g_av1r_trace_on.load()) return false;
+    g_path = path;
+    g_t0   = Clock::now();
+    g_pid  = static_cast<int64_t>(av1r_getpid());
+    g_mainTid = thread_tid();
+    g_tracks.clear();
+    g_trackIds.clear();
+    g_events.clear();
+    g_av1r_trace_on.store(true);
+    return true;
+}
+
+int64_t av1r_trace_now_us() {
+    if (!g_av1r_trace_on.load(std::memory_order_acquire)) return 0;
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - g_t0).count();
+}
+
+uint32_t av1r_trace_track(const char* name) { return find_or_add_track(name, false); }
+uint32_t av1r_trace_child(const char* name) { return find_or_add_track(name, true); }
+
+void av1r_trace_span(const char* name, const char* cat, int64_t ts_us, int64_t dur_us,
+                     uint32_t track, const std::string& args_json) {
+    if (!av1r_trace_on()) return;
+    const uint32_t self = track == 0 ? thread_tid() : 0;
+    std::lock_guard<std::mutex> lock(g_mu);
+    Event e;
+    e.name = name;
+    e.args = args_json;
+    e.cat  = cat;
+    e.ts   = ts_us;
+    e.dur  = dur_us < 0 ? 0 : dur_us;
+    if (track == 0 || track > g_tracks.size()) {
+        e.pid = g_pid;
+        e.tid = self ? self : thread_tid();
+    } else {
+        e.pid = g_tracks[track - 1].pid;
+        e.tid = g_tracks[track - 1].tid;
+    }
+    g_events.push_back(std::move(e));
+}
+
+size_t av1r_trace_stop() {
+    std::lock_guard<std::mutex> lock(g_mu);
+    if (!g_av1r_trace_on.load()) return 0;
+    g_av1r_trace_on.store(false);
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    metadata(out, "process_name", g_pid, 0, "AV1R (R pid " + std::to_string(g_pid) + ")");
+    metadata(out, "thread_name", g_pid, g_mainTid, "R main");
+    for (const Track& t : g_tracks) {
+        if (t.process) metadata(out, "process_name", t.pid, 0, t.name + " (child)");
+        metadata(out, "thread_name", t.pid, t.tid, t.name);
+    }
+    for (size_t i = 0; i < g_events.size(); i++) {
+        const Event& e = g_events[i];
+        out += "{\"name\":";
+        json_string(out, e.name);
+        out += ",\"cat\":\"" + e.cat + "\",\"ph\":\"X\",\"ts\":" +
+               std::to_string(e.ts) + ",\"dur\":" + std::to_string(e.dur) +
+               ",\"pid\":" + std::to_string(e.pid) + ",\"tid\":" + std::to_string(e.tid);
+        if (!e.args.empty()) out += ",\"args\":{" + e.args + "}";
+        out += i + 1 < g_events.size() ? "},\n" : "}\n";
+    }
+    if (g_events.empty()) out.erase(out.size() - 2, 1);   // trailing comma of metadata
+    out += "]}\n";
+
+    const size_t n = g_events.size();
+    g_events.clear();
+    FILE* f = std::fopen(g_path.c_str(), "wb");
+    if (!f) throw std::runtime_error("cannot write trace file: " + g_path);
+    const bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    std::fclose(f);
+    if (!ok) throw std::runtime_error("cannot write trace file: " + g_path);
+    return n;
+}
@@ -0,0 +1,67 @@
+// Pipeline span tracing, exported as Chrome trace JSON (chrome://tracing,
+// ui.perfetto.dev). Enabled by av1r_options(trace = "file.json").
+//
+// Disabled cost: one relaxed atomic load per span. Enabled: spans are
+// complete ("X") events collected under a mutex and written on stop.
+// Threads get their own track; worker bands and child processes (ffmpeg
+// decode/remux) are named virtual tracks, so the timeline shows where a
+// frame's wall time went across threads and processes.
+
+#ifndef AV1R_TRACE_H
+#define AV1R_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+extern std::atomic<bool> g_av1r_trace_on;
+inline bool av1r_trace_on() { return g_av1r_trace_on.load(std::memory_order_relaxed); }
+
+// Starts a trace written to `path` on stop. Returns false (and changes
+// nothing) when a trace is already running, so nested callers (a batch
+// around single-file conversions) share the outer trace.
+bool    av1r_trace_start(const char* path);
+// Writes the JSON and disables tracing; returns the number of spans.
+// Throws std::runtime_error if the file cannot be written.
+size_t  av1r_trace_stop();
+// Microseconds since the trace started (0 when off)
+int64_t av1r_trace_now_us();
+
+// Track ids: 0 = calling thread; others from av1r_trace_track()
+// Virtual thread named `name` inside this process (e.g. "denoise band 2")
+uint32_t av1r_trace_track(const char* name);
+// Virtual process for a child (e.g. "ffmpeg decode"): own row in the UI
+uint32_t av1r_trace_child(const char* name);
+
+void av1r_trace_span(const char* name, const char* cat, int64_t ts_us, int64_t dur_us,
+                     uint32_t track = 0, const std::string& args_json = std::string());
+
+// RAII span; `track` as above
+class Av1rTraceSpan {
+public:
+    Av1rTraceSpan(const char* name, const char* cat, uint32_t track = 0)
+        : name_(name), cat_(cat), track_(track), on_(av1r_trace_on()) {
+        if (on_) t0_ = av1r_trace_now_us();
+    }
+    ~Av1rTraceSpan() {
+        if (on_) av1r_trace_span(name_, cat_, t0_, av1r_trace_now_us() - t0_, track_, args_);
+    }
+    // Extra key/values shown in the span's details, e.g. "\"frame\":12"
+    void args(const std::string& json) { if (on_) args_ = json; }
+    Av1rTraceSpan(const Av1rTraceSpan&) = delete;
+    Av1rTraceSpan& operator=(const Av1rTraceSpan&) = delete;
+private:
+    const char* name_;
+    const char* cat_;
+    uint32_t    track_;
+    bool        on_;
+    int64_t     t0_ = 0;
+    std::string args_;
+};
+
+#define AV1R_TRACE_CONCAT2(a, b) a##b
+#define AV1R_TRACE_CONCAT(a, b) AV1R_TRACE_CONCAT2(a, b)
+#define AV1R_TRACE_SPAN(name, cat) \
+    Av1rTraceSpan AV1R_TRACE_CONCAT(av1r_trace_span_, __LINE__)(name, cat)
+
+#endif
@@ -0,0 +1,139 @@
+// Core Vulkan entry points used by AV1R, called through a function table.
+//
+// The table points either at the system loader (libvulkan) or at the
+// built-in stub driver (av1r_vk_stub.cpp), selected by the environment
+// variable AV1R_VULKAN_STUB at every av1r_create_instance(). The stub has
+// no GPU: it emits deterministic fake OBUs, so the whole encode path
+// (struct building, submission, readback, muxing) runs on any machine.
+//
+// Every TU that calls vk* functions includes this header after vulkan.h;
+// the macros below redirect those calls to the table.
+
+#ifndef AV1R_VK_DISPATCH_H
+#define AV1R_VK_DISPATCH_H
+
+#ifdef AV1R_USE_VULKAN
+
+#include <vulkan/vulkan.h>
+
+#define AV1R_VK_CORE_FUNCS(X)                                                  \
+    X(CreateInstance) X(DestroyInstance) X(EnumeratePhysicalDevices)           \
+    X(GetPhysicalDeviceProperties) X(GetPhysicalDeviceMemoryProperties)        \
+    X(GetPhysicalDeviceQueueFamilyProperties)                                  \
+    X(EnumerateDeviceExtensionProperties)                                      \
+    X(GetInstanceProcAddr) X(GetDeviceProcAddr)                                \
+    X(CreateDevice) X(DestroyDevice) X(GetDeviceQueue)                         \
+    X(AllocateMemory) X(FreeMemory) X(MapMemory) X(UnmapMemory)                \
+    X(FlushMappedMemoryRanges) X(InvalidateMappedMemoryRanges)                 \
+    X(CreateBuffer) X(DestroyBuffer) X(GetBufferMemoryRequirements)            \
+    X(BindBufferMemory)                                                        \
+    X(CreateImage) X(DestroyImage) X(GetImageMemoryRequirements)               \
+    X(BindImageMemory) X(CreateImageView) X(DestroyImageView)                  \
+    X(CreateCommandPool) X(DestroyCommandPool)                                 \
+    X(AllocateCommandBuffers) X(FreeCommandBuffers)                            \
+    X(BeginCommandBuffer) X(EndCommandBuffer) X(ResetCommandBuffer)            \
+    X(QueueSubmit)                                                             \
+    X(CreateFence) X(DestroyFence) X(ResetFences) X(WaitForFences)             \
+    X(CreateSemaphore) X(DestroySemaphore)                                     \
+    X(CreateQueryPool) X(DestroyQueryPool) X(GetQueryPoolResults)              \
+    X(CmdCopyBuffer) X(CmdCopyBufferToImage)                                   \
+    X(CmdPipelineBarrier) X(CmdPipelineBarrier2)                               \
+    X(CmdResetQueryPool) X(CmdBeginQuery) X(CmdEndQuery) X(CmdWriteTimestamp)  \
+    X(CreateShaderModule) X(DestroyShaderModule)                               \
+    X(CreateDescriptorSetLayout) X(DestroyDescriptorSetLayout)                 \
+    X(CreatePipelineLayout) X(DestroyPipelineLayout)                           \
+    X(CreateComputePipelines) X(DestroyPipeline)                               \
+    X(CreateDescriptorPool) X(DestroyDescriptorPool)                           \
+    X(AllocateDescriptorSets) X(UpdateDescriptorSets)                          \
+    X(CmdBindPipeline) X(CmdBindDescriptorSets) X(CmdPushConstants)            \
+    X(CmdDispatch)
+
+struct Av1rVkCoreFuncs {
+#define AV1R_VK_MEMBER(name) PFN_vk##name name;
+    AV1R_VK_CORE_FUNCS(AV1R_VK_MEMBER)
+#undef AV1R_VK_MEMBER
+};
+
+// Active table (loader by default)
+extern const Av1rVkCoreFuncs* av1r_vk_core_table;
+inline const Av1rVkCoreFuncs& av1r_vk_core() { return *av1r_vk_core_table; }
+
+// Re-read AV1R_VULKAN_STUB and switch the table. Only safe while no Vulkan
+// objects exist; av1r_create_instance() calls it first.
+void av1r_vk_select_driver();
+bool av1r_vk_stub_active();
+
+#ifndef AV1R_VK_DISPATCH_IMPL
+#define vkCreateInstance                         (av1r_vk_core().CreateInstance)
+#define vkDestroyInstance                        (av1r_vk_core().DestroyInstance)
+#define vkEnumeratePhysicalDevices               (av1r_vk_core().EnumeratePhysicalDevices)
+#define vkGetPhysicalDeviceProperties            (av1r_vk_core().GetPhysicalDeviceProperties)
+#define vkGetPhysicalDeviceMemoryProperties      (av1r_vk_core().GetPhysicalDeviceMemoryProperties)
+#define vkGetPhysicalDeviceQueueFamilyProperties (av1r_vk_core().GetPhysicalDeviceQueueFamilyProperties)
+#define vkEnumerateDeviceExtensionProperties     (av1r_vk_core().EnumerateDeviceExtensionProperties)
+#define vkGetInstanceProcAddr                    (av1r_vk_core().GetInstanceProcAddr)
+#define vkGetDeviceProcAddr                      (av1r_vk_core().GetDeviceProcAddr)
+#define vkCreateDevice                           (av1r_vk_core().CreateDevice)
+#define vkDestroyDevice                          (av1r_vk_core().DestroyDevice)
+#define vkGetDeviceQueue                         (av1r_vk_core().GetDeviceQueue)
+#define vkAllocateMemory                         (av1r_vk_core().AllocateMemory)
+#define vkFreeMemory                             (av1r_vk_core().FreeMemory)
+#define vkMapMemory                              (av1r_vk_core().MapMemory)
+#define vkUnmapMemory                            (av1r_vk_core().UnmapMemory)
+#define vkFlushMappedMemoryRanges                (av1r_vk_core().FlushMappedMemoryRanges)
+#define vkInvalidateMappedMemoryRanges           (av1r_vk_core().InvalidateMappedMemoryRanges)
+#define vkCreateBuffer                           (av1r_vk_core().CreateBuffer)
+#define vkDestroyBuffer                          (av1r_vk_core().DestroyBuffer)
+#define vkGetBufferMemoryRequirements            (av1r_vk_core().GetBufferMemoryRequirements)
+#define vkBindBufferMemory                       (av1r_vk_core().BindBufferMemory)
+#define vkCreateImage                            (av1r_vk_core().CreateImage)
+#define vkDestroyImage                           (av1r_vk_core().DestroyImage)
+#define vkGetImageMemoryRequirements             (av1r_vk_core().GetImageMemoryRequirements)
+#define vkBindImageMemory                        (av1r_vk_core().BindImageMemory)
+#define vkCreateImageView                        (av1r_vk_core().CreateImageView)
+#define vkDestroyImageView                       (av1r_vk_core().DestroyImageView)
+#define vkCreateCommandPool                      (av1r_vk_core().CreateCommandPool)
+#define vkDestroyCommandPool                     (av1r_vk_core().DestroyCommandPool)
+#define vkAllocateCommandBuffers                 (av1r_vk_core().AllocateCommandBuffers)
+#define vkFreeCommandBuffers                     (av1r_vk_core().FreeCommandBuffers)
+#define vkBeginCommandBuffer                     (av1r_vk_core().BeginCommandBuffer)
+#define vkEndCommandBuffer                       (av1r_vk_core().EndCommandBuffer)
+#define vkResetCommandBuffer                     (av1r_vk_core().ResetCommandBuffer)
+#define vkQueueSubmit                            (av1r_vk_core().QueueSubmit)
+#define vkCreateFence                            (av1r_vk_core().CreateFence)
+#define vkDestroyFence                           (av1r_vk_core().DestroyFence)
+#define vkResetFences                            (av1r_vk_core().ResetFences)
+#define vkWaitForFences                          (av1r_vk_core().WaitForFences)
+#define vkCreateSemaphore                        (av1r_vk_core().CreateSemaphore)
+#define vkDestroySemaphore                       (av1r_vk_core().DestroySemaphore)
+#define vkCreateQueryPool                        (av1r_vk_core().CreateQueryPool)
+#define vkDestroyQueryPool                       (av1r_vk_core().DestroyQueryPool)
+#define vkGetQueryPoolResults                    (av1r_vk_core().GetQueryPoolResults)
+#define vkCmdCopyBuffer                          (av1r_vk_core().CmdCopyBuffer)
+#define vkCmdCopyBufferToImage                   (av1r_vk_core().CmdCopyBufferToImage)
+#define vkCmdPipelineBarrier                     (av1r_vk_core().CmdPipelineBarrier)
+#define vkCmdPipelineBarrier2                    (av1r_vk_core().CmdPipelineBarrier2)
+#define vkCmdResetQueryPool                      (av1r_vk_core().CmdResetQueryPool)
+#define vkCmdBeginQuery                          (av1r_vk_core().CmdBeginQuery)
+#define vkCmdEndQuery                            (av1r_vk_core().CmdEndQuery)
+#define vkCmdWriteTimestamp                      (av1r_vk_core().CmdWriteTimestamp)
+#define vkCreateShaderModule                     (av1r_vk_core().CreateShaderModule)
+#define vkDestroyShaderModule                    (av1r_vk_core().DestroyShaderModule)
+#define vkCreateDescriptorSetLayout              (av1r_vk_core().CreateDescriptorSetLayout)
+#define vkDestroyDescriptorSetLayout             (av1r_vk_core().DestroyDescriptorSetLayout)
+#define vkCreatePipelineLayout                   (av1r_vk_core().CreatePipelineLayout)
+#define vkDestroyPipelineLayout                  (av1r_vk_core().DestroyPipelineLayout)
+#define vkCreateComputePipelines                 (av1r_vk_core().CreateComputePipelines)
+#define vkDestroyPipeline                        (av1r_vk_core().DestroyPipeline)
+#define vkCreateDescriptorPool                   (av1r_vk_core().CreateDescriptorPool)
+#define vkDestroyDescriptorPool                  (av1r_vk_core().DestroyDescriptorPool)
+#define vkAllocateDescriptorSets                 (av1r_vk_core().AllocateDescriptorSets)
+#define vkUpdateDescriptorSets                   (av1r_vk_core().UpdateDescriptorSets)
+#define vkCmdBindPipeline                        (av1r_vk_core().CmdBindPipeline)
+#define vkCmdBindDescriptorSets                  (av1r_vk_core().CmdBindDescriptorSets)
+#define vkCmdPushConstants                       (av1r_vk_core().CmdPushConstants)
+#define vkCmdDispatch                            (av1r_vk_core().CmdDispatch)
+#endif // AV1R_VK_DISPATCH_IMPL
+
+#endif // AV1R_USE_VULKAN
+#endif // AV1R_VK_DISPATCH_H
@@ -0,0 +1,1069 @@
+// Stub Vulkan driver for AV1R: CPU-only implementation of the core entry
+// points in av1r_vk_dispatch.h and of the Vulkan Video KHR functions loaded
+// by av1r_vk_video_loader.h. Selected with AV1R_VULKAN_STUB=1.
+//
+// Что делает stub:
+//   - один "CPU" physical device с двумя queue families:
+//     0 = TRANSFER (без COMPUTE → конвертация в NV12 идёт на CPU),
+//     1 = VIDEO_ENCODE; обе пишут timestamps (steady_clock, период 1 ns)
+//   - память — обычные host-аллокации, все типы HOST_VISIBLE|COHERENT
+//   - command buffers записывают операции и выполняются синхронно в
+//     vkQueueSubmit; fences/semaphores тривиальны
+//   - vkCmdEncodeVideoKHR пишет детерминированный фейковый кадр (metadata
+//     OBU, unregistered user private) и заполняет encode feedback query
+//   - vkGetEncodedVideoSessionParametersKHR отдаёт корректный sequence
+//     header OBU, так что IVF → MP4 remux через ffmpeg работает
+// Так замеряется host-side overhead на кадр (построение структур, submit,
+// readback, mux) и тестируется encode path без GPU.
+// Compiled only when AV1R_USE_VULKAN is defined
+
+#ifdef AV1R_USE_VULKAN
+
+#define AV1R_VK_DISPATCH_IMPL
+#include <vulkan/vulkan.h>
+#include "vk_video/vulkan_video_encode_av1_khr.h"
+#include "av1r_vk_dispatch.h"
+#include "av1r_vk_video_loader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+// ============================================================================
+// Таблицы: системный loader и stub
+// ============================================================================
+namespace {
+
+template <typename H, typename T> H to_handle(T* p) { return (H)(uintptr_t)p; }
+template <typename T, typename H> T* from_handle(H h) { return (T*)(uintptr_t)h; }
+
+struct StubObject {};   // fence, semaphore, image view, ...
+
+struct StubMemory {
+    std::vector<uint8_t> data;
+};
+
+struct StubBuffer {
+    VkDeviceSize size   = 0;
+    StubMemory*  mem    = nullptr;
+    VkDeviceSize offset = 0;
+    uint8_t* ptr() const { return mem ? mem->data.data() + offset : nullptr; }
+};
+
+struct StubImage {
+    uint32_t     width  = 0;
+    uint32_t     height = 0;
+    VkFormat     format = VK_FORMAT_UNDEFINED;
+    VkDeviceSize size   = 0;
+    StubMemory*  mem    = nullptr;
+    VkDeviceSize offset = 0;
+    uint8_t* ptr() const { return mem ? mem->data.data() + offset : nullptr; }
+};
+
+struct StubQuerySlot {
+    uint64_t timestamp = 0;
+    uint32_t offset    = 0;
+    uint32_t bytes     = 0;
+    bool     available = false;
+};
+
+struct StubQueryPool {
+    VkQueryType type = VK_QUERY_TYPE_TIMESTAMP;
+    VkVideoEncodeFeedbackFlagsKHR feedbackFlags = 0;
+    std::vector<StubQuerySlot> slots;
+};
+
+struct StubSession {
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    uint32_t frames = 0;   // encoded so far → payload seed
+};
+
+struct StubSessionParams {
+    std::vector<uint8_t> seqHeader;   // sequence header OBU
+};
+
+struct StubCommandPool;
+
+struct StubCmd {
+    StubCommandPool* pool = nullptr;
+    std::vector<std::function<void()>> ops;
+    StubSession*   session     = nullptr;   // between Begin/EndVideoCoding
+    StubQueryPool* activePool  = nullptr;   // between Begin/EndQuery
+    uint32_t       activeQuery = 0;
+};
+
+struct StubCommandPool {
+    std::vector<StubCmd*> cmds;
+};
+
+struct StubQueue {
+    uint32_t family = 0;
+};
+
+struct StubDevice {
+    StubQueue queues[2];
+};
+
+struct StubInstance {};
+struct StubPhysicalDevice {};
+StubPhysicalDevice g_phys;
+
+const uint32_t STUB_XFER_FAMILY   = 0;
+const uint32_t STUB_ENCODE_FAMILY = 1;
+const VkDeviceSize STUB_ALIGN     = 256;
+
+uint64_t now_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+VkDeviceSize align_up(VkDeviceSize v) { return (v + STUB_ALIGN - 1) / STUB_ALIGN * STUB_ALIGN; }
+
+template <typename T>
+VkResult fill_array(const std::vector<T>& src, uint32_t* count, T* out)
+{
+    if (!out) { *count = static_cast<uint32_t>(src.size()); return VK_SUCCESS; }
+    const uint32_t n = std::min<uint32_t>(*count, static_cast<uint32_t>(src.size()));
+    std::copy(src.begin(), src.begin() + n, out);
+    *count = n;
+    return n < src.size() ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+// ============================================================================
+// Instance / physical device
+// ============================================================================
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateInstance(const VkInstanceCreateInfo*,
+    const VkAllocationCallbacks*, VkInstance* pInstance)
+{
+    *pInstance = to_handle<VkInstance>(new StubInstance());
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroyInstance(VkInstance instance, const VkAllocationCallbacks*)
+{
+    delete from_handle<StubInstance>(instance);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_EnumeratePhysicalDevices(VkInstance, uint32_t* count,
+    VkPhysicalDevice* devs)
+{
+    return fill_array(std::vector<VkPhysicalDevice>{ to_handle<VkPhysicalDevice>(&g_phys) },
+                      count, devs);
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_GetPhysicalDeviceProperties(VkPhysicalDevice,
+    VkPhysicalDeviceProperties* props)
+{
+    *props = VkPhysicalDeviceProperties{};
+    props->apiVersion    = VK_API_VERSION_1_3;
+    props->driverVersion = 1;
+    props->deviceType    = VK_PHYSICAL_DEVICE_TYPE_CPU;
+    strncpy(props->deviceName, "AV1R stub encoder (AV1R_VULKAN_STUB)",
+            VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+    props->limits.timestampPeriod = 1.0f;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_GetPhysicalDeviceMemoryProperties(VkPhysicalDevice,
+    VkPhysicalDeviceMemoryProperties* props)
+{
+    *props = VkPhysicalDeviceMemoryProperties{};
+    props->memoryTypeCount = 1;
+    props->memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+                                          VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    props->memoryTypes[0].heapIndex = 0;
+    props->memoryHeapCount = 1;
+    props->memoryHeaps[0].size  = VkDeviceSize(8) << 30;
+    props->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_GetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice,
+    uint32_t* count, VkQueueFamilyProperties* props)
+{
+    VkQueueFamilyProperties xfer{};
+    xfer.queueFlags         = VK_QUEUE_TRANSFER_BIT;
+    xfer.queueCount         = 1;
+    xfer.timestampValidBits = 64;
+    xfer.minImageTransferGranularity = {1, 1, 1};
+    VkQueueFamilyProperties enc = xfer;
+    enc.queueFlags          = VK_QUEUE_VIDEO_ENCODE_BIT_KHR;
+    fill_array(std::vector<VkQueueFamilyProperties>{ xfer, enc }, count, props);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_EnumerateDeviceExtensionProperties(VkPhysicalDevice,
+    const char*, uint32_t* count, VkExtensionProperties* props)
+{
+    std::vector<VkExtensionProperties> exts(3);
+    strncpy(exts[0].extensionName, VK_KHR_VIDEO_QUEUE_EXTENSION_NAME,        VK_MAX_EXTENSION_NAME_SIZE - 1);
+    strncpy(exts[1].extensionName, VK_KHR_VIDEO_ENCODE_QUEUE_EXTENSION_NAME, VK_MAX_EXTENSION_NAME_SIZE - 1);
+    strncpy(exts[2].extensionName, VK_KHR_VIDEO_ENCODE_AV1_EXTENSION_NAME,   VK_MAX_EXTENSION_NAME_SIZE - 1);
+    for (auto& e : exts) e.specVersion = 1;
+    return fill_array(exts, count, props);
+}
+
+PFN_vkVoidFunction stub_proc_addr(const char* name);
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL stub_GetInstanceProcAddr(VkInstance, const char* name)
+{
+    return stub_proc_addr(name);
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL stub_GetDeviceProcAddr(VkDevice, const char* name)
+{
+    return stub_proc_addr(name);
+}
+
+// ============================================================================
+// Device / queues
+// ============================================================================
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateDevice(VkPhysicalDevice, const VkDeviceCreateInfo*,
+    const VkAllocationCallbacks*, VkDevice* pDevice)
+{
+    StubDevice* dev = new StubDevice();
+    dev->queues[STUB_XFER_FAMILY].family   = STUB_XFER_FAMILY;
+    dev->queues[STUB_ENCODE_FAMILY].family = STUB_ENCODE_FAMILY;
+    *pDevice = to_handle<VkDevice>(dev);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroyDevice(VkDevice device, const VkAllocationCallbacks*)
+{
+    delete from_handle<StubDevice>(device);
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_GetDeviceQueue(VkDevice device, uint32_t family, uint32_t,
+    VkQueue* pQueue)
+{
+    StubDevice* dev = from_handle<StubDevice>(device);
+    *pQueue = family < 2 ? to_handle<VkQueue>(&dev->queues[family]) : VK_NULL_HANDLE;
+}
+
+// ============================================================================
+// Memory, buffers, images
+// ============================================================================
+VKAPI_ATTR VkResult VKAPI_CALL stub_AllocateMemory(VkDevice, const VkMemoryAllocateInfo* ai,
+    const VkAllocationCallbacks*, VkDeviceMemory* pMemory)
+{
+    StubMemory* mem = new StubMemory();
+    mem->data.assign(static_cast<size_t>(ai->allocationSize), 0);
+    *pMemory = to_handle<VkDeviceMemory>(mem);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_FreeMemory(VkDevice, VkDeviceMemory memory,
+    const VkAllocationCallbacks*)
+{
+    delete from_handle<StubMemory>(memory);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_MapMemory(VkDevice, VkDeviceMemory memory,
+    VkDeviceSize offset, VkDeviceSize, VkMemoryMapFlags, void** ppData)
+{
+    *ppData = from_handle<StubMemory>(memory)->data.data() + offset;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_UnmapMemory(VkDevice, VkDeviceMemory) {}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_MappedMemoryRanges(VkDevice, uint32_t,
+    const VkMappedMemoryRange*)
+{
+    return VK_SUCCESS;   // вся память coherent
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateBuffer(VkDevice, const VkBufferCreateInfo* ci,
+    const VkAllocationCallbacks*, VkBuffer* pBuffer)
+{
+    StubBuffer* buf = new StubBuffer();
+    buf->size = ci->size;
+    *pBuffer = to_handle<VkBuffer>(buf);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroyBuffer(VkDevice, VkBuffer buffer,
+    const VkAllocationCallbacks*)
+{
+    delete from_handle<StubBuffer>(buffer);
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_GetBufferMemoryRequirements(VkDevice, VkBuffer buffer,
+    VkMemoryRequirements* mr)
+{
+    mr->size           = align_up(from_handle<StubBuffer>(buffer)->size);
+    mr->alignment      = STUB_ALIGN;
+    mr->memoryTypeBits = 1;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_BindBufferMemory(VkDevice, VkBuffer buffer,
+    VkDeviceMemory memory, VkDeviceSize offset)
+{
+    StubBuffer* buf = from_handle<StubBuffer>(buffer);
+    buf->mem    = from_handle<StubMemory>(memory);
+    buf->offset = offset;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateImage(VkDevice, const VkImageCreateInfo* ci,
+    const VkAllocationCallbacks*, VkImage* pImage)
+{
+    StubImage* img = new StubImage();
+    img->width  = ci->extent.width;
+    img->height = ci->extent.height;
+    img->format = ci->format;
+    // 4:2:0 8-bit (NV12/I420) — линейно: Y, затем chroma; остальное 4 байта/texel
+    const VkDeviceSize px = VkDeviceSize(img->width) * img->height;
+    const bool yuv420 = ci->format == VK_FORMAT_G8_B8R8_2PLANE_420_UNORM ||
+                        ci->format == VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM;
+    img->size = yuv420 ? px + px / 2 : px * 4;
+    *pImage = to_handle<VkImage>(img);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroyImage(VkDevice, VkImage image,
+    const VkAllocationCallbacks*)
+{
+    delete from_handle<StubImage>(image);
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_GetImageMemoryRequirements(VkDevice, VkImage image,
+    VkMemoryRequirements* mr)
+{
+    mr->size           = align_up(from_handle<StubImage>(image)->size);
+    mr->alignment      = STUB_ALIGN;
+    mr->memoryTypeBits = 1;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_BindImageMemory(VkDevice, VkImage image,
+    VkDeviceMemory memory, VkDeviceSize offset)
+{
+    StubImage* img = from_handle<StubImage>(image);
+    img->mem    = from_handle<StubMemory>(memory);
+    img->offset = offset;
+    return VK_SUCCESS;
+}
+
+// ============================================================================
+// Trivial objects: image views, fences, semaphores, command pools
+// ============================================================================
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateImageView(VkDevice, const VkImageViewCreateInfo*,
+    const VkAllocationCallbacks*, VkImageView* pView)
+{
+    *pView = to_handle<VkImageView>(new StubObject());
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroyImageView(VkDevice, VkImageView view,
+    const VkAllocationCallbacks*)
+{
+    delete from_handle<StubObject>(view);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateFence(VkDevice, const VkFenceCreateInfo*,
+    const VkAllocationCallbacks*, VkFence* pFence)
+{
+    *pFence = to_handle<VkFence>(new StubObject());
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroyFence(VkDevice, VkFence fence,
+    const VkAllocationCallbacks*)
+{
+    delete from_handle<StubObject>(fence);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_ResetFences(VkDevice, uint32_t, const VkFence*)
+{
+    return VK_SUCCESS;
+}
+
+// Работа выполняется синхронно в vkQueueSubmit — fence всегда signaled
+VKAPI_ATTR VkResult VKAPI_CALL stub_WaitForFences(VkDevice, uint32_t, const VkFence*,
+    VkBool32, uint64_t)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateSemaphore(VkDevice, const VkSemaphoreCreateInfo*,
+    const VkAllocationCallbacks*, VkSemaphore* pSemaphore)
+{
+    *pSemaphore = to_handle<VkSemaphore>(new StubObject());
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroySemaphore(VkDevice, VkSemaphore semaphore,
+    const VkAllocationCallbacks*)
+{
+    delete from_handle<StubObject>(semaphore);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateCommandPool(VkDevice, const VkCommandPoolCreateInfo*,
+    const VkAllocationCallbacks*, VkCommandPool* pPool)
+{
+    *pPool = to_handle<VkCommandPool>(new StubCommandPool());
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroyCommandPool(VkDevice, VkCommandPool pool,
+    const VkAllocationCallbacks*)
+{
+    StubCommandPool* p = from_handle<StubCommandPool>(pool);
+    if (!p) return;
+    for (StubCmd* c : p->cmds) delete c;
+    delete p;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_AllocateCommandBuffers(VkDevice,
+    const VkCommandBufferAllocateInfo* ai, VkCommandBuffer* pCmds)
+{
+    StubCommandPool* pool = from_handle<StubCommandPool>(ai->commandPool);
+    for (uint32_t i = 0; i < ai->commandBufferCount; i++) {
+        StubCmd* c = new StubCmd();
+        c->pool = pool;
+        pool->cmds.push_back(c);
+        pCmds[i] = to_handle<VkCommandBuffer>(c);
+    }
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_FreeCommandBuffers(VkDevice, VkCommandPool pool, uint32_t n,
+    const VkCommandBuffer* cmds)
+{
+    StubCommandPool* p = from_handle<StubCommandPool>(pool);
+    for (uint32_t i = 0; i < n; i++) {
+        StubCmd* c = from_handle<StubCmd>(cmds[i]);
+        if (!c) continue;
+        p->cmds.erase(std::remove(p->cmds.begin(), p->cmds.end(), c), p->cmds.end());
+        delete c;
+    }
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_BeginCommandBuffer(VkCommandBuffer cmd,
+    const VkCommandBufferBeginInfo*)
+{
+    StubCmd* c = from_handle<StubCmd>(cmd);
+    c->ops.clear();
+    c->session    = nullptr;
+    c->activePool = nullptr;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_EndCommandBuffer(VkCommandBuffer) { return VK_SUCCESS; }
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_ResetCommandBuffer(VkCommandBuffer cmd,
+    VkCommandBufferResetFlags)
+{
+    return stub_BeginCommandBuffer(cmd, nullptr);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_QueueSubmit(VkQueue, uint32_t n, const VkSubmitInfo* si,
+    VkFence)
+{
+    for (uint32_t s = 0; s < n; s++)
+        for (uint32_t i = 0; i < si[s].commandBufferCount; i++)
+            for (auto& op : from_handle<StubCmd>(si[s].pCommandBuffers[i])->ops) op();
+    return VK_SUCCESS;
+}
+
+// ============================================================================
+// Queries: timestamps и encode feedback
+// ============================================================================
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateQueryPool(VkDevice, const VkQueryPoolCreateInfo* ci,
+    const VkAllocationCallbacks*, VkQueryPool* pPool)
+{
+    StubQueryPool* pool = new StubQueryPool();
+    pool->type = ci->queryType;
+    pool->slots.resize(ci->queryCount);
+    for (auto* p = static_cast<const VkBaseInStructure*>(ci->pNext); p; p = p->pNext) {
+        if (p->sType == VK_STRUCTURE_TYPE_QUERY_POOL_VIDEO_ENCODE_FEEDBACK_CREATE_INFO_KHR)
+            pool->feedbackFlags =
+                reinterpret_cast<const VkQueryPoolVideoEncodeFeedbackCreateInfoKHR*>(p)
+                    ->encodeFeedbackFlags;
+    }
+    *pPool = to_handle<VkQueryPool>(pool);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroyQueryPool(VkDevice, VkQueryPool pool,
+    const VkAllocationCallbacks*)
+{
+    delete from_handle<StubQueryPool>(pool);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_GetQueryPoolResults(VkDevice, VkQueryPool queryPool,
+    uint32_t first, uint32_t count, size_t dataSize, void* pData, VkDeviceSize stride,
+    VkQueryResultFlags flags)
+{
+    const StubQueryPool* pool = from_handle<StubQueryPool>(queryPool);
+    const bool is64 = (flags & VK_QUERY_RESULT_64_BIT) != 0;
+    VkResult res = VK_SUCCESS;
+    for (uint32_t q = 0; q < count && first + q < pool->slots.size(); q++) {
+        const StubQuerySlot& s = pool->slots[first + q];
+        std::vector<uint64_t> vals;
+        if (pool->type == VK_QUERY_TYPE_VIDEO_ENCODE_FEEDBACK_KHR) {
+            if (pool->feedbackFlags & VK_VIDEO_ENCODE_FEEDBACK_BITSTREAM_BUFFER_OFFSET_BIT_KHR)
+                vals.push_back(s.offset);
+            if (pool->feedbackFlags & VK_VIDEO_ENCODE_FEEDBACK_BITSTREAM_BYTES_WRITTEN_BIT_KHR)
+                vals.push_back(s.bytes);
+            if (pool->feedbackFlags & VK_VIDEO_ENCODE_FEEDBACK_BITSTREAM_HAS_OVERRIDES_BIT_KHR)
+                vals.push_back(0);
+        } else {
+            vals.push_back(s.timestamp);
+        }
+        if (flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT)
+            vals.push_back(s.available ? 1 : 0);
+        if (flags & VK_QUERY_RESULT_WITH_STATUS_BIT_KHR)
+            vals.push_back(static_cast<uint64_t>(static_cast<int64_t>(
+                s.available ? VK_QUERY_RESULT_STATUS_COMPLETE_KHR
+                            : VK_QUERY_RESULT_STATUS_NOT_READY_KHR)));
+        if (!s.available) res = VK_NOT_READY;
+
+        uint8_t* dst = static_cast<uint8_t*>(pData) + q * stride;
+        const size_t w = is64 ? sizeof(uint64_t) : sizeof(uint32_t);
+        for (size_t v = 0; v < vals.size(); v++) {
+            if (q * stride + (v + 1) * w > dataSize) break;
+            if (is64) {
+                memcpy(dst + v * w, &vals[v], w);
+            } else {
+                const uint32_t x = static_cast<uint32_t>(vals[v]);
+                memcpy(dst + v * w, &x, w);
+            }
+        }
+    }
+    return res;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdResetQueryPool(VkCommandBuffer cmd, VkQueryPool queryPool,
+    uint32_t first, uint32_t count)
+{
+    StubQueryPool* pool = from_handle<StubQueryPool>(queryPool);
+    from_handle<StubCmd>(cmd)->ops.push_back([pool, first, count] {
+        for (uint32_t q = first; q < first + count && q < pool->slots.size(); q++)
+            pool->slots[q] = StubQuerySlot{};
+    });
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdBeginQuery(VkCommandBuffer cmd, VkQueryPool queryPool,
+    uint32_t query, VkQueryControlFlags)
+{
+    StubCmd* c = from_handle<StubCmd>(cmd);
+    c->activePool  = from_handle<StubQueryPool>(queryPool);
+    c->activeQuery = query;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdEndQuery(VkCommandBuffer cmd, VkQueryPool, uint32_t)
+{
+    from_handle<StubCmd>(cmd)->activePool = nullptr;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdWriteTimestamp(VkCommandBuffer cmd, VkPipelineStageFlagBits,
+    VkQueryPool queryPool, uint32_t query)
+{
+    StubQueryPool* pool = from_handle<StubQueryPool>(queryPool);
+    from_handle<StubCmd>(cmd)->ops.push_back([pool, query] {
+        if (query >= pool->slots.size()) return;
+        pool->slots[query].timestamp = now_ns();
+        pool->slots[query].available = true;
+    });
+}
+
+// ============================================================================
+// Transfer commands: реальные memcpy (это и есть host-side стоимость upload)
+// ============================================================================
+VKAPI_ATTR void VKAPI_CALL stub_CmdCopyBuffer(VkCommandBuffer cmd, VkBuffer src, VkBuffer dst,
+    uint32_t n, const VkBufferCopy* regions)
+{
+    const StubBuffer* s = from_handle<StubBuffer>(src);
+    const StubBuffer* d = from_handle<StubBuffer>(dst);
+    std::vector<VkBufferCopy> r(regions, regions + n);
+    from_handle<StubCmd>(cmd)->ops.push_back([s, d, r] {
+        for (const auto& c : r) {
+            if (c.srcOffset + c.size > s->size || c.dstOffset + c.size > d->size) continue;
+            memcpy(d->ptr() + c.dstOffset, s->ptr() + c.srcOffset, static_cast<size_t>(c.size));
+        }
+    });
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdCopyBufferToImage(VkCommandBuffer cmd, VkBuffer src,
+    VkImage dst, VkImageLayout, uint32_t n, const VkBufferImageCopy* regions)
+{
+    const StubBuffer* s = from_handle<StubBuffer>(src);
+    const StubImage*  d = from_handle<StubImage>(dst);
+    std::vector<VkBufferImageCopy> r(regions, regions + n);
+    from_handle<StubCmd>(cmd)->ops.push_back([s, d, r] {
+        const VkDeviceSize pitch = d->width;   // Y: 1 байт × w, UV: 2 байта × w/2
+        for (const auto& c : r) {
+            const bool chroma = c.imageSubresource.aspectMask == VK_IMAGE_ASPECT_PLANE_1_BIT;
+            const VkDeviceSize texel = chroma ? 2 : 1;
+            const VkDeviceSize base  = chroma ? VkDeviceSize(d->width) * d->height : 0;
+            const VkDeviceSize rowLen = c.bufferRowLength ? c.bufferRowLength : c.imageExtent.width;
+            const VkDeviceSize rowBytes = VkDeviceSize(c.imageExtent.width) * texel;
+            for (uint32_t y = 0; y < c.imageExtent.height; y++) {
+                const VkDeviceSize so = c.bufferOffset + y * rowLen * texel;
+                const VkDeviceSize dof = base + (c.imageOffset.y + y) * pitch +
+                                         c.imageOffset.x * texel;
+                if (so + rowBytes > s->size || dof + rowBytes > d->size) break;
+                memcpy(d->ptr() + dof, s->ptr() + so, static_cast<size_t>(rowBytes));
+            }
+        }
+    });
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdPipelineBarrier(VkCommandBuffer, VkPipelineStageFlags,
+    VkPipelineStageFlags, VkDependencyFlags, uint32_t, const VkMemoryBarrier*, uint32_t,
+    const VkBufferMemoryBarrier*, uint32_t, const VkImageMemoryBarrier*) {}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdPipelineBarrier2(VkCommandBuffer, const VkDependencyInfo*) {}
+
+// ============================================================================
+// Compute: stub-очередь без COMPUTE, сюда не доходит (Av1rGpuConverter → CPU)
+// ============================================================================
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateShaderModule(VkDevice, const VkShaderModuleCreateInfo*,
+    const VkAllocationCallbacks*, VkShaderModule*) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+VKAPI_ATTR void VKAPI_CALL stub_DestroyShaderModule(VkDevice, VkShaderModule,
+    const VkAllocationCallbacks*) {}
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateDescriptorSetLayout(VkDevice,
+    const VkDescriptorSetLayoutCreateInfo*, const VkAllocationCallbacks*,
+    VkDescriptorSetLayout*) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+VKAPI_ATTR void VKAPI_CALL stub_DestroyDescriptorSetLayout(VkDevice, VkDescriptorSetLayout,
+    const VkAllocationCallbacks*) {}
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreatePipelineLayout(VkDevice,
+    const VkPipelineLayoutCreateInfo*, const VkAllocationCallbacks*,
+    VkPipelineLayout*) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+VKAPI_ATTR void VKAPI_CALL stub_DestroyPipelineLayout(VkDevice, VkPipelineLayout,
+    const VkAllocationCallbacks*) {}
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateComputePipelines(VkDevice, VkPipelineCache, uint32_t,
+    const VkComputePipelineCreateInfo*, const VkAllocationCallbacks*,
+    VkPipeline*) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+VKAPI_ATTR void VKAPI_CALL stub_DestroyPipeline(VkDevice, VkPipeline,
+    const VkAllocationCallbacks*) {}
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateDescriptorPool(VkDevice,
+    const VkDescriptorPoolCreateInfo*, const VkAllocationCallbacks*,
+    VkDescriptorPool*) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+VKAPI_ATTR void VKAPI_CALL stub_DestroyDescriptorPool(VkDevice, VkDescriptorPool,
+    const VkAllocationCallbacks*) {}
+VKAPI_ATTR VkResult VKAPI_CALL stub_AllocateDescriptorSets(VkDevice,
+    const VkDescriptorSetAllocateInfo*, VkDescriptorSet*) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+VKAPI_ATTR void VKAPI_CALL stub_UpdateDescriptorSets(VkDevice, uint32_t,
+    const VkWriteDescriptorSet*, uint32_t, const VkCopyDescriptorSet*) {}
+VKAPI_ATTR void VKAPI_CALL stub_CmdBindPipeline(VkCommandBuffer, VkPipelineBindPoint,
+    VkPipeline) {}
+VKAPI_ATTR void VKAPI_CALL stub_CmdBindDescriptorSets(VkCommandBuffer, VkPipelineBindPoint,
+    VkPipelineLayout, uint32_t, uint32_t, const VkDescriptorSet*, uint32_t, const uint32_t*) {}
+VKAPI_ATTR void VKAPI_CALL stub_CmdPushConstants(VkCommandBuffer, VkPipelineLayout,
+    VkShaderStageFlags, uint32_t, uint32_t, const void*) {}
+VKAPI_ATTR void VKAPI_CALL stub_CmdDispatch(VkCommandBuffer, uint32_t, uint32_t, uint32_t) {}
+
+// ============================================================================
+// AV1 bitstream: sequence header OBU (AV1 spec 5.5) и фейковые кадры
+// ============================================================================
+struct BitWriter {
+    std::vector<uint8_t> out;
+    uint32_t nbits = 0;
+    void put(uint32_t v, uint32_t n) {
+        for (uint32_t i = n; i-- > 0; ) {
+            if (nbits % 8 == 0) out.push_back(0);
+            if ((v >> i) & 1u) out.back() |= static_cast<uint8_t>(0x80u >> (nbits % 8));
+            nbits++;
+        }
+    }
+    void trailing() {           // trailing_one_bit + zero bits до границы байта
+        put(1, 1);
+        while (nbits % 8) put(0, 1);
+    }
+};
+
+void put_leb128(std::vector<uint8_t>& out, uint64_t v)
+{
+    do {
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        out.push_back(v ? (b | 0x80) : b);
+    } while (v);
+}
+
+// OBU с obu_has_size_field = 1
+void put_obu(std::vector<uint8_t>& out, uint8_t type, const std::vector<uint8_t>& payload)
+{
+    out.push_back(static_cast<uint8_t>((type << 3) | 0x02));
+    put_leb128(out, payload.size());
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+const uint8_t OBU_SEQUENCE_HEADER = 1;
+const uint8_t OBU_METADATA        = 5;
+
+// Main profile, 8-bit 4:2:0, одна operating point; поля, которые задаёт
+// createVideoSessionParameters, берутся из StdVideoAV1SequenceHeader
+std::vector<uint8_t> sequence_header_obu(const StdVideoAV1SequenceHeader& sh)
+{
+    const uint32_t w = sh.max_frame_width_minus_1 + 1u;
+    const uint32_t h = sh.max_frame_height_minus_1 + 1u;
+    const uint32_t level = w * h <= 2048u * 1152u ? STD_VIDEO_AV1_LEVEL_4_0
+                         : w * h <= 4096u * 2176u ? STD_VIDEO_AV1_LEVEL_5_0
+                         : STD_VIDEO_AV1_LEVEL_6_0;
+    const uint32_t wbits = sh.frame_width_bits_minus_1 + 1u;
+    const uint32_t hbits = sh.frame_height_bits_minus_1 + 1u;
+
+    BitWriter bw;
+    bw.put(0, 3);                  // seq_profile (Main)
+    bw.put(0, 1);                  // still_picture
+    bw.put(0, 1);                  // reduced_still_picture_header
+    bw.put(0, 1);                  // timing_info_present_flag
+    bw.put(0, 1);                  // initial_display_delay_present_flag
+    bw.put(0, 5);                  // operating_points_cnt_minus_1
+    bw.put(0, 12);                 // operating_point_idc[0]
+    bw.put(level, 5);              // seq_level_idx[0]
+    if (level > 7) bw.put(0, 1);   // seq_tier[0]
+    bw.put(wbits - 1, 4);
+    bw.put(hbits - 1, 4);
+    bw.put(w - 1, wbits);
+    bw.put(h - 1, hbits);
+    bw.put(0, 1);                  // frame_id_numbers_present_flag
+    bw.put(0, 1);                  // use_128x128_superblock
+    bw.put(0, 1);                  // enable_filter_intra
+    bw.put(0, 1);                  // enable_intra_edge_filter
+    bw.put(0, 1);                  // enable_interintra_compound
+    bw.put(0, 1);                  // enable_masked_compound
+    bw.put(0, 1);                  // enable_warped_motion
+    bw.put(0, 1);                  // enable_dual_filter
+    bw.put(sh.flags.enable_order_hint ? 1 : 0, 1);
+    if (sh.flags.enable_order_hint) {
+        bw.put(0, 1);              // enable_jnt_comp
+        bw.put(0, 1);              // enable_ref_frame_mvs
+    }
+    bw.put(0, 1);                  // seq_choose_screen_content_tools
+    bw.put(0, 1);                  // seq_force_screen_content_tools = 0
+    if (sh.flags.enable_order_hint)
+        bw.put(sh.order_hint_bits_minus_1, 3);
+    bw.put(0, 1);                  // enable_superres
+    bw.put(sh.flags.enable_cdef ? 1 : 0, 1);
+    bw.put(0, 1);                  // enable_restoration
+    // color_config: 8-bit, 4:2:0, BT.709 limited range
+    bw.put(0, 1);                  // high_bitdepth
+    bw.put(0, 1);                  // mono_chrome
+    bw.put(1, 1);                  // color_description_present_flag
+    bw.put(1, 8);                  // color_primaries = BT.709
+    bw.put(1, 8);                  // transfer_characteristics = BT.709
+    bw.put(1, 8);                  // matrix_coefficients = BT.709
+    bw.put(0, 1);                  // color_range (limited)
+    bw.put(0, 2);                  // chroma_sample_position = unknown
+    bw.put(0, 1);                  // separate_uv_delta_q
+    bw.put(0, 1);                  // film_grain_params_present
+    bw.trailing();
+
+    std::vector<uint8_t> obu;
+    put_obu(obu, OBU_SEQUENCE_HEADER, bw.out);
+    return obu;
+}
+
+// Фейковый кадр: metadata OBU, metadata_type 31 (unregistered user private) —
+// декодеры его пропускают, remux сохраняет. Размер ~ bpp как у реального
+// encoder на средних CRF: keyframe w*h/16 байт, inter в 8 раз меньше.
+// Содержимое детерминировано: "AV1R", номер кадра, key flag, LCG.
+std::vector<uint8_t> fake_frame_obu(uint32_t w, uint32_t h, uint32_t frame, bool key)
+{
+    size_t n = static_cast<size_t>(w) * h / 16;
+    if (!key) n /= 8;
+    n = std::max<size_t>(n, 16);
+
+    std::vector<uint8_t> payload;
+    payload.reserve(n + 2);
+    payload.push_back(31);                              // metadata_type (leb128)
+    const uint8_t tag[] = { 'A', 'V', '1', 'R',
+                            static_cast<uint8_t>(frame >> 24), static_cast<uint8_t>(frame >> 16),
+                            static_cast<uint8_t>(frame >> 8),  static_cast<uint8_t>(frame),
+                            static_cast<uint8_t>(key ? 1 : 0) };
+    payload.insert(payload.end(), tag, tag + sizeof(tag));
+    uint32_t x = 2463534242u ^ frame;
+    while (payload.size() < n) {
+        x = x * 1664525u + 1013904223u;
+        payload.push_back(static_cast<uint8_t>(x >> 24));
+    }
+    payload.push_back(0x80);                            // trailing_bits
+
+    std::vector<uint8_t> obu;
+    put_obu(obu, OBU_METADATA, payload);
+    return obu;
+}
+
+// ============================================================================
+// Vulkan Video KHR
+// ============================================================================
+VKAPI_ATTR VkResult VKAPI_CALL stub_GetPhysDevVideoCapabilities(VkPhysicalDevice,
+    const VkVideoProfileInfoKHR* profile, VkVideoCapabilitiesKHR* caps)
+{
+    if (profile->videoCodecOperation != VK_VIDEO_CODEC_OPERATION_ENCODE_AV1_BIT_KHR)
+        return VK_ERROR_VIDEO_PROFILE_OPERATION_NOT_SUPPORTED_KHR;
+
+    caps->flags                             = 0;
+    caps->minBitstreamBufferOffsetAlignment = 1;
+    caps->minBitstreamBufferSizeAlignment   = 1;
+    caps->pictureAccessGranularity          = {16, 16};
+    caps->minCodedExtent                    = {16, 16};
+    caps->maxCodedExtent                    = {8192, 4352};
+    caps->maxDpbSlots                       = 8;
+    caps->maxActiveReferencePictures        = 7;
+    strncpy(caps->stdHeaderVersion.extensionName,
+            VK_STD_VULKAN_VIDEO_CODEC_AV1_ENCODE_EXTENSION_NAME, VK_MAX_EXTENSION_NAME_SIZE - 1);
+    caps->stdHeaderVersion.specVersion = VK_STD_VULKAN_VIDEO_CODEC_AV1_ENCODE_SPEC_VERSION;
+
+    for (auto* p = static_cast<VkBaseOutStructure*>(caps->pNext); p; p = p->pNext) {
+        if (p->sType == VK_STRUCTURE_TYPE_VIDEO_ENCODE_CAPABILITIES_KHR) {
+            auto* ec = reinterpret_cast<VkVideoEncodeCapabilitiesKHR*>(p);
+            ec->flags                = 0;
+            ec->rateControlModes     = VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR |
+                                       VK_VIDEO_ENCODE_RATE_CONTROL_MODE_CBR_BIT_KHR |
+                                       VK_VIDEO_ENCODE_RATE_CONTROL_MODE_VBR_BIT_KHR;
+            ec->maxRateControlLayers = 1;
+            ec->maxBitrate           = 200000000;
+            ec->maxQualityLevels     = 4;
+            ec->encodeInputPictureGranularity = {16, 16};
+            ec->supportedEncodeFeedbackFlags  =
+                VK_VIDEO_ENCODE_FEEDBACK_BITSTREAM_BUFFER_OFFSET_BIT_KHR |
+                VK_VIDEO_ENCODE_FEEDBACK_BITSTREAM_BYTES_WRITTEN_BIT_KHR;
+        } else if (p->sType == VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_CAPABILITIES_KHR) {
+            auto* ac = reinterpret_cast<VkVideoEncodeAV1CapabilitiesKHR*>(p);
+            ac->maxLevel                = STD_VIDEO_AV1_LEVEL_6_0;
+            ac->codedPictureAlignment   = {8, 8};
+            ac->maxTiles                = {64, 64};
+            ac->minTileSize             = {64, 64};
+            ac->maxTileSize             = {4096, 4096};
+            ac->superblockSizes         = VK_VIDEO_ENCODE_AV1_SUPERBLOCK_SIZE_64_BIT_KHR;
+            ac->maxSingleReferenceCount = 1;
+            ac->singleReferenceNameMask = 0x7F;
+            ac->maxTemporalLayerCount   = 1;
+            ac->maxSpatialLayerCount    = 1;
+            ac->maxOperatingPoints      = 1;
+            ac->minQIndex               = 0;
+            ac->maxQIndex               = 255;
+        }
+    }
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_GetPhysDevVideoFormatProperties(VkPhysicalDevice,
+    const VkPhysicalDeviceVideoFormatInfoKHR* info, uint32_t* count,
+    VkVideoFormatPropertiesKHR* props)
+{
+    if (!props) { *count = 1; return VK_SUCCESS; }
+    if (*count < 1) return VK_INCOMPLETE;
+    void* next = props[0].pNext;
+    props[0] = VkVideoFormatPropertiesKHR{};
+    props[0].sType           = VK_STRUCTURE_TYPE_VIDEO_FORMAT_PROPERTIES_KHR;
+    props[0].pNext           = next;
+    props[0].format          = VK_FORMAT_G8_B8R8_2PLANE_420_UNORM;
+    props[0].imageType       = VK_IMAGE_TYPE_2D;
+    props[0].imageTiling     = VK_IMAGE_TILING_OPTIMAL;
+    props[0].imageUsageFlags = info->imageUsage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    *count = 1;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_GetPhysDevEncodeQualityLevelProperties(VkPhysicalDevice,
+    const VkPhysicalDeviceVideoEncodeQualityLevelInfoKHR* info,
+    VkVideoEncodeQualityLevelPropertiesKHR* props)
+{
+    if (info->qualityLevel >= 4) return VK_ERROR_VIDEO_PROFILE_OPERATION_NOT_SUPPORTED_KHR;
+    props->preferredRateControlMode       = VK_VIDEO_ENCODE_RATE_CONTROL_MODE_DISABLED_BIT_KHR;
+    props->preferredRateControlLayerCount = 0;
+    for (auto* p = static_cast<VkBaseOutStructure*>(props->pNext); p; p = p->pNext) {
+        if (p->sType != VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_QUALITY_LEVEL_PROPERTIES_KHR) continue;
+        auto* ap = reinterpret_cast<VkVideoEncodeAV1QualityLevelPropertiesKHR*>(p);
+        ap->preferredRateControlFlags        = VK_VIDEO_ENCODE_AV1_RATE_CONTROL_REGULAR_GOP_BIT_KHR;
+        ap->preferredGopFrameCount           = 64;
+        ap->preferredKeyFramePeriod          = 256;
+        ap->preferredTemporalLayerCount      = 1;
+        ap->preferredMaxSingleReferenceCount = 1;
+        ap->preferredSingleReferenceNameMask = 0x01;   // LAST_FRAME
+    }
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateVideoSession(VkDevice,
+    const VkVideoSessionCreateInfoKHR* ci, const VkAllocationCallbacks*,
+    VkVideoSessionKHR* pSession)
+{
+    StubSession* s = new StubSession();
+    s->width  = ci->maxCodedExtent.width;
+    s->height = ci->maxCodedExtent.height;
+    *pSession = to_handle<VkVideoSessionKHR>(s);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroyVideoSession(VkDevice, VkVideoSessionKHR session,
+    const VkAllocationCallbacks*)
+{
+    delete from_handle<StubSession>(session);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_GetVideoSessionMemoryRequirements(VkDevice,
+    VkVideoSessionKHR, uint32_t* count, VkVideoSessionMemoryRequirementsKHR*)
+{
+    *count = 0;   // сессии память не нужна
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_BindVideoSessionMemory(VkDevice, VkVideoSessionKHR,
+    uint32_t, const VkBindVideoSessionMemoryInfoKHR*)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_CreateVideoSessionParameters(VkDevice,
+    const VkVideoSessionParametersCreateInfoKHR* ci, const VkAllocationCallbacks*,
+    VkVideoSessionParametersKHR* pParams)
+{
+    const StdVideoAV1SequenceHeader* sh = nullptr;
+    for (auto* p = static_cast<const VkBaseInStructure*>(ci->pNext); p; p = p->pNext) {
+        if (p->sType == VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_SESSION_PARAMETERS_CREATE_INFO_KHR)
+            sh = reinterpret_cast<const VkVideoEncodeAV1SessionParametersCreateInfoKHR*>(p)
+                     ->pStdSequenceHeader;
+    }
+    if (!sh) return VK_ERROR_INITIALIZATION_FAILED;
+
+    StubSessionParams* params = new StubSessionParams();
+    params->seqHeader = sequence_header_obu(*sh);
+    *pParams = to_handle<VkVideoSessionParametersKHR>(params);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_DestroyVideoSessionParameters(VkDevice,
+    VkVideoSessionParametersKHR params, const VkAllocationCallbacks*)
+{
+    delete from_handle<StubSessionParams>(params);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL stub_GetEncodedSessionParams(VkDevice,
+    const VkVideoEncodeSessionParametersGetInfoKHR* info,
+    VkVideoEncodeSessionParametersFeedbackInfoKHR* feedback, size_t* pSize, void* pData)
+{
+    const auto& hdr = from_handle<StubSessionParams>(info->videoSessionParameters)->seqHeader;
+    if (feedback) feedback->hasOverrides = VK_FALSE;
+    if (!pData) { *pSize = hdr.size(); return VK_SUCCESS; }
+    const size_t n = std::min(*pSize, hdr.size());
+    memcpy(pData, hdr.data(), n);
+    *pSize = n;
+    return n < hdr.size() ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdBeginVideoCoding(VkCommandBuffer cmd,
+    const VkVideoBeginCodingInfoKHR* info)
+{
+    from_handle<StubCmd>(cmd)->session = from_handle<StubSession>(info->videoSession);
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdEndVideoCoding(VkCommandBuffer cmd,
+    const VkVideoEndCodingInfoKHR*)
+{
+    from_handle<StubCmd>(cmd)->session = nullptr;
+}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdControlVideoCoding(VkCommandBuffer,
+    const VkVideoCodingControlInfoKHR*) {}
+
+VKAPI_ATTR void VKAPI_CALL stub_CmdEncodeVideo(VkCommandBuffer cmd,
+    const VkVideoEncodeInfoKHR* info)
+{
+    StubCmd* c = from_handle<StubCmd>(cmd);
+    bool key = false;
+    for (auto* p = static_cast<const VkBaseInStructure*>(info->pNext); p; p = p->pNext) {
+        if (p->sType == VK_STRUCTURE_TYPE_VIDEO_ENCODE_AV1_PICTURE_INFO_KHR) {
+            const auto* pic = reinterpret_cast<const VkVideoEncodeAV1PictureInfoKHR*>(p);
+            key = pic->pStdPictureInfo &&
+                  pic->pStdPictureInfo->frame_type == STD_VIDEO_AV1_FRAME_TYPE_KEY;
+        }
+    }
+    StubSession*   session = c->session;
+    StubQueryPool* pool    = c->activePool;
+    const uint32_t query   = c->activeQuery;
+    const StubBuffer* dst  = from_handle<StubBuffer>(info->dstBuffer);
+    const VkDeviceSize offset = info->dstBufferOffset;
+    const VkDeviceSize range  = info->dstBufferRange;
+    c->ops.push_back([session, pool, query, dst, offset, range, key] {
+        if (!session) return;
+        const std::vector<uint8_t> obu =
+            fake_frame_obu(session->width, session->height, session->frames++, key);
+        const size_t n = static_cast<size_t>(std::min<VkDeviceSize>(
+            obu.size(), std::min(range, dst->size > offset ? dst->size - offset : 0)));
+        memcpy(dst->ptr() + offset, obu.data(), n);
+        if (pool && query < pool->slots.size()) {
+            pool->slots[query].offset    = 0;   // относительно dstBufferOffset
+            pool->slots[query].bytes     = static_cast<uint32_t>(n);
+            pool->slots[query].available = true;
+        }
+    });
+}
+
+// ============================================================================
+// vkGet*ProcAddr: только функции Vulkan Video (core вызывается через таблицу)
+// ============================================================================
+struct StubProc {
+    const char*        name;
+    PFN_vkVoidFunction fn;
+};
+
+#define AV1R_STUB_PROC(vkname, fn) { vkname, reinterpret_cast<PFN_vkVoidFunction>(&fn) }
+
+PFN_vkVoidFunction stub_proc_addr(const char* name)
+{
+    static const StubProc procs[] = {
+        AV1R_STUB_PROC("vkGetPhysicalDeviceVideoCapabilitiesKHR",     stub_GetPhysDevVideoCapabilities),
+        AV1R_STUB_PROC("vkGetPhysicalDeviceVideoFormatPropertiesKHR", stub_GetPhysDevVideoFormatProperties),
+        AV1R_STUB_PROC("vkGetPhysicalDeviceVideoEncodeQualityLevelPropertiesKHR",
+                       stub_GetPhysDevEncodeQualityLevelProperties),
+        AV1R_STUB_PROC("vkCreateVideoSessionKHR",               stub_CreateVideoSession),
+        AV1R_STUB_PROC("vkDestroyVideoSessionKHR",              stub_DestroyVideoSession),
+        AV1R_STUB_PROC("vkGetVideoSessionMemoryRequirementsKHR", stub_GetVideoSessionMemoryRequirements),
+        AV1R_STUB_PROC("vkBindVideoSessionMemoryKHR",           stub_BindVideoSessionMemory),
+        AV1R_STUB_PROC("vkCreateVideoSessionParametersKHR",     stub_CreateVideoSessionParameters),
+        AV1R_STUB_PROC("vkDestroyVideoSessionParametersKHR",    stub_DestroyVideoSessionParameters),
+        AV1R_STUB_PROC("vkCmdBeginVideoCodingKHR",              stub_CmdBeginVideoCoding),
+        AV1R_STUB_PROC("vkCmdEndVideoCodingKHR",                stub_CmdEndVideoCoding),
+        AV1R_STUB_PROC("vkCmdControlVideoCodingKHR",            stub_CmdControlVideoCoding),
+        AV1R_STUB_PROC("vkCmdEncodeVideoKHR",                   stub_CmdEncodeVideo),
+        AV1R_STUB_PROC("vkGetEncodedVideoSessionParametersKHR", stub_GetEncodedSessionParams),
+    };
+    for (const auto& p : procs)
+        if (strcmp(p.name, name) == 0) return p.fn;
+    return nullptr;
+}
+
+#undef AV1R_STUB_PROC
+
+// Flush и Invalidate — одна no-op реализация
+#define stub_FlushMappedMemoryRanges      stub_MappedMemoryRanges
+#define stub_InvalidateMappedMemoryRanges stub_MappedMemoryRanges
+
+#define AV1R_VK_LOADER_ENTRY(name) &::vk##name,
+#define AV1R_VK_STUB_ENTRY(name)   &stub_##name,
+
+const Av1rVkCoreFuncs g_loader_funcs = { AV1R_VK_CORE_FUNCS(AV1R_VK_LOADER_ENTRY) };
+const Av1rVkCoreFuncs g_stub_funcs   = { AV1R_VK_CORE_FUNCS(AV1R_VK_STUB_ENTRY) };
+
+#undef AV1R_VK_LOADER_ENTRY
+#undef AV1R_VK_STUB_ENTRY
+
+} // namespace
+
+const Av1rVkCoreFuncs* av1r_vk_core_table = &g_loader_funcs;
+
+void av1r_vk_select_driver()
+{
+    const char* v = std::getenv("AV1R_VULKAN_STUB");
+    const bool stub = v && *v && strcmp(v, "0") != 0;
+    av1r_vk_core_table = stub ? &g_stub_funcs : &g_loader_funcs;
+}
+
+bool av1r_vk_stub_active()
+{
+    return av1r_vk_core_table == &g_stub_funcs;
+}
+
+#endif // AV1R_USE_VULKAN
@@ -7,6 +7,7 @@
 
 #include <vulkan/vulkan.h>
 #include "vk_video/vulkan_video_encode_av1_khr.h"
+#include "av1r_vk_dispatch.h"
 #include <stdexcept>
 #include <string>
 
@@ -35,6 +36,9 @@ using PFN_vkCmdControlVideoCodingKHR =
     void (VKAPI_PTR *)(VkCommandBuffer, const VkVideoCodingControlInfoKHR*);
 using PFN_vkCmdEncodeVideoKHR =
     void (VKAPI_PTR *)(VkCommandBuffer, const VkVideoEncodeInfoKHR*);
+using PFN_vkGetPhysicalDeviceVideoEncodeQualityLevelPropertiesKHR =
+    VkResult (VKAPI_PTR *)(VkPhysicalDevice, const VkPhysicalDeviceVideoEncodeQualityLevelInfoKHR*,
+                            VkVideoEncodeQualityLevelPropertiesKHR*);
 using PFN_vkGetEncodedVideoSessionParametersKHR =
     VkResult (VKAPI_PTR *)(VkDevice, const VkVideoEncodeSessionParametersGetInfoKHR*,
                             VkVideoEncodeSessionParametersFeedbackInfoKHR*, size_t*, void*);
@@ -43,6 +47,7 @@ using PFN_vkGetEncodedVideoSessionParametersKHR =
 struct Av1rVkVideoFuncs {
     PFN_vkGetPhysicalDeviceVideoCapabilitiesKHR      GetPhysDevVideoCapabilities;
     PFN_vkGetPhysicalDeviceVideoFormatPropertiesKHR  GetPhysDevVideoFormatProperties;
+    PFN_vkGetPhysicalDeviceVideoEncodeQualityLevelPropertiesKHR GetPhysDevEncodeQualityLevelProperties;
     PFN_vkCreateVideoSessionKHR                      CreateVideoSession;
     PFN_vkDestroyVideoSessionKHR                     DestroyVideoSession;
     PFN_vkGetVideoSessionMemoryRequirementsKHR       GetVideoSessionMemoryRequirements;
@@ -55,6 +60,7 @@ struct Av1rVkVideoFuncs {
     PFN_vkCmdEncodeVideoKHR                          CmdEncodeVideo;
     PFN_vkGetEncodedVideoSessionParametersKHR        GetEncodedSessionParams;
     bool loaded = false;
+    bool stub   = false;   // loaded from the stub driver (AV1R_VULKAN_STUB)
 };
 
 inline Av1rVkVideoFuncs& av1r_vk_video_funcs() {
@@ -64,7 +70,7 @@ inline Av1rVkVideoFuncs& av1r_vk_video_funcs() {
 
 inline void av1r_load_vk_video_funcs(VkInstance instance, VkDevice device) {
     auto& f = av1r_vk_video_funcs();
-    if (f.loaded) return;
+    if (f.loaded && f.stub == av1r_vk_stub_active()) return;
 
     auto getI = [&](const char* name) -> PFN_vkVoidFunction {
         auto p = vkGetInstanceProcAddr(instance, name);
@@ -80,6 +86,8 @@ inline void av1r_load_vk_video_funcs(VkInstance instance, VkDevice device) {
     // Instance-level
     f.GetPhysDevVideoCapabilities     = (PFN_vkGetPhysicalDeviceVideoCapabilitiesKHR)     getI("vkGetPhysicalDeviceVideoCapabilitiesKHR");
     f.GetPhysDevVideoFormatProperties = (PFN_vkGetPhysicalDeviceVideoFormatPropertiesKHR) getI("vkGetPhysicalDeviceVideoFormatPropertiesKHR");
+    f.GetPhysDevEncodeQualityLevelProperties = (PFN_vkGetPhysicalDeviceVideoEncodeQualityLevelPropertiesKHR)
+        getI("vkGetPhysicalDeviceVideoEncodeQualityLevelPropertiesKHR");
 
     // Device-level
     f.CreateVideoSession              = (PFN_vkCreateVideoSessionKHR)              getD("vkCreateVideoSessionKHR");
@@ -94,6 +102,7 @@ inline void av1r_load_vk_video_funcs(VkInstance instance, VkDevice device) {
     f.CmdEncodeVideo                  = (PFN_vkCmdEncodeVideoKHR)                  getD("vkCmdEncodeVideoKHR");
     f.GetEncodedSessionParams         = (PFN_vkGetEncodedVideoSessionParametersKHR) getD("vkGetEncodedVideoSessionParametersKHR");
 
+    f.stub   = av1r_vk_stub_active();
     f.loaded = true;
 }
 
@@ -3,6 +3,8 @@
 #ifdef AV1R_USE_VULKAN
 
 #include <vulkan/vulkan.h>
+#include "av1r_vk_dispatch.h"
+#include "av1r_memstats.h"
 #include <cstdint>
 #include <cstddef>
 #include <vector>
@@ -19,6 +21,7 @@ struct Av1rBuffer {
     void*               ptr            = nullptr;  // mapped address (host-visible only)
     size_t              size           = 0;
     VkDevice            device         = VK_NULL_HANDLE;
+    Av1rMemCharge       mem;           // device memory accounting (av1r_memstats.h)
 };
 
 struct Av1rSemaphore {
@@ -32,6 +35,33 @@ struct Av1rQueue {
     VkCommandPool cmd_pool          = VK_NULL_HANDLE;
 };
 
+// Возможности AV1 encode профиля (реестр capabilities, см. av1r_vulkan_caps)
+struct Av1rVulkanCaps {
+    bool     valid         = false;   // AV1 encode profile query succeeded
+    char     deviceName[256] = {};
+    uint32_t vendorId      = 0;
+    uint32_t deviceId      = 0;
+    uint32_t driverVersion = 0;
+    uint32_t apiVersion    = 0;
+    uint32_t minWidth      = 0;
+    uint32_t minHeight     = 0;
+    uint32_t maxWidth      = 0;
+    uint32_t maxHeight     = 0;
+    uint32_t maxDpbSlots   = 0;
+    uint32_t maxActiveReferencePictures = 0;
+    uint32_t maxQualityLevels = 0;    // VkVideoEncodeCapabilitiesKHR::maxQualityLevels
+    VkFlags  rateControlModes = 0;    // VkVideoEncodeRateControlModeFlagsKHR
+    // VkVideoEncodeAV1CapabilitiesKHR tile limits (0 = not reported)
+    uint32_t maxTileCols   = 0;
+    uint32_t maxTileRows   = 0;
+    uint32_t minTileWidth  = 0;
+    uint32_t minTileHeight = 0;
+    uint32_t maxTileWidth  = 0;
+    uint32_t maxTileHeight = 0;
+    std::vector<VkFormat> srcFormats; // VIDEO_ENCODE_SRC usage
+    std::vector<VkFormat> dpbFormats; // VIDEO_ENCODE_DPB usage
+};
+
 // Основной контекст Vulkan для AV1R
 struct Av1rVulkanCtx {
     VkInstance       instance    = VK_NULL_HANDLE;
@@ -67,13 +97,16 @@ void             av1r_device_name(VkPhysicalDevice dev, char* buf, int buf_len);
 VkDevice av1r_create_logical_device(VkPhysicalDevice phys,
                                     uint32_t* encode_qfamily_out,
                                     uint32_t* transfer_qfamily_out = nullptr);
+VkDevice av1r_create_compute_device(VkPhysicalDevice phys, uint32_t* qfamily_out);
 void     av1r_destroy_logical_device(VkDevice device);
 
 // Buffer management (адаптировано из ggmlR строки 2402-2503)
+// mem_category: memory accounting category of the allocation
 Av1rBuffer av1r_buffer_create(VkPhysicalDevice phys, VkDevice device,
                                size_t size, VkBufferUsageFlags usage,
                                VkMemoryPropertyFlags req_flags,
-                               VkMemoryPropertyFlags fallback_flags = 0);
+                               VkMemoryPropertyFlags fallback_flags = 0,
+                               const char* mem_category = "buffer");
 void       av1r_buffer_destroy(VkDevice device, Av1rBuffer& buf);
 
 // Staging transfer CPU → GPU  (адаптировано из ggmlR строки 6129-6156)
@@ -86,6 +119,13 @@ void av1r_buffer_download(VkDevice device, VkCommandBuffer cmd,
                            Av1rBuffer& src, Av1rBuffer& staging,
                            size_t size);
 
+// ============================================================================
+// av1r_encode_vulkan.cpp
+// ============================================================================
+// Cached per process; refresh = true re-queries the driver
+const Av1rVulkanCaps& av1r_vulkan_caps(VkInstance instance, VkPhysicalDevice dev,
+                                        bool refresh = false);
+
 // ============================================================================
 // av1r_commands.cpp
 // ============================================================================